@@ -1,4 +1,4 @@
-#include "Sprite.h"
+#include "sprite.h"
 
 #include <algorithm>
 
@@ -11,14 +11,12 @@ using namespace std;
 void Sprite::load(const char* path, SDL_Renderer* render)
 {
 	this->path = path;
-	texture = IMG_LoadTexture(render, path);
 	renderer = render;
 
-	const int result = SDL_QueryTexture(texture, NULL, NULL, &spriteWidth, &spriteHeight);
-	if (result != 0)
-	{
-		cout << "Failed to load image at: " << path << endl;
-	}
+	// shared with every other sprite using the same image, see AssetCache
+	handle = AssetCache::acquireTexture(path);
+	texture = AssetCache::getTexture(handle);
+	AssetCache::getTextureSize(handle, spriteWidth, spriteHeight);
 }
 void Sprite::draw(int x, int y, int width, int height, SDL_Renderer* render)
 {
@@ -45,6 +43,8 @@ void Sprite::updateOpacity(float progress)
 
 void Sprite::destroy()
 {
-	SDL_DestroyTexture(texture);
+	AssetCache::releaseTexture(handle);
+	handle = AssetCache::INVALID_TEXTURE;
+	texture = nullptr;
 }
 //todo: destroy()
@@ -1,4 +1,5 @@
 #include "UI.h"
+#include <cmath>
 #include <iostream>
 #include <map>
 #include <SDL_image.h>
@@ -30,7 +31,7 @@ namespace UI
 #endif
 
 	// initializes the buttons needed for the specific menu
-	Buttons::Buttons(SDL_Renderer* render, Menu menu) : types{}, textures{}, rects{}
+	Buttons::Buttons(Menu menu) : types{}, textures{}, handles{}, rects{}
 	{
 		const std::initializer_list<Button> buttons = menuButtonMap.at(menu);
 		count = buttons.size();
@@ -39,16 +40,17 @@ namespace UI
 		{
 			types[i] = button;
 			rects[i] = buttonRectMap.at(button);
-			SDL_Texture* texture = IMG_LoadTexture(render, Assets::buttonPathMap.at(button));
-			TextureSize size{};
-			const int result = SDL_QueryTexture(texture, NULL, NULL, &size.width, &size.height);
-			if (result != 0)
+			const AssetCache::TextureHandle handle = AssetCache::acquireTexture(Assets::buttonPathMap.at(button));
+			if (handle == AssetCache::INVALID_TEXTURE)
 			{
-				std::cout << "Failed to load image at: " << Assets::buttonPathMap.at(button) << std::endl;
+				count = i;
 				return; // todo: throw exception
 			}
+			TextureSize size{};
+			AssetCache::getTextureSize(handle, size.width, size.height);
 
-			textures[i] = Texture(texture, size);
+			handles[i] = handle;
+			textures[i] = Texture(AssetCache::getTexture(handle), size);
 			i++;
 		}
 	}
@@ -81,10 +83,8 @@ namespace UI
 				opacityMultiplier = powf(opacityMultiplier, 2);
 			}
 
-			if (opacityMultiplier != -1)
-			{
-				SDL_SetTextureAlphaMod(textures[i].texture, static_cast<Uint8>(255 * opacityMultiplier));
-			}
+			// the texture is shared through AssetCache, its opacity is set for every draw
+			SDL_SetTextureAlphaMod(textures[i].texture, opacityMultiplier != -1 ? static_cast<Uint8>(255 * opacityMultiplier) : 255);
 			const int result = SDL_RenderCopy(render, textures[i].texture, &source, &destination); // source will be used to select which part of the texture to use
 
 			if (result != 0)
@@ -110,7 +110,7 @@ namespace UI
 	{
 		for (int i = 0; i < count; i++)
 		{
-			SDL_DestroyTexture(textures[i].texture);
+			AssetCache::releaseTexture(handles[i]);
 		}
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include <SDL.h>
+#include "assetCache.h"
 #define MAX_BUTTON_COUNT 2
 
 namespace UI
@@ -18,13 +19,15 @@ namespace UI
 	{
 		Button types[MAX_BUTTON_COUNT];
 		Texture textures[MAX_BUTTON_COUNT];
+		AssetCache::TextureHandle handles[MAX_BUTTON_COUNT];
 		SDL_Rect rects[MAX_BUTTON_COUNT];
 		size_t count;
 
-		Buttons(SDL_Renderer* render, Menu menu);
+		Buttons(Menu menu);
 		void draw(SDL_Renderer* render, int mouseX, int mouseY, Button clickedButton = Button::none, float opacityMultiplier = -1.f);
 		Button isIntersectingAnyButton(int mouseX, int mouseY);
 
+		// releases the button textures, they stay cached for the next time the menu opens
 		void unloadTextures();
 
 		// Atm, each menu only have one specific button (+ quit) but I made this for the sake of modularity 
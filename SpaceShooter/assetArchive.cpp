@@ -0,0 +1,344 @@
+#include "assetArchive.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <SDL_image.h>
+#include "musicManager.h"
+
+namespace AssetArchive
+{
+	constexpr char MAGIC[4] = { 'S', 'S', 'P', 'K' };
+	constexpr Uint32 VERSION = 1;
+	constexpr size_t BLOB_ALIGNMENT = 64;
+	constexpr size_t MAX_PATH_LENGTH = 112;
+
+	enum class BlobFormat : Uint32 { File, RGBA32, PCM };
+
+	struct Header
+	{
+		char magic[4];
+		Uint32 version;
+		Uint32 entryCount;
+		Uint32 padding;
+	};
+
+	struct Entry
+	{
+		char path[MAX_PATH_LENGTH];
+		Uint64 offset; // from the start of the archive
+		Uint64 size;
+		BlobFormat format;
+		Uint32 width; // only used by RGBA32
+		Uint32 height;
+		Uint32 padding;
+	};
+
+	// the mapped archive, read only after open() so several loader threads can use it
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int file = -1;
+#endif
+	const Uint8* view = nullptr;
+	Uint64 viewSize = 0;
+	std::unordered_map<std::string, const Entry*> entryByPath;
+
+#pragma region PACKING
+
+	size_t alignUp(size_t value)
+	{
+		return (value + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+	}
+
+	bool readFile(const char* path, std::vector<Uint8>& data)
+	{
+		std::ifstream input(path, std::ios::binary | std::ios::ate);
+		if (!input) return false;
+
+		data.resize(static_cast<size_t>(input.tellg()));
+		input.seekg(0);
+		input.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		return static_cast<bool>(input);
+	}
+
+	// Decodes the image into tightly packed RGBA32 rows
+	bool decodeImage(const char* path, std::vector<Uint8>& data, Entry& entry)
+	{
+		SDL_Surface* loaded = IMG_Load(path);
+		if (loaded == nullptr) return false;
+		SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(loaded);
+		if (surface == nullptr) return false;
+
+		const size_t rowSize = static_cast<size_t>(surface->w) * 4;
+		data.resize(rowSize * surface->h);
+		SDL_LockSurface(surface);
+		for (int y = 0; y < surface->h; y++)
+		{
+			memcpy(data.data() + rowSize * y, static_cast<const Uint8*>(surface->pixels) + static_cast<size_t>(surface->pitch) * y, rowSize);
+		}
+		SDL_UnlockSurface(surface);
+
+		entry.format = BlobFormat::RGBA32;
+		entry.width = static_cast<Uint32>(surface->w);
+		entry.height = static_cast<Uint32>(surface->h);
+		SDL_FreeSurface(surface);
+		return true;
+	}
+
+	// Converts the sound into the format the mixer is opened with (see Engine::initializeEngine())
+	bool decodeSound(const char* path, std::vector<Uint8>& data, Entry& entry)
+	{
+		SDL_AudioSpec spec;
+		Uint8* buffer;
+		Uint32 length;
+		if (SDL_LoadWAV(path, &spec, &buffer, &length) == nullptr) return false;
+
+		SDL_AudioCVT converter;
+		if (SDL_BuildAudioCVT(&converter, spec.format, spec.channels, spec.freq, AUDIO_FORMAT, AUDIO_CHANNELS, AUDIO_FREQUENCY) < 0)
+		{
+			SDL_FreeWAV(buffer);
+			return false;
+		}
+		data.resize(static_cast<size_t>(length) * converter.len_mult);
+		memcpy(data.data(), buffer, length);
+		SDL_FreeWAV(buffer);
+
+		converter.buf = data.data();
+		converter.len = static_cast<int>(length);
+		if (converter.needed && SDL_ConvertAudio(&converter) < 0) return false;
+		data.resize(converter.needed ? converter.len_cvt : length);
+
+		entry.format = BlobFormat::PCM;
+		return true;
+	}
+
+	bool pack(const char* outputPath, const std::vector<AssetLoader::AssetRequest>& requests, bool preDecode)
+	{
+		std::vector<Entry> entries;
+		std::vector<std::vector<Uint8>> blobs;
+
+		for (const AssetLoader::AssetRequest& request : requests)
+		{
+			const char* path = request.path.c_str();
+			if (request.path.size() >= MAX_PATH_LENGTH)
+			{
+				std::cout << "Failed to pack: " << path << " (path is too long)" << std::endl;
+				return false;
+			}
+			Entry entry{};
+			memcpy(entry.path, path, request.path.size() + 1);
+			std::vector<Uint8> data;
+
+			bool loaded;
+			if (preDecode && request.type == AssetLoader::AssetType::Image)
+				loaded = decodeImage(path, data, entry);
+			else if (preDecode && request.type == AssetLoader::AssetType::Sound)
+				loaded = decodeSound(path, data, entry);
+			else
+				loaded = readFile(path, data);
+
+			// missing assets are left out, they're loaded from the loose files at runtime instead
+			if (!loaded)
+			{
+				std::cout << "Failed to pack: " << path << ", skipping it" << std::endl;
+				continue;
+			}
+			entry.size = data.size();
+			entries.push_back(entry);
+			blobs.push_back(std::move(data));
+		}
+
+		// the blobs start after the entries that were actually written, the skipped assets have none.
+		// So every gap before a blob is shorter than BLOB_ALIGNMENT
+		size_t offset = alignUp(sizeof(Header) + sizeof(Entry) * entries.size());
+		for (Entry& entry : entries)
+		{
+			entry.offset = offset;
+			offset = alignUp(offset + static_cast<size_t>(entry.size));
+		}
+
+		std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+		if (!output)
+		{
+			std::cout << "Failed to create archive at: " << outputPath << std::endl;
+			return false;
+		}
+		Header header{};
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.entryCount = static_cast<Uint32>(entries.size());
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(sizeof(Entry) * entries.size()));
+
+		const char zeros[BLOB_ALIGNMENT] = {};
+		for (size_t i = 0; i < blobs.size(); i++)
+		{
+			const auto position = static_cast<size_t>(output.tellp());
+			output.write(zeros, static_cast<std::streamsize>(entries[i].offset - position));
+			output.write(reinterpret_cast<const char*>(blobs[i].data()), static_cast<std::streamsize>(blobs[i].size()));
+		}
+		std::cout << "Packed " << entries.size() << " assets (" << offset / 1024 << " KB) into " << outputPath << std::endl;
+		return static_cast<bool>(output);
+	}
+
+#pragma endregion
+
+#pragma region LOADING
+
+	// Maps the file at <path> into view, returns false if there's no such file. view stays null if it couldn't be mapped
+	bool mapFile(const char* path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		viewSize = static_cast<Uint64>(size.QuadPart);
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+			view = static_cast<const Uint8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		file = ::open(path, O_RDONLY);
+		if (file == -1) return false;
+
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			viewSize = static_cast<Uint64>(status.st_size);
+			void* mapped = mmap(nullptr, static_cast<size_t>(viewSize), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED)
+				view = static_cast<const Uint8*>(mapped);
+		}
+#endif
+		return true;
+	}
+
+	void unmapFile()
+	{
+#ifdef _WIN32
+		if (view != nullptr) UnmapViewOfFile(view);
+		if (mapping != nullptr) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (view != nullptr) munmap(const_cast<Uint8*>(view), static_cast<size_t>(viewSize));
+		if (file != -1) ::close(file);
+		file = -1;
+#endif
+		view = nullptr;
+		viewSize = 0;
+	}
+
+	bool open(const char* path)
+	{
+		close();
+
+		if (!mapFile(path))
+		{
+			std::cout << "No asset archive at: " << path << ", loading loose files" << std::endl;
+			return false;
+		}
+
+		const auto header = reinterpret_cast<const Header*>(view);
+		if (view == nullptr || viewSize < sizeof(Header) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+			viewSize < sizeof(Header) + sizeof(Entry) * header->entryCount)
+		{
+			std::cout << "Failed to open asset archive at: " << path << std::endl;
+			close();
+			return false;
+		}
+
+		const auto entries = reinterpret_cast<const Entry*>(view + sizeof(Header));
+		for (Uint32 i = 0; i < header->entryCount; i++)
+		{
+			if (entries[i].offset + entries[i].size > viewSize) continue; // truncated archive
+			entryByPath.emplace(entries[i].path, &entries[i]);
+		}
+		return true;
+	}
+
+	void close()
+	{
+		entryByPath.clear();
+		unmapFile();
+	}
+
+	const Entry* find(const char* path)
+	{
+		const auto found = entryByPath.find(path);
+		return found == entryByPath.end() ? nullptr : found->second;
+	}
+
+	bool contains(const char* path)
+	{
+		return find(path) != nullptr;
+	}
+
+	SDL_RWops* openBlob(const Entry& entry)
+	{
+		return SDL_RWFromConstMem(view + entry.offset, static_cast<int>(entry.size));
+	}
+
+	SDL_Surface* loadSurface(const char* path)
+	{
+		const Entry* entry = find(path);
+		if (entry == nullptr)
+			return IMG_Load(path);
+
+		if (entry->format == BlobFormat::RGBA32)
+		{
+			// points into the mapped archive, SDL_FreeSurface() won't free the pixels
+			void* pixels = const_cast<Uint8*>(view + entry->offset);
+			return SDL_CreateRGBSurfaceWithFormatFrom(pixels, static_cast<int>(entry->width), static_cast<int>(entry->height),
+													  32, static_cast<int>(entry->width * 4), SDL_PIXELFORMAT_RGBA32);
+		}
+		return IMG_Load_RW(openBlob(*entry), 1);
+	}
+
+	Mix_Chunk* loadSound(const char* path)
+	{
+		const Entry* entry = find(path);
+		if (entry == nullptr)
+			return Mix_LoadWAV(path);
+
+		if (entry->format == BlobFormat::PCM)
+		{
+			int frequency, channels;
+			Uint16 format;
+			// the samples are only usable as they are if the mixer was opened with the format they were converted to
+			if (Mix_QuerySpec(&frequency, &format, &channels) == 0 ||
+				frequency != AUDIO_FREQUENCY || format != AUDIO_FORMAT || channels != AUDIO_CHANNELS)
+				return Mix_LoadWAV(path);
+
+			return Mix_QuickLoad_RAW(const_cast<Uint8*>(view + entry->offset), static_cast<Uint32>(entry->size));
+		}
+		return Mix_LoadWAV_RW(openBlob(*entry), 1);
+	}
+
+	Mix_Music* loadMusic(const char* path)
+	{
+		const Entry* entry = find(path);
+		if (entry == nullptr || entry->format == BlobFormat::PCM) // decoded loops can't be streamed, see LoopPlayer
+			return Mix_LoadMUS(path);
+
+		// music is streamed while playing, which is fine since the archive stays mapped
+		return Mix_LoadMUS_RW(openBlob(*entry), 1);
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "assetLoader.h"
+
+/// <summary>
+/// All content packed into a single file: an index followed by 64 byte aligned blobs.
+/// At runtime the archive is memory mapped once and every asset is read through
+/// SDL_RWFromConstMem, so loading doesn't open any more files.
+///
+/// Images and sounds can be stored pre-decoded (RGBA32 pixels and PCM in the mixer's format),
+/// which skips PNG/WAV decoding entirely. Music is always stored as the original file.
+///
+/// The archive is built with the --pack argument (see main.cpp). Without an archive,
+/// or for assets that aren't in it, everything is loaded from the loose files as before.
+/// </summary>
+namespace AssetArchive
+{
+	// Writes every requested asset into one archive at <outputPath>
+	bool pack(const char* outputPath, const std::vector<AssetLoader::AssetRequest>& requests, bool preDecode);
+
+	bool open(const char* path);
+	void close();
+	bool contains(const char* path);
+
+	// Loads from the archive if it's open and contains <path>, otherwise from disk.
+	// These are safe to call from several threads at once
+	SDL_Surface* loadSurface(const char* path);
+	Mix_Chunk* loadSound(const char* path);
+	Mix_Music* loadMusic(const char* path);
+}
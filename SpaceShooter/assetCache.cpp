@@ -0,0 +1,169 @@
+#include "assetCache.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "assetArchive.h"
+#include "rendering.h"
+
+namespace AssetCache
+{
+	struct Entry
+	{
+		std::string path;
+		SDL_Texture* texture;
+		int width;
+		int height;
+		int referenceCount;
+	};
+
+	// a handle is the index of its entry, entries are never moved or erased so handles stay valid
+	std::vector<Entry> entries;
+	std::unordered_map<std::string, TextureHandle> handleByPath;
+	int hits = 0;
+	int misses = 0;
+
+	// Loads the texture into an entry that doesn't have one, returns false if it fails
+	bool loadEntry(Entry& entry)
+	{
+		SDL_Surface* surface = AssetArchive::loadSurface(entry.path.c_str());
+		entry.texture = surface != nullptr ? SDL_CreateTextureFromSurface(Rendering::getRenderer(), surface) : nullptr;
+		SDL_FreeSurface(surface);
+
+		const int result = SDL_QueryTexture(entry.texture, NULL, NULL, &entry.width, &entry.height);
+		if (result != 0)
+		{
+			std::cout << "Failed to load image at: " << entry.path << std::endl;
+			entry.texture = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	TextureHandle acquireTexture(const char* path)
+	{
+		const auto found = handleByPath.find(path);
+		if (found != handleByPath.end() && entries[found->second].texture != nullptr)
+		{
+			hits++;
+			Entry& entry = entries[found->second];
+			entry.referenceCount++;
+			return found->second;
+		}
+
+		misses++;
+		TextureHandle handle;
+		if (found != handleByPath.end())
+		{
+			handle = found->second; // was unloaded by unloadUnused()
+		}
+		else
+		{
+			if (entries.size() >= INVALID_TEXTURE)
+			{
+				std::cout << "Failed to load image at: " << path << " (texture cache is full)" << std::endl;
+				return INVALID_TEXTURE;
+			}
+			handle = static_cast<TextureHandle>(entries.size());
+			entries.push_back(Entry{ path, nullptr, 0, 0, 0 });
+			handleByPath.emplace(path, handle);
+		}
+
+		Entry& entry = entries[handle];
+		if (!loadEntry(entry))
+			return INVALID_TEXTURE;
+
+		entry.referenceCount++;
+		return handle;
+	}
+
+	TextureHandle addTexture(const char* path, SDL_Texture* texture)
+	{
+		const auto found = handleByPath.find(path);
+		if (found != handleByPath.end())
+		{
+			Entry& entry = entries[found->second];
+			if (entry.texture != nullptr)
+				SDL_DestroyTexture(entry.texture);
+			entry.texture = texture;
+			SDL_QueryTexture(texture, NULL, NULL, &entry.width, &entry.height);
+			return found->second;
+		}
+		if (entries.size() >= INVALID_TEXTURE)
+		{
+			SDL_DestroyTexture(texture);
+			return INVALID_TEXTURE;
+		}
+
+		// it was read from disk, just not by the cache itself
+		misses++;
+		const auto handle = static_cast<TextureHandle>(entries.size());
+		Entry entry{ path, texture, 0, 0, 0 };
+		SDL_QueryTexture(texture, NULL, NULL, &entry.width, &entry.height);
+		entries.push_back(entry);
+		handleByPath.emplace(path, handle);
+		return handle;
+	}
+
+	void releaseTexture(TextureHandle handle)
+	{
+		if (handle >= entries.size() || entries[handle].referenceCount == 0) return;
+		entries[handle].referenceCount--;
+	}
+
+	SDL_Texture* getTexture(TextureHandle handle)
+	{
+		if (handle >= entries.size()) return nullptr;
+		return entries[handle].texture;
+	}
+
+	void getTextureSize(TextureHandle handle, int& width, int& height)
+	{
+		if (handle >= entries.size())
+		{
+			width = height = 0;
+			return;
+		}
+		width = entries[handle].width;
+		height = entries[handle].height;
+	}
+
+	void unloadUnused()
+	{
+		for (Entry& entry : entries)
+		{
+			if (entry.referenceCount > 0 || entry.texture == nullptr) continue;
+			SDL_DestroyTexture(entry.texture);
+			entry.texture = nullptr;
+		}
+	}
+
+	void unloadAll()
+	{
+		for (Entry& entry : entries)
+		{
+			if (entry.texture != nullptr)
+				SDL_DestroyTexture(entry.texture);
+		}
+		entries.clear();
+		handleByPath.clear();
+	}
+
+	Stats getStats()
+	{
+		Stats stats{ hits, misses, 0, 0 };
+		for (const Entry& entry : entries)
+		{
+			if (entry.texture != nullptr) stats.residentTextures++;
+			if (entry.referenceCount > 0) stats.referencedTextures++;
+		}
+		return stats;
+	}
+
+	void printStats()
+	{
+		const Stats stats = getStats();
+		std::cout << "Texture cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+			<< stats.residentTextures << " resident (" << stats.referencedTextures << " in use)" << std::endl;
+	}
+}
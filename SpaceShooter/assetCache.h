@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+
+/// <summary>
+/// Loads every texture once, keyed by its path, and hands out handles to it.
+/// Each acquireTexture() must be matched by a releaseTexture(). A texture stays resident
+/// when nothing references it anymore, so opening a menu again (or respawning the player)
+/// is a cache hit instead of a disk read and PNG decode. Textures are freed in unloadAll().
+///
+/// Only use this from the main thread, it's bound to the renderer.
+/// </summary>
+namespace AssetCache
+{
+	typedef Uint16 TextureHandle;
+	constexpr TextureHandle INVALID_TEXTURE = 0xFFFF;
+
+	struct Stats { int hits; int misses; int residentTextures; int referencedTextures; };
+
+	// Returns a handle to the texture at <path>, loading it on the first call. Returns INVALID_TEXTURE if loading fails
+	TextureHandle acquireTexture(const char* path);
+	void releaseTexture(TextureHandle handle);
+
+	// Adds a texture that was created elsewhere (see AssetLoader) without referencing it, the cache takes ownership
+	TextureHandle addTexture(const char* path, SDL_Texture* texture);
+
+	// Returns nullptr for INVALID_TEXTURE and handles that don't exist, e.g. in headless worlds where nothing is loaded
+	SDL_Texture* getTexture(TextureHandle handle);
+	void getTextureSize(TextureHandle handle, int& width, int& height);
+
+	// Frees the textures that aren't referenced anymore
+	void unloadUnused();
+	void unloadAll();
+
+	Stats getStats();
+	void printStats();
+}
@@ -0,0 +1,182 @@
+#include "assetLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "assetArchive.h"
+#include "assetCache.h"
+#include "rendering.h"
+
+namespace AssetLoader
+{
+	struct LoadedAsset
+	{
+		AssetRequest request;
+		SDL_Surface* surface = nullptr;
+		Mix_Chunk* sound = nullptr;
+		Mix_Music* music = nullptr;
+		double decodeMilliseconds = 0;
+		double uploadMilliseconds = 0;
+	};
+
+	// kept after loadAll() for printReport()
+	std::vector<LoadedAsset> assets;
+	double totalMilliseconds = 0;
+	unsigned int workerCount = 0;
+
+	// preloaded audio, waiting to be taken by MusicManager
+	std::unordered_map<std::string, Mix_Chunk*> sounds;
+	std::unordered_map<std::string, Mix_Music*> musics;
+
+	double millisecondsSince(Uint64 startTicks)
+	{
+		return static_cast<double>(SDL_GetPerformanceCounter() - startTicks) * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+	// Runs on a worker thread, nothing in here may touch the renderer
+	void decode(LoadedAsset& asset)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		const char* path = asset.request.path.c_str();
+		switch (asset.request.type)
+		{
+		case AssetType::Image: asset.surface = AssetArchive::loadSurface(path); break;
+		case AssetType::Sound: asset.sound = AssetArchive::loadSound(path); break;
+		case AssetType::Music: asset.music = AssetArchive::loadMusic(path); break;
+		}
+		asset.decodeMilliseconds = millisecondsSince(startTicks);
+	}
+
+	// Runs on the main thread once the asset is decoded
+	void finish(LoadedAsset& asset)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		const std::string& path = asset.request.path;
+		switch (asset.request.type)
+		{
+		case AssetType::Image:
+			if (asset.surface == nullptr)
+			{
+				std::cout << "Failed to load image at: " << path << std::endl;
+				break;
+			}
+			AssetCache::addTexture(path.c_str(), SDL_CreateTextureFromSurface(Rendering::getRenderer(), asset.surface));
+			SDL_FreeSurface(asset.surface);
+			asset.surface = nullptr;
+			break;
+		case AssetType::Sound:
+			if (asset.sound == nullptr)
+				std::cout << "Failed to load sound at: " << path << std::endl;
+			else
+				sounds[path] = asset.sound;
+			break;
+		case AssetType::Music:
+			if (asset.music == nullptr)
+				std::cout << "Failed to load music at: " << path << std::endl;
+			else
+				musics[path] = asset.music;
+			break;
+		}
+		asset.uploadMilliseconds = millisecondsSince(startTicks);
+	}
+
+	void loadAll(const std::vector<AssetRequest>& requests)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+
+		assets.clear();
+		for (const AssetRequest& request : requests)
+		{
+			assets.push_back(LoadedAsset{ request });
+		}
+
+		std::atomic<size_t> nextAsset = 0;
+		std::mutex finishedMutex;
+		std::condition_variable assetFinished;
+		std::vector<size_t> finished;
+
+		const auto work = [&]
+		{
+			for (size_t i = nextAsset++; i < assets.size(); i = nextAsset++)
+			{
+				decode(assets[i]);
+
+				std::lock_guard lock(finishedMutex);
+				finished.push_back(i);
+				assetFinished.notify_one();
+			}
+		};
+
+		workerCount = std::clamp(std::thread::hardware_concurrency(), 1u, static_cast<unsigned int>((std::max)(assets.size(), size_t(1))));
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < workerCount; i++)
+		{
+			workers.emplace_back(work);
+		}
+
+		// upload textures as they complete, while the workers keep decoding
+		std::vector<size_t> ready;
+		for (size_t finishedCount = 0; finishedCount < assets.size();)
+		{
+			{
+				std::unique_lock lock(finishedMutex);
+				assetFinished.wait(lock, [&] { return !finished.empty(); });
+				ready.swap(finished);
+			}
+			for (const size_t i : ready)
+			{
+				finish(assets[i]);
+			}
+			finishedCount += ready.size();
+			ready.clear();
+		}
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		totalMilliseconds = millisecondsSince(startTicks);
+		printReport();
+	}
+
+	Mix_Chunk* takeSound(const char* path)
+	{
+		const auto found = sounds.find(path);
+		if (found == sounds.end())
+			return AssetArchive::loadSound(path);
+
+		Mix_Chunk* sound = found->second;
+		sounds.erase(found);
+		return sound;
+	}
+
+	Mix_Music* takeMusic(const char* path)
+	{
+		const auto found = musics.find(path);
+		if (found == musics.end())
+			return AssetArchive::loadMusic(path);
+
+		Mix_Music* music = found->second;
+		musics.erase(found);
+		return music;
+	}
+
+	void printReport()
+	{
+		double decodeSum = 0;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "Loaded " << assets.size() << " assets in " << totalMilliseconds << " ms on " << workerCount << " threads\n";
+		std::cout << "  decode ms  upload ms  path\n";
+		for (const LoadedAsset& asset : assets)
+		{
+			decodeSum += asset.decodeMilliseconds;
+			std::cout << std::setw(11) << asset.decodeMilliseconds << std::setw(11) << asset.uploadMilliseconds
+				<< "  " << asset.request.path << "\n";
+		}
+		std::cout << "Decoding serially would have taken about " << decodeSum << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SDL_mixer.h>
+
+/// <summary>
+/// Loads the startup assets in parallel.
+/// Images are decoded to surfaces and sounds/music are loaded on worker threads (from AssetArchive if it's open),
+/// while the main thread uploads every finished surface as a texture into AssetCache.
+/// Textures are then a cache hit when they're acquired, and MusicManager takes
+/// its sounds from here with takeSound()/takeMusic().
+///
+/// Needs the renderer and the audio device to be open (see Engine::initializeEngine()).
+/// </summary>
+namespace AssetLoader
+{
+	enum class AssetType { Image, Sound, Music };
+
+	struct AssetRequest
+	{
+		std::string path;
+		AssetType type;
+	};
+
+	// Blocks until every asset is loaded, then prints how long each one took
+	void loadAll(const std::vector<AssetRequest>& requests);
+
+	// Returns the preloaded asset and hands over ownership, or loads it now if it wasn't preloaded
+	Mix_Chunk* takeSound(const char* path);
+	Mix_Music* takeMusic(const char* path);
+
+	void printReport();
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include "map"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "assetLoader.h"
 #include "musicManager.h"
 #include "UI.h"
 
@@ -11,13 +15,21 @@ namespace Assets
 	inline const char* playerTexturePath = "Content/Sprites/player90x90.png";
 	inline const char* crosshairTexturePath = "Content/Sprites/crosshair.png";
 
-	inline const char* laserSFX = "Content/Audio/SFX_Laser";
+	inline const char* laserSFX = "Content/Audio/SFX_Laser"; // SFX_Laser1.wav - SFX_Laser4.wav
 	inline const char* badLaserSFX = "Content/Audio/SFX_BadLaser.wav";
 	inline const char* transitionSFX = "Content/Audio/SFX_Transition.wav";
 	inline const char* glitchSFX = "Content/Audio/SFX_CollisionGlitch2.wav";
 
 	inline const char* sphericalLightPath = "Content/Sprites/spherical_light.png";
 
+	inline const char* archivePath = "Content/assets.pack"; // built with the --pack argument
+
+	inline const char* defaultWavesPath = "Content/Waves/default.waves";
+	inline const char* stressWavesPath = "Content/Waves/stress.waves"; // used with the --stress argument
+
+	inline const char* goldenReplayPath = "Content/Replays/golden.replay";
+	inline const char* goldenFramesPath = "Content/Golden"; // the reference images, made with the --golden-record argument
+
 	inline const char* texturePaths[] = {
 		"Content/Sprites/meteor1_blue.png",
 		"Content/Sprites/meteor2.png",
@@ -42,4 +54,44 @@ namespace Assets
 		{ UI::Menu::pause, "Content/Sprites/PauseScreen.png"}, 
 		{ UI::Menu::gameOver, "Content/Sprites/GameOverScreen.png" } 
 	};
+
+	inline std::string getLaserSFXPath(int index)
+	{
+		return laserSFX + std::to_string(index + 1) + ".wav";
+	}
+
+	// Everything that's loaded before the intro menu, see AssetLoader
+	// With <decodeMusic> the beat loops are loaded as sounds, to be played by LoopPlayer,
+	// otherwise MusicManager streams them from disk itself
+	inline std::vector<AssetLoader::AssetRequest> getStartupAssets(bool decodeMusic = true)
+	{
+		using AssetLoader::AssetType;
+		std::vector<AssetLoader::AssetRequest> requests;
+
+		for (const char* path : texturePaths)
+			requests.push_back({ path, AssetType::Image });
+		for (const char* path : { playerTexturePath, crosshairTexturePath, sphericalLightPath })
+			requests.push_back({ path, AssetType::Image });
+		for (const auto& [button, path] : buttonPathMap)
+			requests.push_back({ path, AssetType::Image });
+		for (const auto& [menu, path] : menuOverlayPaths)
+		{
+			// the intro and pause menu share an overlay
+			const bool alreadyAdded = std::any_of(requests.begin(), requests.end(), [&](const AssetLoader::AssetRequest& request) { return request.path == path; });
+			if (!alreadyAdded)
+				requests.push_back({ path, AssetType::Image });
+		}
+
+		if (decodeMusic)
+		{
+			for (const Beat& beat : beats)
+				requests.push_back({ beat.path, AssetType::Sound });
+		}
+		for (int i = 0; i < 4; i++)
+			requests.push_back({ getLaserSFXPath(i), AssetType::Sound });
+		for (const char* path : { badLaserSFX, transitionSFX, glitchSFX })
+			requests.push_back({ path, AssetType::Sound });
+
+		return requests;
+	}
 }
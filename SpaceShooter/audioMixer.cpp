@@ -0,0 +1,300 @@
+#include "audioMixer.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include "mixKernel.h"
+#include "musicManager.h"
+
+namespace AudioMixer
+{
+	struct Voice
+	{
+		const Sint16* samples = nullptr;
+		Uint32 sampleCount = 0; // interleaved samples, not frames
+		Uint32 cursor = 0; // the voice is free once this reaches sampleCount
+		float gain = 1.f;
+		Uint64 triggerTicks = 0; // set by playSound(), cleared when it's first mixed
+	};
+
+	Backend backend = Backend::SDLMixer;
+	SDL_AudioDeviceID device = 0;
+	int bufferFrames = 0;
+	int frequency = AUDIO_FREQUENCY;
+
+	// everything below is shared with the audio thread, guarded by the device lock
+	Voice voices[MAX_VOICES];
+	int reservedVoices = 0;
+	int nextVoice = 0;
+	MusicCallback musicCallback = nullptr;
+	void* musicUserData = nullptr;
+
+	Uint64 callbackCount = 0;
+	Uint64 callbackTicks = 0;
+	Uint64 maxCallbackTicks = 0;
+	Uint64 soundsMixed = 0;
+	Uint64 triggerTicks = 0;
+	Uint64 maxTriggerTicks = 0;
+
+	// the stream is mixed in blocks of this many samples, so the mix buffer doesn't depend on the device's channel count
+	constexpr Uint32 MIX_BLOCK_SAMPLES = MAX_BUFFER_FRAMES * AUDIO_CHANNELS;
+	alignas(32) float mixBuffer[MIX_BLOCK_SAMPLES];
+
+	// Runs on the audio thread, SDL holds the device lock while it's called
+	void SDLCALL mix(void*, Uint8* stream, int length)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		SDL_memset(stream, 0, length);
+		if (musicCallback != nullptr)
+			musicCallback(musicUserData, stream, length);
+
+		for (Voice& voice : voices)
+		{
+			if (voice.cursor >= voice.sampleCount || voice.triggerTicks == 0) continue;
+
+			const Uint64 waited = startTicks - voice.triggerTicks;
+			triggerTicks += waited;
+			maxTriggerTicks = (std::max)(maxTriggerTicks, waited);
+			soundsMixed++;
+			voice.triggerTicks = 0;
+		}
+
+		// the music is the first layer, every voice is added on top of it and the sum is clipped once
+		Sint16* output = reinterpret_cast<Sint16*>(stream);
+		const Uint32 outputSamples = static_cast<Uint32>(length) / sizeof(Sint16);
+		for (Uint32 blockStart = 0; blockStart < outputSamples; blockStart += MIX_BLOCK_SAMPLES)
+		{
+			Sint16* block = output + blockStart;
+			const Uint32 blockSamples = (std::min)(MIX_BLOCK_SAMPLES, outputSamples - blockStart);
+			std::fill_n(mixBuffer, blockSamples, 0.f);
+			if (musicCallback != nullptr)
+				MixKernel::accumulate(mixBuffer, block, blockSamples, 1.f);
+
+			for (Voice& voice : voices)
+			{
+				if (voice.cursor >= voice.sampleCount) continue;
+
+				const Uint32 count = (std::min)(blockSamples, voice.sampleCount - voice.cursor);
+				MixKernel::accumulate(mixBuffer, voice.samples + voice.cursor, count, voice.gain);
+				voice.cursor += count;
+			}
+			MixKernel::clipToInt16(block, mixBuffer, blockSamples);
+		}
+
+		const Uint64 elapsed = SDL_GetPerformanceCounter() - startTicks;
+		callbackTicks += elapsed;
+		maxCallbackTicks = (std::max)(maxCallbackTicks, elapsed);
+		callbackCount++;
+	}
+
+	// Picks a free unreserved voice, starting after the last one that was played,
+	// so when they're all busy the one that was started first is taken
+	int findVoice()
+	{
+		const int voiceCount = MAX_VOICES - reservedVoices;
+		if (voiceCount <= 0) return -1;
+
+		for (int i = 0; i < voiceCount; i++)
+		{
+			const int index = reservedVoices + (nextVoice + i) % voiceCount;
+			if (voices[index].cursor >= voices[index].sampleCount)
+			{
+				nextVoice = (index - reservedVoices + 1) % voiceCount;
+				return index;
+			}
+		}
+		const int index = reservedVoices + nextVoice;
+		nextVoice = (nextVoice + 1) % voiceCount;
+		return index;
+	}
+
+	bool open(Backend requestedBackend, int requestedFrames)
+	{
+		bufferFrames = MIN_BUFFER_FRAMES;
+		while (bufferFrames < requestedFrames && bufferFrames < MAX_BUFFER_FRAMES)
+		{
+			bufferFrames *= 2;
+		}
+
+		backend = Backend::SDLMixer;
+		if (Mix_OpenAudio(AUDIO_FREQUENCY, AUDIO_FORMAT, AUDIO_CHANNELS, bufferFrames) < 0)
+		{
+			printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+			return false;
+		}
+		if (requestedBackend == Backend::SDLMixer) return true;
+
+		// the device is opened in the exact format the sounds are loaded in, SDL converts it if it has to
+		Uint16 format;
+		int channels;
+		Mix_QuerySpec(&frequency, &format, &channels);
+		if (format != AUDIO_S16SYS)
+		{
+			printf("The audio mixer only supports 16-bit output, using SDL_mixer instead\n");
+			return true;
+		}
+
+		SDL_AudioSpec desired{};
+		desired.freq = frequency;
+		desired.format = format;
+		desired.channels = static_cast<Uint8>(channels);
+		desired.samples = static_cast<Uint16>(bufferFrames);
+		desired.callback = mix;
+		SDL_AudioSpec obtained;
+		device = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+		if (device == 0)
+		{
+			printf("Failed to open the audio device, using SDL_mixer instead! SDL Error: %s\n", SDL_GetError());
+			return true;
+		}
+
+		backend = Backend::Callback;
+		bufferFrames = obtained.samples;
+		SDL_PauseAudioDevice(device, 0);
+		return true;
+	}
+
+	void close()
+	{
+		if (device != 0)
+			SDL_CloseAudioDevice(device);
+		device = 0;
+		Mix_CloseAudio();
+	}
+
+	Backend getBackend()
+	{
+		return backend;
+	}
+
+	void reserveVoices(int count)
+	{
+		if (backend == Backend::SDLMixer)
+		{
+			Mix_ReserveChannels(count);
+			return;
+		}
+		SDL_LockAudioDevice(device);
+		reservedVoices = std::clamp(count, 0, MAX_VOICES);
+		nextVoice = 0;
+		SDL_UnlockAudioDevice(device);
+	}
+
+	int playSound(Mix_Chunk* sound, int volume, int voice)
+	{
+		if (sound == nullptr) return -1;
+
+		if (backend == Backend::SDLMixer)
+		{
+			const int channel = Mix_PlayChannel(voice, sound, 0);
+			if (channel >= 0)
+				Mix_Volume(channel, volume);
+			return channel;
+		}
+
+		SDL_LockAudioDevice(device);
+		if (voice < 0 || voice >= MAX_VOICES)
+			voice = findVoice();
+		if (voice >= 0)
+		{
+			voices[voice] = Voice{ reinterpret_cast<const Sint16*>(sound->abuf), sound->alen / static_cast<Uint32>(sizeof(Sint16)),
+				0, static_cast<float>(std::clamp(volume, 0, MIX_MAX_VOLUME)) / MIX_MAX_VOLUME, SDL_GetPerformanceCounter() };
+		}
+		SDL_UnlockAudioDevice(device);
+		return voice;
+	}
+
+	bool isPlaying(int voice)
+	{
+		if (backend == Backend::SDLMixer)
+			return Mix_Playing(voice) != 0;
+		if (voice < 0 || voice >= MAX_VOICES)
+			return false;
+
+		SDL_LockAudioDevice(device);
+		const bool playing = voices[voice].cursor < voices[voice].sampleCount;
+		SDL_UnlockAudioDevice(device);
+		return playing;
+	}
+
+	Uint32 getPlayingVoices()
+	{
+		Uint32 playing = 0;
+		if (backend == Backend::SDLMixer)
+		{
+			for (int i = 0; i < getVoiceCount(); i++)
+			{
+				if (Mix_Playing(i))
+					playing |= 1u << i;
+			}
+			return playing;
+		}
+
+		SDL_LockAudioDevice(device);
+		for (int i = 0; i < MAX_VOICES; i++)
+		{
+			if (voices[i].cursor < voices[i].sampleCount)
+				playing |= 1u << i;
+		}
+		SDL_UnlockAudioDevice(device);
+		return playing;
+	}
+
+	int getVoiceCount()
+	{
+		// passing -1 only returns the number of channels SDL_mixer has allocated
+		return backend == Backend::SDLMixer ? (std::min)(Mix_AllocateChannels(-1), 32) : MAX_VOICES;
+	}
+
+	void hookMusic(MusicCallback callback, void* userData)
+	{
+		if (backend == Backend::SDLMixer)
+		{
+			Mix_HookMusic(callback, userData);
+			return;
+		}
+		SDL_LockAudioDevice(device);
+		musicCallback = callback;
+		musicUserData = userData;
+		SDL_UnlockAudioDevice(device);
+	}
+
+	Stats getStats()
+	{
+		if (device != 0)
+			SDL_LockAudioDevice(device);
+
+		const double ticksPerMillisecond = SDL_GetPerformanceFrequency() / 1000.0;
+		Stats stats{};
+		stats.bufferFrames = bufferFrames;
+		stats.frequency = frequency;
+		stats.callbackCount = callbackCount;
+		stats.soundsMixed = soundsMixed;
+		if (callbackCount > 0)
+			stats.averageCallbackMicroseconds = callbackTicks * 1000.0 / ticksPerMillisecond / callbackCount;
+		stats.maxCallbackMicroseconds = maxCallbackTicks * 1000.0 / ticksPerMillisecond;
+		if (soundsMixed > 0)
+			stats.averageTriggerMilliseconds = triggerTicks / ticksPerMillisecond / soundsMixed;
+		stats.maxTriggerMilliseconds = maxTriggerTicks / ticksPerMillisecond;
+
+		if (device != 0)
+			SDL_UnlockAudioDevice(device);
+		return stats;
+	}
+
+	void printStats()
+	{
+		const Stats stats = getStats();
+		const double bufferMilliseconds = 1000.0 * stats.bufferFrames / stats.frequency;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "Audio: " << (backend == Backend::Callback ? "callback mixer" : "SDL_mixer") << ", "
+			<< stats.bufferFrames << " frame buffer (" << bufferMilliseconds << " ms)" << std::endl;
+		if (backend != Backend::Callback) return;
+
+		std::cout << "  callback: " << stats.averageCallbackMicroseconds << " us avg, " << stats.maxCallbackMicroseconds << " us max ("
+			<< stats.averageCallbackMicroseconds * 0.1 / bufferMilliseconds << "% of the buffer) over " << stats.callbackCount << " calls\n";
+		std::cout << "  sound trigger to mix: " << stats.averageTriggerMilliseconds << " ms avg, "
+			<< stats.maxTriggerMilliseconds << " ms max over " << stats.soundsMixed << " sounds\n";
+		std::cout << "  estimated output latency: " << stats.averageTriggerMilliseconds + bufferMilliseconds
+			<< " ms, not counting the driver's own buffering" << std::endl;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+/// <summary>
+/// Owns the audio output that music and sound effects are played through.
+///
+/// The Callback backend opens its own SDL audio device, with a buffer of 64-1024 frames, and mixes
+/// the hooked music and a fixed ring of preallocated voices in its callback. Nothing is allocated
+/// or locked per sound, other than the device lock, so the only latency is the buffer itself.
+/// The SDLMixer backend plays voices on SDL_mixer channels instead, like the game used to.
+///
+/// SDL_mixer is opened with both backends, sounds are still loaded as Mix_Chunks in its format
+/// and streamed music (see MusicManager) is always played by it.
+/// </summary>
+namespace AudioMixer
+{
+	enum class Backend { SDLMixer, Callback };
+
+	constexpr int MIN_BUFFER_FRAMES = 64;
+	constexpr int MAX_BUFFER_FRAMES = 1024;
+	constexpr int MAX_VOICES = 16;
+
+	typedef void (SDLCALL* MusicCallback)(void* userData, Uint8* stream, int length);
+
+	struct Stats
+	{
+		int bufferFrames;
+		int frequency;
+		Uint64 callbackCount;
+		double averageCallbackMicroseconds;
+		double maxCallbackMicroseconds;
+		Uint64 soundsMixed;
+		double averageTriggerMilliseconds; // from playSound() until the callback starts mixing the sound
+		double maxTriggerMilliseconds;
+	};
+
+	// Opens the audio device, call once at startup. <bufferFrames> is clamped and rounded up to a power of two
+	bool open(Backend backend, int bufferFrames);
+	void close();
+	Backend getBackend();
+
+	// The first <count> voices are only played when they're asked for by index
+	void reserveVoices(int count);
+	// Plays the sound on <voice>, or on the next unreserved voice if it's -1 (stealing the oldest if they're all busy).
+	// Returns the voice it's played on, or -1. <volume> is 0 - MIX_MAX_VOLUME
+	int playSound(Mix_Chunk* sound, int volume, int voice = -1);
+	bool isPlaying(int voice);
+	// A bit per voice, set while it's playing. Takes the device lock once, instead of once per voice
+	Uint32 getPlayingVoices();
+	// Never more than 32, the number of bits in getPlayingVoices()
+	int getVoiceCount();
+
+	// Replaces the music player, <callback> runs on the audio thread and gets a silent stream in the mixer's format
+	void hookMusic(MusicCallback callback, void* userData);
+
+	Stats getStats();
+	void printStats();
+}
@@ -0,0 +1,368 @@
+#include "beatAnalyzer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "wavReader.h"
+
+namespace BeatAnalyzer
+{
+	constexpr double MIN_BPM = 60;
+	constexpr double MAX_BPM = 200;
+	constexpr float COMPRESSION = 100.f; // of the magnitudes, so quiet onsets count too
+	constexpr int MEAN_RADIUS = 8; // envelope values, the local mean is subtracted to leave only the peaks
+	constexpr int BLOCK_FRAMES = 16384; // read from the file at a time
+
+	double secondsSince(Uint64 startTicks)
+	{
+		return static_cast<double>(SDL_GetPerformanceCounter() - startTicks) / SDL_GetPerformanceFrequency();
+	}
+
+#pragma region OnsetDetector
+	OnsetDetector::OnsetDetector(int sampleRate) : window(FRAME_SIZE), real(FRAME_SIZE), imaginary(FRAME_SIZE),
+		previousSpectrum(FRAME_SIZE / 2 + 1), spectrum(FRAME_SIZE / 2 + 1), sampleRate(sampleRate)
+	{
+		const double pi = 3.14159265358979323846;
+		for (int i = 0; i < FRAME_SIZE; i++)
+		{
+			window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * pi * i / FRAME_SIZE));
+		}
+		bassBins = (std::max)(1, static_cast<int>(150.0 * FRAME_SIZE / sampleRate));
+	}
+
+	void OnsetDetector::addSamples(const float* samples, size_t count)
+	{
+		pending.insert(pending.end(), samples, samples + count);
+
+		// frames overlap by half, and two of them are done with one FFT
+		while (pending.size() - pendingStart >= FRAME_SIZE + HOP_SIZE)
+		{
+			processFramePair(pending.data() + pendingStart, pending.data() + pendingStart + HOP_SIZE);
+			pendingStart += HOP_SIZE * 2;
+		}
+		if (pendingStart >= BLOCK_FRAMES)
+		{
+			pending.erase(pending.begin(), pending.begin() + pendingStart);
+			pendingStart = 0;
+		}
+	}
+
+	void OnsetDetector::finish()
+	{
+		const std::vector<float> silence(FRAME_SIZE + HOP_SIZE, 0.f);
+		addSamples(silence.data(), silence.size());
+	}
+
+	int OnsetDetector::getSampleRate() const
+	{
+		return sampleRate;
+	}
+
+	// Both frames are real, so one goes in the real part and the other in the imaginary part,
+	// and their spectra are separated afterwards using the symmetry of real signals
+	void OnsetDetector::processFramePair(const float* first, const float* second)
+	{
+		for (int i = 0; i < FRAME_SIZE; i++)
+		{
+			real[i] = first[i] * window[i];
+			imaginary[i] = second[i] * window[i];
+		}
+		fft.forward(real.data(), imaginary.data());
+
+		constexpr float scale = 1.f / FRAME_SIZE; // half of the 2 / FRAME_SIZE that makes a full scale sine ~1
+		for (int k = 0; k <= FRAME_SIZE / 2; k++)
+		{
+			const int mirror = (FRAME_SIZE - k) & (FRAME_SIZE - 1);
+			const float firstReal = real[k] + real[mirror];
+			const float firstImaginary = imaginary[k] - imaginary[mirror];
+			spectrum[k] = std::sqrt(firstReal * firstReal + firstImaginary * firstImaginary) * scale;
+		}
+		addSpectrum();
+
+		for (int k = 0; k <= FRAME_SIZE / 2; k++)
+		{
+			const int mirror = (FRAME_SIZE - k) & (FRAME_SIZE - 1);
+			const float secondReal = imaginary[k] + imaginary[mirror];
+			const float secondImaginary = real[mirror] - real[k];
+			spectrum[k] = std::sqrt(secondReal * secondReal + secondImaginary * secondImaginary) * scale;
+		}
+		addSpectrum();
+	}
+
+	// Spectral flux: how much every bin grew since the last frame, ignoring bins that got quieter
+	void OnsetDetector::addSpectrum()
+	{
+		float flux = 0;
+		float bassFlux = 0;
+		for (int k = 1; k <= FRAME_SIZE / 2; k++)
+		{
+			const float compressed = std::log1p(COMPRESSION * spectrum[k]);
+			const float growth = compressed - previousSpectrum[k];
+			previousSpectrum[k] = compressed;
+			if (growth <= 0) continue;
+
+			flux += growth;
+			if (k <= bassBins)
+				bassFlux += growth;
+		}
+		envelope.push_back(flux);
+		bassEnvelope.push_back(bassFlux);
+	}
+#pragma endregion
+
+#pragma region Grid estimation
+	// Subtracts the local mean and drops what's below it, so only the onsets are left
+	std::vector<float> getPeaks(const std::vector<float>& envelope)
+	{
+		const int count = static_cast<int>(envelope.size());
+		std::vector<float> peaks(count);
+		double sum = 0;
+		int first = 0, last = -1;
+		for (int i = 0; i < count; i++)
+		{
+			while (last < (std::min)(i + MEAN_RADIUS, count - 1)) sum += envelope[++last];
+			while (first < i - MEAN_RADIUS) sum -= envelope[first++];
+			const float mean = static_cast<float>(sum / (last - first + 1));
+			peaks[i] = (std::max)(envelope[i] - mean, 0.f);
+		}
+		return peaks;
+	}
+
+	// The envelope at a fractional position, wrapping around since tracks are assumed to loop
+	float sample(const std::vector<float>& values, double position)
+	{
+		const int count = static_cast<int>(values.size());
+		if (position >= 0 && position < count - 1)
+		{
+			const int index = static_cast<int>(position);
+			const float fraction = static_cast<float>(position - index);
+			return values[index] * (1 - fraction) + values[index + 1] * fraction;
+		}
+		const double wrapped = position - std::floor(position / count) * count;
+		const int index = static_cast<int>(wrapped) % count;
+		const float fraction = static_cast<float>(wrapped - std::floor(wrapped));
+		return values[index] * (1 - fraction) + values[(index + 1) % count] * fraction;
+	}
+
+	// How strongly a comb with <period> (in envelope values) starting at <phase> hits onsets, on average
+	double combScore(const std::vector<float>& values, double period, double phase)
+	{
+		double score = 0;
+		int teeth = 0;
+		for (double position = phase; position < values.size(); position += period, teeth++)
+		{
+			score += sample(values, position);
+		}
+		return teeth > 0 ? score / teeth : 0;
+	}
+
+	double bestPhase(const std::vector<float>& values, double period, double step, double& bestScore)
+	{
+		double phase = 0;
+		bestScore = -1;
+		for (double candidate = 0; candidate < period; candidate += step)
+		{
+			const double score = combScore(values, period, candidate);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				phase = candidate;
+			}
+		}
+		return phase;
+	}
+
+	// People tap along at around 120 BPM, which settles whether a track is at half or double tempo
+	double tempoPrior(double bpm)
+	{
+		const double octaves = std::log2(bpm / 120.0);
+		return std::exp(-0.5 * octaves * octaves);
+	}
+
+	Result estimateGrid(const OnsetDetector& detector, Sint64 totalFrames, int timeSignature, bool isLoop)
+	{
+		Result result;
+		const int sampleRate = detector.getSampleRate();
+		const double envelopeRate = static_cast<double>(sampleRate) / HOP_SIZE;
+		result.audioSeconds = static_cast<double>(totalFrames) / sampleRate;
+		result.grid.sampleRate = sampleRate;
+		result.grid.frames = totalFrames;
+		result.grid.timeSignature = (std::max)(timeSignature, 1);
+
+		// only the part of the envelope that's inside the track, so it loops cleanly
+		const size_t usedCount = (std::min)(detector.envelope.size(), static_cast<size_t>(std::ceil(totalFrames / static_cast<double>(HOP_SIZE))));
+		const std::vector<float> onsets = getPeaks(std::vector<float>(detector.envelope.begin(), detector.envelope.begin() + usedCount));
+		const std::vector<float> bass = getPeaks(std::vector<float>(detector.bassEnvelope.begin(), detector.bassEnvelope.begin() + usedCount));
+		const int count = static_cast<int>(onsets.size());
+
+		const int minLag = static_cast<int>(std::floor(envelopeRate * 60 / MAX_BPM));
+		const int maxLag = (std::min)(static_cast<int>(std::ceil(envelopeRate * 60 / MIN_BPM)), count / 2);
+		if (minLag < 2 || maxLag <= minLag + 1) return result;
+
+		// circular autocorrelation, weighted by how likely each tempo is
+		std::vector<double> scores(maxLag + 2, 0.0);
+		for (int lag = minLag - 1; lag <= maxLag + 1; lag++)
+		{
+			double correlation = 0;
+			for (int i = 0; i < count; i++)
+			{
+				correlation += onsets[i] * onsets[(i + lag) % count];
+			}
+			scores[lag] = correlation / count * tempoPrior(60 * envelopeRate / lag);
+		}
+		const int bestLag = static_cast<int>(std::max_element(scores.begin() + minLag, scores.begin() + maxLag + 1) - scores.begin());
+
+		// the peak is between two lags, a parabola through its neighbours finds where
+		const double left = scores[bestLag - 1], center = scores[bestLag], right = scores[bestLag + 1];
+		const double curvature = left - 2 * center + right;
+		const double refinedLag = bestLag + (curvature < 0 ? 0.5 * (left - right) / curvature : 0);
+		const double coarseBpm = 60 * envelopeRate / refinedLag;
+
+		// the comb fit refines the tempo to 0.02 BPM, over the whole track instead of one lag
+		double bpm = coarseBpm;
+		double bestScore = -1;
+		for (double candidate = coarseBpm * 0.985; candidate <= coarseBpm * 1.015; candidate += 0.02)
+		{
+			double score;
+			bestPhase(onsets, 60 * envelopeRate / candidate, 0.25, score);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bpm = candidate;
+			}
+		}
+
+		// a loop has a whole number of beats, unless the tempo is off
+		const double loopBeats = std::round(result.audioSeconds * bpm / 60);
+		const double loopBpm = loopBeats * 60 / result.audioSeconds;
+		if (isLoop && loopBeats >= 1 && std::abs(loopBpm - bpm) / bpm < 0.01)
+		{
+			bpm = loopBpm;
+			result.snappedToLoop = true;
+		}
+
+		double phaseScore;
+		const double period = 60 * envelopeRate / bpm;
+		const double phase = bestPhase(onsets, period, 0.05, phaseScore);
+
+		// the downbeat is the beat in the bar with the most bass
+		int downbeat = 0;
+		double downbeatScore = -1;
+		for (int beat = 0; beat < result.grid.timeSignature; beat++)
+		{
+			const double score = combScore(bass, period * result.grid.timeSignature, phase + beat * period);
+			if (score > downbeatScore)
+			{
+				downbeatScore = score;
+				downbeat = beat;
+			}
+		}
+
+		// the flux peaks at the frame whose middle the onset is in
+		const double framesPerBeat = sampleRate * 60.0 / bpm;
+		const double barFrames = framesPerBeat * result.grid.timeSignature;
+		double firstDownbeat = (phase + downbeat * period) * HOP_SIZE + FRAME_SIZE / 2;
+		firstDownbeat -= std::floor(firstDownbeat / barFrames) * barFrames;
+		const double firstBeat = firstDownbeat - std::floor(firstDownbeat / framesPerBeat) * framesPerBeat;
+
+		for (double frame = firstBeat; frame < totalFrames; frame += framesPerBeat)
+		{
+			const Sint64 beatFrame = std::llround(frame);
+			if (beatFrame < totalFrames)
+				result.grid.beatFrames.push_back(beatFrame);
+		}
+		result.grid.firstDownbeat = static_cast<int>(std::lround((firstDownbeat - firstBeat) / framesPerBeat));
+		if (result.grid.firstDownbeat >= static_cast<int>(result.grid.beatFrames.size()))
+			result.grid.beatFrames.clear();
+		result.grid.bpm = bpm;
+		result.downbeatSeconds = firstDownbeat / sampleRate;
+		return result;
+	}
+#pragma endregion
+
+#pragma region Files
+	bool analyzeFile(const std::string& path, int timeSignature, bool isLoop, Result& result)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		WavReader reader;
+		if (!reader.open(path)) return false;
+
+		const int channels = reader.getChannels();
+		OnsetDetector detector(reader.getSampleRate());
+		std::vector<float> samples(static_cast<size_t>(BLOCK_FRAMES) * channels);
+		std::vector<float> mono(BLOCK_FRAMES);
+		for (int frames; (frames = reader.read(samples.data(), BLOCK_FRAMES)) > 0;)
+		{
+			// the channels are averaged, the beat is the same in all of them
+			for (int frame = 0; frame < frames; frame++)
+			{
+				float sum = 0;
+				for (int channel = 0; channel < channels; channel++)
+				{
+					sum += samples[frame * channels + channel];
+				}
+				mono[frame] = sum / channels;
+			}
+			detector.addSamples(mono.data(), frames);
+		}
+		detector.finish();
+
+		result = estimateGrid(detector, reader.getFrameCount(), timeSignature, isLoop);
+		result.milliseconds = secondsSince(startTicks) * 1000;
+		if (result.grid.beatFrames.empty())
+		{
+			std::cout << "Couldn't find a beat in: " << path << " (is it shorter than two beats?)" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool analyzeFiles(const std::vector<std::string>& paths, int timeSignature, bool areLoops)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		std::vector<Result> results(paths.size());
+		std::vector<char> succeeded(paths.size(), 0);
+		std::atomic<size_t> nextPath = 0;
+
+		const auto work = [&]
+		{
+			for (size_t i = nextPath++; i < paths.size(); i = nextPath++)
+			{
+				succeeded[i] = analyzeFile(paths[i], timeSignature, areLoops, results[i]) && results[i].grid.save(BeatGrid::getPath(paths[i]));
+			}
+		};
+		const unsigned int threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, static_cast<unsigned int>((std::max)(paths.size(), size_t(1))));
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0; i < threadCount; i++)
+		{
+			threads.emplace_back(work);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double totalSeconds = secondsSince(startTicks);
+
+		double audioSeconds = 0;
+		bool allSucceeded = true;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "     BPM  downbeat  beats  analysis ms  path\n";
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			allSucceeded &= succeeded[i] != 0;
+			if (!succeeded[i]) continue;
+
+			const Result& result = results[i];
+			audioSeconds += result.audioSeconds;
+			std::cout << std::setw(8) << result.grid.bpm << std::setw(9) << result.downbeatSeconds << "s"
+				<< std::setw(7) << result.grid.beatFrames.size() << std::setw(13) << result.milliseconds
+				<< "  " << paths[i] << (result.snappedToLoop ? " (snapped to the loop length)" : "") << "\n";
+		}
+		std::cout << "Analyzed " << audioSeconds << " s of audio in " << totalSeconds * 1000 << " ms on " << threadCount
+			<< " threads (" << audioSeconds / totalSeconds << "x realtime)" << std::endl;
+		return allSucceeded;
+	}
+#pragma endregion
+}
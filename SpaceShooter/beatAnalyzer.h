@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "beatTimeline.h"
+#include "fft.h"
+
+/// <summary>
+/// Finds the tempo, the downbeat and the beat grid of a track, offline.
+///
+/// The audio is streamed through an OnsetDetector, which turns it into an onset envelope
+/// (how much the spectrum grew, ~86 times per second at 44.1 kHz), so a track is never fully in memory.
+/// The tempo is the period the envelope repeats with (autocorrelation, then a comb fit to refine it),
+/// the phase is where a comb with that period hits the most onsets, and the downbeat is the beat in the bar
+/// with the strongest bass onsets. For loops the tempo is snapped so a whole number of beats fits in it.
+///
+/// The grid assumes a constant tempo, and the time signature isn't detected.
+/// </summary>
+namespace BeatAnalyzer
+{
+	constexpr int FRAME_SIZE = 1024;
+	constexpr int HOP_SIZE = 512;
+
+	// Feed it mono samples in any block size, the onset envelope gets a value every HOP_SIZE samples
+	struct OnsetDetector
+	{
+	private:
+		FFT fft{ FRAME_SIZE };
+		std::vector<float> window;
+		std::vector<float> pending; // samples that haven't been through a frame yet
+		size_t pendingStart = 0;
+		std::vector<float> real;
+		std::vector<float> imaginary;
+		std::vector<float> previousSpectrum;
+		std::vector<float> spectrum;
+		int sampleRate = 44100;
+		int bassBins = 0;
+
+		void processFramePair(const float* first, const float* second);
+		void addSpectrum();
+
+	public:
+		std::vector<float> envelope; // spectral flux of all bins
+		std::vector<float> bassEnvelope; // spectral flux below ~150 Hz, for finding the downbeats
+
+		explicit OnsetDetector(int sampleRate);
+		void addSamples(const float* samples, size_t count);
+		// Processes what's left, padded with silence
+		void finish();
+		int getSampleRate() const;
+	};
+
+	struct Result
+	{
+		BeatGrid grid;
+		double downbeatSeconds = 0; // the first downbeat
+		bool snappedToLoop = false;
+		double audioSeconds = 0;
+		double milliseconds = 0; // how long the analysis took
+	};
+
+	// Estimates the grid from a finished detector, for a track that's <totalFrames> long
+	Result estimateGrid(const OnsetDetector& detector, Sint64 totalFrames, int timeSignature, bool isLoop);
+
+	// Streams a WAV file (16/24-bit PCM or 32-bit float) through the detector
+	bool analyzeFile(const std::string& path, int timeSignature, bool isLoop, Result& result);
+
+	// Analyzes the files in parallel, and saves each grid next to its file. Returns false if any failed
+	bool analyzeFiles(const std::vector<std::string>& paths, int timeSignature, bool areLoops);
+}
@@ -0,0 +1,291 @@
+#include "beatCircleBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include "culling.h"
+#include "easingFunctions.h"
+
+namespace
+{
+	// The corners of a hexagon with radius 1, at the same angles as Rendering::drawHexagon()
+	constexpr SDL_FPoint UNIT_HEXAGON[6] = {
+		{ 1.f, 0.f }, { 0.5f, 0.8660254f }, { -0.5f, 0.8660254f }, { -1.f, 0.f }, { -0.5f, -0.8660254f }, { 0.5f, -0.8660254f }
+	};
+	// Half a pixel across an edge, measured along the line to a corner
+	constexpr float HALF_LINE = 0.5f / 0.8660254f;
+
+	constexpr int WHOLE_NOTE = 0, HALF_NOTE = 1, QUARTER_NOTE = 2;
+
+	float getDistanceMultiplier(const Position& position, float mouseX, float mouseY)
+	{
+		const float x = mouseX - position.x;
+		const float y = mouseY - position.y;
+		const float distanceToMouse = std::sqrt(x * x + y * y);
+		const float multiplier = std::clamp(1 - (distanceToMouse - position.radius * 1.5f - 50) / BeatCircleBatch::MAX_MOUSE_DISTANCE, 0.f, 1.f);
+		return multiplier * multiplier * multiplier;
+	}
+
+	// Alphas are worked out in floats, and cut off the way SDL_SetRenderDrawColor() did with them
+	Uint8 toAlpha(float alpha)
+	{
+		return static_cast<Uint8>(std::clamp(alpha, 0.f, 255.f));
+	}
+}
+
+Color BeatCircleBatch::getColor(bool isBeatActive, float beatProgress, float fadeInProgress, int add)
+{
+	fadeInProgress = std::clamp(fadeInProgress, 0.f, 1.f);
+	return Color{
+		isBeatActive ? 60.f : std::lerp(100.f, 80.f, Ease::In(beatProgress, 4)), 0.f,
+		isBeatActive ? 225.f : (200 + add) * beatProgress,
+		isBeatActive ? 255.f : (200 + add) * fadeInProgress
+	};
+}
+
+float BeatCircleBatch::getRadius(float prevRadius, float timeElapsed, float beatLength, float synchDuration)
+{
+	return std::lerp(prevRadius * 2.5f, prevRadius,
+					(timeElapsed - synchDuration) / (beatLength - synchDuration));
+}
+
+void BeatCircleBatch::prepare(const MusicData& music, const SDL_FRect& view)
+{
+	this->view = view;
+	culledCount = 0;
+	for (std::vector<Circle>& bucket : buckets)
+	{
+		bucket.clear();
+	}
+
+	const float synchDuration = music.quarterNoteLength / 4;
+	const float timesSinceNote[3] = { music.timeSinceLastWholeNote, music.timeSinceLastHalfNote, music.timeSinceLastQuarterNote };
+	const float noteLengths[3] = { music.wholeNoteLength, music.halfNoteLength, music.quarterNoteLength };
+	const float progresses[3] = { music.wholeNoteProgress, music.halfNoteProgress, music.quarterNoteProgress };
+	const float fadeInTimes[3] = { 0.5f, 0.2f, 0.1f };
+	const int brightness[3] = { 20, 15, 0 };
+
+	for (int i = 0; i < 3; i++)
+	{
+		Note& note = notes[i];
+		note.isActive = timesSinceNote[i] < synchDuration;
+		note.color = getColor(note.isActive, progresses[i], (timesSinceNote[i] - synchDuration) / fadeInTimes[i], brightness[i]);
+		note.radiusScale = note.isActive ? 1.f : getRadius(1.f, timesSinceNote[i], noteLengths[i], synchDuration);
+		note.beatProgress = progresses[i];
+		// quarter notes don't draw the second ring
+		note.secondBeatProgress = i < QUARTER_NOTE ? progresses[i + 1] : 0.f;
+	}
+}
+
+void BeatCircleBatch::addCircle(const Circle& circle, Tag tag)
+{
+	const Position& position = circle.position;
+	int bucket;
+	float radiusScale = 1;
+	if (tag == Tag::Unsplittable)
+		bucket = static_cast<int>(Bucket::Unsplittable);
+	else
+	{
+		const int note = position.radius > MIN_SIZE_WHOLENOTE ? WHOLE_NOTE : position.radius > MIN_SIZE_HALFNOTE ? HALF_NOTE : QUARTER_NOTE;
+		bucket = static_cast<int>(Bucket::WholeNote) + note * 2 + (notes[note].isActive ? 0 : 1);
+		radiusScale = (std::max)(notes[note].radiusScale, 1.f);
+	}
+
+	if (!Culling::isVisible(view, position.x, position.y, position.radius * radiusScale + MAX_RING_OFFSET))
+	{
+		culledCount++;
+		return;
+	}
+	buckets[bucket].push_back(circle);
+}
+
+void BeatCircleBatch::classifyScalar(const MovableObjects& objects, size_t playerIndex, const MusicData& music, float mouseX, float mouseY, const SDL_FRect& view)
+{
+	prepare(music, view);
+
+	size_t first = 0;
+	objects.forEachChunk<Position, Tag>([&](size_t count, const Position* positions, const Tag* tags)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (first + i == playerIndex) continue;
+			addCircle({ positions[i], getDistanceMultiplier(positions[i], mouseX, mouseY) }, tags[i]);
+		}
+		first += count;
+	});
+}
+
+void BeatCircleBatch::classify(const MovableObjects& objects, size_t playerIndex, const MusicData& music, float mouseX, float mouseY, const SDL_FRect& view)
+{
+	prepare(music, view);
+
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 mouseXs = _mm_set1_ps(mouseX);
+	const __m128 mouseYs = _mm_set1_ps(mouseY);
+	const __m128 radiusScale = _mm_set1_ps(1.5f);
+	const __m128 margin = _mm_set1_ps(50.f);
+	const __m128 maxDistance = _mm_set1_ps(MAX_MOUSE_DISTANCE);
+
+	size_t first = 0;
+	objects.forEachChunk<Position, Tag>([&](size_t count, const Position* positions, const Tag* tags)
+	{
+		distanceMultipliers.resize(count);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 x = _mm_sub_ps(mouseXs, _mm_set_ps(positions[i + 3].x, positions[i + 2].x, positions[i + 1].x, positions[i].x));
+			const __m128 y = _mm_sub_ps(mouseYs, _mm_set_ps(positions[i + 3].y, positions[i + 2].y, positions[i + 1].y, positions[i].y));
+			const __m128 radius = _mm_set_ps(positions[i + 3].radius, positions[i + 2].radius, positions[i + 1].radius, positions[i].radius);
+
+			const __m128 distanceToMouse = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+			const __m128 past = _mm_sub_ps(_mm_sub_ps(distanceToMouse, _mm_mul_ps(radius, radiusScale)), margin);
+			const __m128 multiplier = _mm_min_ps(_mm_max_ps(_mm_sub_ps(one, _mm_div_ps(past, maxDistance)), zero), one);
+			_mm_storeu_ps(distanceMultipliers.data() + i, _mm_mul_ps(_mm_mul_ps(multiplier, multiplier), multiplier));
+		}
+		for (; i < count; i++)
+		{
+			distanceMultipliers[i] = getDistanceMultiplier(positions[i], mouseX, mouseY);
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			if (first + i == playerIndex) continue;
+			addCircle({ positions[i], distanceMultipliers[i] }, tags[i]);
+		}
+		first += count;
+	});
+}
+
+const std::vector<BeatCircleBatch::Circle>& BeatCircleBatch::getCircles(Bucket bucket) const
+{
+	return buckets[static_cast<int>(bucket)];
+}
+
+size_t BeatCircleBatch::getCircleCount() const
+{
+	size_t count = 0;
+	for (const std::vector<Circle>& bucket : buckets)
+	{
+		count += bucket.size();
+	}
+	return count;
+}
+
+size_t BeatCircleBatch::getCulledCount() const
+{
+	return culledCount;
+}
+
+// The outline Rendering::drawHexagon() draws, with a second line <offset> further out when it's not 0, as one strip
+void BeatCircleBatch::addRing(Position center, float radius, float offset, SDL_Color color)
+{
+	const float inner = radius - HALF_LINE;
+	const float outer = radius + offset + HALF_LINE;
+	for (const SDL_FPoint& corner : UNIT_HEXAGON)
+	{
+		vertices.push_back(SDL_Vertex{ { center.x + corner.x * outer, center.y + corner.y * outer }, color, { 0, 0 } });
+		vertices.push_back(SDL_Vertex{ { center.x + corner.x * inner, center.y + corner.y * inner }, color, { 0, 0 } });
+	}
+}
+
+int BeatCircleBatch::emit(Detail detail)
+{
+	vertices.clear();
+	// reduced leaves out the rings that only add to the glow, minimal keeps one ring per object
+	const bool isFull = detail == Detail::Full;
+	const bool isMinimal = detail == Detail::Minimal;
+
+	for (const Circle& circle : buckets[static_cast<int>(Bucket::Unsplittable)])
+	{
+		const SDL_Color red{ 150, 0, 0, 175 };
+		addRing(circle.position, circle.position.radius + 1, 1.f, red);
+		if (isFull)
+			addRing(circle.position, circle.position.radius + 7, 0.f, red);
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		const Note& note = notes[i];
+		const SDL_Color color{ note.color.r, note.color.g, note.color.b, 0 };
+
+		for (const Circle& circle : buckets[static_cast<int>(Bucket::WholeNote) + i * 2])
+		{
+			const Position& position = circle.position;
+			SDL_Color active = color;
+			active.a = toAlpha(note.color.a * circle.distanceMultiplier * circle.distanceMultiplier);
+
+			if (position.radius > MIN_SIZE_HALFNOTE && isFull)
+				addRing(position, position.radius + 6, 0.f, active);
+			if (!isMinimal)
+				addRing(position, position.radius + 1, 1.f, active);
+			addRing(position, position.radius, 1.f, active);
+			if (!isFull) continue;
+			active.a = toAlpha(active.a * 0.9f);
+			addRing(position, position.radius + 5, 0.5f, active);
+		}
+
+		const float radiusScale = note.radiusScale;
+		// the second ring shrinks with the next shorter note, from the size of the first one
+		const float secondRadiusScale = std::clamp(std::lerp(radiusScale, 1.f, note.secondBeatProgress), (std::min)(radiusScale, 1.f), (std::max)(radiusScale, 1.f));
+		const bool hasSecondRing = i < QUARTER_NOTE && note.beatProgress < 0.5f;
+		const float innerAlpha = i < QUARTER_NOTE ? 100 * (1 + (1 - note.secondBeatProgress)) : 100.f;
+		const SDL_Color innerColor = i < QUARTER_NOTE ? SDL_Color{ 100, 0, 200, 0 } : SDL_Color{ 115, 0, 230, 0 };
+
+		for (const Circle& circle : buckets[static_cast<int>(Bucket::WholeNoteOffBeat) + i * 2])
+		{
+			const Position& position = circle.position;
+			const float radius = position.radius * radiusScale;
+
+			if (hasSecondRing && isFull)
+			{
+				SDL_Color second = color;
+				second.g = 0;
+				second.a = toAlpha(note.color.a * 0.66f * circle.distanceMultiplier);
+				addRing(position, position.radius * secondRadiusScale, 0.f, second);
+			}
+			if (!isMinimal)
+			{
+				SDL_Color inner = innerColor;
+				inner.a = toAlpha(innerAlpha * circle.distanceMultiplier);
+				addRing(position, position.radius, i < QUARTER_NOTE ? 1.f : 0.f, inner);
+			}
+
+			SDL_Color offBeat = color;
+			offBeat.a = toAlpha(note.color.a * circle.distanceMultiplier);
+			addRing(position, radius, 1.f, offBeat);
+			if (!isFull) continue;
+			offBeat.a = toAlpha(offBeat.a * 0.9f);
+			addRing(position, radius + 5, 0.5f, offBeat);
+		}
+	}
+
+	// six quads around each ring, between its outer and inner corners
+	const int ringCount = static_cast<int>(vertices.size()) / VERTICES_PER_RING;
+	for (int ring = static_cast<int>(indices.size()) / INDICES_PER_RING; ring < ringCount; ring++)
+	{
+		const int first = ring * VERTICES_PER_RING;
+		for (int corner = 0; corner < 6; corner++)
+		{
+			const int outer = first + corner * 2;
+			const int nextOuter = first + (corner + 1) % 6 * 2;
+			indices.insert(indices.end(), { outer, nextOuter, nextOuter + 1, outer, nextOuter + 1, outer + 1 });
+		}
+	}
+	return ringCount * INDICES_PER_RING;
+}
+
+const SDL_Vertex* BeatCircleBatch::getVertices() const
+{
+	return vertices.data();
+}
+
+int BeatCircleBatch::getVertexCount() const
+{
+	return static_cast<int>(vertices.size());
+}
+
+const int* BeatCircleBatch::getIndices() const
+{
+	return indices.data();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "detailController.h"
+#include "gameObject.h"
+#include "musicManager.h"
+
+using namespace GameObject;
+
+/// <summary>
+/// Draws the hexagons around the objects that show the beat, as one batch of triangles with a single SDL_RenderGeometry() call.
+///
+/// classify() sorts the objects into buckets by the note their size plays and whether that note is on the beat,
+/// and works out how close each one is to the mouse four objects at a time with SSE. Everything else about the
+/// look of a bucket, its colors and how far the rings have shrunk, is the same for all of its objects and only
+/// worked out once. emit() then writes every ring of every bucket as a thin hexagon strip, the color per bucket
+/// and the alpha per object in the vertex colors, instead of changing the draw color a few times per object.
+/// </summary>
+struct BeatCircleBatch
+{
+	// The disabled objects, then the note each object plays on and off the beat
+	enum class Bucket { Unsplittable, WholeNote, WholeNoteOffBeat, HalfNote, HalfNoteOffBeat, QuarterNote, QuarterNoteOffBeat, Count };
+
+	struct Circle
+	{
+		Position position;
+		float distanceMultiplier; // 1 near the mouse, fades to 0 with the distance
+	};
+
+	static constexpr float MAX_MOUSE_DISTANCE = 1300.f;
+	static constexpr float MAX_RING_OFFSET = 8.f; // how far the outermost ring can be outside the object, past its shrink
+	static constexpr int VERTICES_PER_RING = 12;
+	static constexpr int INDICES_PER_RING = 36;
+
+private:
+	// How the circles of a note look this frame
+	struct Note
+	{
+		bool isActive = false;
+		Color color;
+		float radiusScale = 1; // of the shrinking rings off the beat, from 2.5 times the object down to its size
+		float beatProgress = 0;
+		float secondBeatProgress = 0; // of the next shorter note
+	};
+
+	std::vector<Circle> buckets[static_cast<int>(Bucket::Count)];
+	Note notes[3]; // whole, half and quarter
+	std::vector<float> distanceMultipliers; // of one chunk
+	SDL_FRect view{};
+	size_t culledCount = 0;
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices; // the same for every ring, only grows
+
+	void prepare(const MusicData& music, const SDL_FRect& view);
+	// Into the bucket of its tag, its size and whether its note is on the beat, unless none of its rings reach into the view
+	void addCircle(const Circle& circle, Tag tag);
+	void addRing(Position center, float radius, float offset, SDL_Color color);
+
+public:
+	// The colors the beat circles fade between, <add> makes the longer notes brighter
+	static Color getColor(bool isBeatActive, float beatProgress, float fadeInProgress, int add = 0);
+	// How far the rings off the beat have shrunk towards <prevRadius>
+	static float getRadius(float prevRadius, float timeElapsed, float beatLength, float synchDuration);
+
+	// Sorts every object but the player that's in <view> into the buckets, call it once per frame before emit()
+	void classify(const MovableObjects& objects, size_t playerIndex, const MusicData& music, float mouseX, float mouseY, const SDL_FRect& view);
+	// The same without SSE, to compare against
+	void classifyScalar(const MovableObjects& objects, size_t playerIndex, const MusicData& music, float mouseX, float mouseY, const SDL_FRect& view);
+	// Of the last classify()
+	const std::vector<Circle>& getCircles(Bucket bucket) const;
+	size_t getCircleCount() const;
+	// The objects that were left out because they're outside the view
+	size_t getCulledCount() const;
+
+	// Writes the rings of every bucket, fewer of them below full <detail>. Returns how many indices were written
+	int emit(Detail detail);
+	// Of the last emit(), valid until the next one
+	const SDL_Vertex* getVertices() const;
+	int getVertexCount() const;
+	const int* getIndices() const;
+};
@@ -0,0 +1,164 @@
+#include "beatTimeline.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+std::string BeatGrid::getPath(const std::string& audioPath)
+{
+	const size_t extension = audioPath.find_last_of('.');
+	const size_t folder = audioPath.find_last_of("/\\");
+	if (extension == std::string::npos || (folder != std::string::npos && extension < folder))
+		return audioPath + ".beats";
+	return audioPath.substr(0, extension) + ".beats";
+}
+
+// Empty lines and lines starting with # are ignored, like in the wave tables
+bool BeatGrid::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	BeatGrid loaded;
+	bool hasHeader = false;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+
+		std::istringstream stream(line);
+		if (!hasHeader)
+		{
+			if (!(stream >> loaded.sampleRate >> loaded.frames >> loaded.bpm >> loaded.timeSignature >> loaded.firstDownbeat)) break;
+			hasHeader = true;
+			continue;
+		}
+		Sint64 frame;
+		if (!(stream >> frame)) break;
+		loaded.beatFrames.push_back(frame);
+	}
+
+	const bool ascending = std::adjacent_find(loaded.beatFrames.begin(), loaded.beatFrames.end(), std::greater_equal<Sint64>()) == loaded.beatFrames.end();
+	if (!hasHeader || loaded.sampleRate <= 0 || loaded.bpm <= 0 || loaded.timeSignature < 1 || loaded.beatFrames.empty()
+		|| loaded.firstDownbeat < 0 || loaded.firstDownbeat >= static_cast<int>(loaded.beatFrames.size()) || !ascending || loaded.beatFrames.front() < 0 || loaded.beatFrames.back() >= loaded.frames)
+	{
+		std::cout << "Invalid beat grid at: " << path << std::endl;
+		return false;
+	}
+
+	*this = loaded;
+	return true;
+}
+
+bool BeatGrid::save(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "Failed to write beat grid at: " << path << std::endl;
+		return false;
+	}
+	file << "# sampleRate frames bpm timeSignature firstDownbeat, then the first frame of every beat\n";
+	file << sampleRate << " " << frames << " " << bpm << " " << timeSignature << " " << firstDownbeat << "\n";
+	for (const Sint64 frame : beatFrames)
+	{
+		file << frame << "\n";
+	}
+	return true;
+}
+
+BeatTimeline::BeatTimeline(double bpm, int signature, int rate, Sint64 loopFrames)
+	: sampleRate(rate), timeSignature((std::max)(signature, 1)), framesPerBeat(rate * 60.0 / bpm)
+{
+	// a bar is rounded to whole frames, which drifts less than a frame per bar from the exact tempo
+	cycleFrames = loopFrames > 0 ? loopFrames : std::llround(framesPerBeat * timeSignature);
+
+	// beats are rounded to the nearest frame from the start of the cycle, so the rounding never adds up
+	for (int beat = 0; ; beat++)
+	{
+		const Sint64 offset = std::llround(beat * framesPerBeat);
+		if (beat > 0 && offset >= cycleFrames) break;
+		beatOffsets.push_back(offset);
+	}
+	beatOffsets.push_back(cycleFrames);
+}
+
+BeatTimeline::BeatTimeline(const BeatGrid& grid)
+	: sampleRate(grid.sampleRate), timeSignature(grid.timeSignature), framesPerBeat(grid.sampleRate * 60.0 / grid.bpm),
+	cycleFrames(grid.frames), firstBeatFrame(grid.beatFrames[grid.firstDownbeat])
+{
+	// the table is shifted to start on the first downbeat, and the beats before it are the last ones of the loop
+	const int beatCount = static_cast<int>(grid.beatFrames.size());
+	for (int i = 0; i < beatCount; i++)
+	{
+		const int beat = (grid.firstDownbeat + i) % beatCount;
+		const Sint64 frame = grid.beatFrames[beat] + (beat < grid.firstDownbeat ? cycleFrames : 0);
+		beatOffsets.push_back(frame - firstBeatFrame);
+	}
+	beatOffsets.push_back(cycleFrames);
+}
+
+BeatTimeline::GridPosition BeatTimeline::at(double seconds) const
+{
+	return atFrame(static_cast<Sint64>(std::floor(seconds * sampleRate)));
+}
+
+BeatTimeline::GridPosition BeatTimeline::atFrame(Sint64 frame) const
+{
+	GridPosition position;
+	if (isEmpty()) return position;
+
+	frame -= firstBeatFrame;
+
+	// rounds towards negative infinity, so times before the start are at the end of the previous cycle
+	Sint64 cycle = frame / cycleFrames;
+	if (frame < 0 && frame % cycleFrames != 0) cycle--;
+	const Sint64 frameInCycle = frame - cycle * cycleFrames;
+
+	// the tempo gives the beat to within one for an even grid, the table decides
+	const int beatCount = getBeatsPerCycle();
+	int beat = std::clamp(static_cast<int>(frameInCycle / framesPerBeat), 0, beatCount - 1);
+	while (beatOffsets[beat] > frameInCycle)
+		beat--;
+	while (beatOffsets[beat + 1] <= frameInCycle)
+		beat++;
+
+	const int beatInBar = beat % timeSignature;
+	const int barStart = beat - beatInBar;
+	const int barEnd = (std::min)(barStart + timeSignature, beatCount);
+	const int halfStart = barStart + beatInBar / 2 * 2;
+	const int halfEnd = (std::min)(halfStart + 2, barEnd);
+
+	position.beat = cycle * beatCount + beat;
+	position.quarterNote = beatInBar + 1;
+
+	const auto setNote = [&](int startBeat, int endBeat, float& timeSince, float& length, float& progress)
+	{
+		const Sint64 start = beatOffsets[startBeat];
+		const Sint64 end = beatOffsets[endBeat];
+		timeSince = static_cast<float>(frameInCycle - start) / sampleRate;
+		length = static_cast<float>(end - start) / sampleRate;
+		progress = static_cast<float>(frameInCycle - start) / static_cast<float>(end - start);
+	};
+	setNote(beat, beat + 1, position.timeSinceQuarterNote, position.quarterNoteLength, position.quarterNoteProgress);
+	setNote(halfStart, halfEnd, position.timeSinceHalfNote, position.halfNoteLength, position.halfNoteProgress);
+	setNote(barStart, barEnd, position.timeSinceWholeNote, position.wholeNoteLength, position.wholeNoteProgress);
+	return position;
+}
+
+BeatTimeline::GridPosition BeatTimeline::atStart() const
+{
+	return atFrame(firstBeatFrame);
+}
+
+bool BeatTimeline::isEmpty() const
+{
+	return beatOffsets.size() < 2;
+}
+
+int BeatTimeline::getBeatsPerCycle() const
+{
+	return isEmpty() ? 0 : static_cast<int>(beatOffsets.size()) - 1;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SDL.h>
+
+/// <summary>
+/// A beat grid found by BeatAnalyzer, saved next to the track it belongs to (see getPath()).
+/// The file is text: a header line with the sample rate, the length in frames, the BPM, the time signature
+/// and which beat is the first downbeat, followed by the first frame of every beat, one per line.
+/// </summary>
+struct BeatGrid
+{
+	int sampleRate = 44100;
+	Sint64 frames = 0; // the length of the track
+	double bpm = 120;
+	int timeSignature = 4;
+	int firstDownbeat = 0; // index in beatFrames
+	std::vector<Sint64> beatFrames;
+
+	// <track>.wav -> <track>.beats
+	static std::string getPath(const std::string& audioPath);
+
+	bool load(const std::string& path);
+	bool save(const std::string& path) const;
+};
+
+/// <summary>
+/// The beat grid of one track, built once when the track is loaded.
+/// The first sample frame of every beat is stored in a table, so finding where a time is on the grid
+/// is a lookup instead of something that's accumulated frame by frame, and the answer is the same
+/// for any caller and any time (rendering, input judgement, a replay...).
+///
+/// For a loop the table covers the whole loop, and the grid restarts with it. Otherwise it covers one bar,
+/// which is repeated forever. Bars start on every <timeSignature>:th beat from the start of the table.
+/// A table built from a BeatGrid starts at its first downbeat, the beats before it are played again at the end of the loop.
+/// It's never changed after it's built, so it can be read from any thread.
+/// </summary>
+struct BeatTimeline
+{
+	// Where a time is on the grid. Times and lengths are in seconds
+	struct GridPosition
+	{
+		Sint64 beat = 0; // quarter notes since the track started, counting every loop
+		int quarterNote = 1; // 1 - timeSignature, within the bar
+
+		float timeSinceQuarterNote = 0;
+		float timeSinceHalfNote = 0;
+		float timeSinceWholeNote = 0;
+
+		// of the notes the time is in, a loop can end with a short one
+		float quarterNoteLength = 0;
+		float halfNoteLength = 0;
+		float wholeNoteLength = 0;
+
+		// start of note = 0, end of note = 1
+		float quarterNoteProgress = 0;
+		float halfNoteProgress = 0;
+		float wholeNoteProgress = 0;
+	};
+
+private:
+	int sampleRate = 44100;
+	int timeSignature = 4;
+	double framesPerBeat = 0;
+	Sint64 cycleFrames = 0; // the loop, or one bar
+	Sint64 firstBeatFrame = 0; // where the table starts
+	std::vector<Sint64> beatOffsets; // the first frame of every beat in the cycle, and the end of the cycle last
+
+public:
+	BeatTimeline() = default;
+	// <loopFrames> is the length of the loop in sample frames, or 0 if it doesn't loop
+	BeatTimeline(double bpm, int timeSignature, int sampleRate, Sint64 loopFrames = 0);
+	// The grid has to be valid, see BeatGrid::load()
+	explicit BeatTimeline(const BeatGrid& grid);
+
+	GridPosition at(double seconds) const;
+	GridPosition atFrame(Sint64 frame) const;
+	// At the first beat of the table, where the first bar starts
+	GridPosition atStart() const;
+
+	bool isEmpty() const;
+	int getBeatsPerCycle() const;
+};
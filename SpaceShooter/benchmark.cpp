@@ -0,0 +1,585 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "beatCircleBatch.h"
+#include "easingFunctions.h"
+#include "engine.h"
+#include "game.h"
+#include "headlessWorld.h"
+#include "mixKernel.h"
+#include "musicManager.h"
+#include "player.h"
+#include "rendering.h"
+#include "softwareRasterizer.h"
+#include "starAtlas.h"
+#include "starBatch.h"
+#include "vector2.h"
+#include "waveManager.h"
+
+namespace Benchmark
+{
+	constexpr float FIXED_DELTA_TIME = 1.f / 120.f;
+	constexpr float BENCHMARK_BPM = 120.f;
+
+	struct WorldResult
+	{
+		double seconds = 0;
+		size_t peakObjectCount = 0;
+		long long collisionChecks = 0;
+	};
+
+	double secondsSince(Uint64 startTicks)
+	{
+		return static_cast<double>(SDL_GetPerformanceCounter() - startTicks) / SDL_GetPerformanceFrequency();
+	}
+
+	// Runs one world with a fixed time step, the waves are advanced as if the music was playing at BENCHMARK_BPM
+	void simulateWorld(const char* wavesPath, int frameCount, WorldResult& result)
+	{
+		HeadlessWorld headlessWorld(wavesPath, BENCHMARK_BPM);
+		const World& world = headlessWorld.world;
+
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			headlessWorld.step();
+
+			if (world.objects.size() > result.peakObjectCount)
+				result.peakObjectCount = world.objects.size();
+			result.collisionChecks += world.collisionChecksPerFrame;
+		}
+		result.seconds = secondsSince(startTicks);
+	}
+
+	// The columns read by sortObjects()/moveObjects() every frame, fewer bytes per object means fewer cache lines per pass
+	void printObjectLayout()
+	{
+		constexpr size_t hotBytes = sizeof(Position) + sizeof(Velocity) + sizeof(Tag);
+		std::cout << "Object layout: " << MovableObjects::BYTES_PER_ENTITY << " bytes/object ("
+			<< hotBytes << " in the collision columns), "
+			<< MovableObjects::CHUNK_CAPACITY << " objects per chunk" << std::endl;
+	}
+
+	void runWorlds(int worldCount, int frameCount, const char* wavesPath)
+	{
+		std::cout << "Simulating " << worldCount << " world(s), " << frameCount << " frames each" << std::endl;
+		printObjectLayout();
+
+		std::vector<WorldResult> results(worldCount);
+		std::vector<std::thread> threads;
+
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (int i = 0; i < worldCount; i++)
+		{
+			threads.emplace_back(simulateWorld, wavesPath, frameCount, std::ref(results[i]));
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double totalSeconds = secondsSince(startTicks);
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (int i = 0; i < worldCount; i++)
+		{
+			std::cout << "World " << i << ": " << results[i].seconds * 1000 << " ms, "
+				<< frameCount / results[i].seconds << " frames/s, "
+				<< "peak objects: " << results[i].peakObjectCount << ", "
+				<< "checks/frame: " << results[i].collisionChecks / frameCount << std::endl;
+		}
+		std::cout << "Total: " << totalSeconds * 1000 << " ms, "
+			<< (static_cast<double>(frameCount) * worldCount) / totalSeconds << " frames/s" << std::endl;
+	}
+
+	// Mixes every voice into the buffer <repetitions> times, the same way AudioMixer's callback does. Returns the milliseconds it took
+	template<typename Sample>
+	double timeMix(const std::vector<Sample>& voices, int voiceCount, int repetitions, std::vector<float>& mixBuffer, std::vector<Sint16>& output)
+	{
+		const Uint32 sampleCount = static_cast<Uint32>(output.size());
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (int repetition = 0; repetition < repetitions; repetition++)
+		{
+			std::fill(mixBuffer.begin(), mixBuffer.end(), 0.f);
+			for (int voice = 0; voice < voiceCount; voice++)
+			{
+				MixKernel::accumulate(mixBuffer.data(), voices.data() + voice * sampleCount, sampleCount, 0.5f);
+			}
+			MixKernel::clipToInt16(output.data(), mixBuffer.data(), sampleCount);
+		}
+		return secondsSince(startTicks) * 1000;
+	}
+
+	void runMixer(int voiceCount, int bufferFrames)
+	{
+		const Uint32 sampleCount = static_cast<Uint32>(bufferFrames) * AUDIO_CHANNELS;
+		const double bufferMilliseconds = 1000.0 * bufferFrames / AUDIO_FREQUENCY;
+		// about 50 million samples per path, so each measurement takes a while
+		const int repetitions = (std::max)(1, static_cast<int>(50'000'000 / (static_cast<size_t>(sampleCount) * voiceCount)));
+
+		// noise, loud enough that the sum clips
+		std::mt19937 random(1);
+		std::uniform_int_distribution<int> distribution(-32768, 32767);
+		std::vector<Sint16> intVoices(static_cast<size_t>(sampleCount) * voiceCount);
+		std::vector<float> floatVoices(intVoices.size());
+		for (size_t i = 0; i < intVoices.size(); i++)
+		{
+			intVoices[i] = static_cast<Sint16>(distribution(random));
+			floatVoices[i] = intVoices[i] / 32768.f;
+		}
+
+		std::vector<float> mixBuffer(sampleCount);
+		std::vector<Sint16> output(sampleCount);
+		std::vector<Sint16> scalarOutput;
+
+		std::cout << "Mixing " << voiceCount << " voices into " << bufferFrames << " frame buffers ("
+			<< std::fixed << std::setprecision(2) << bufferMilliseconds << " ms of audio), " << repetitions << " times per path" << std::endl;
+
+		const MixKernel::Path originalPath = MixKernel::getPath();
+		for (const MixKernel::Path path : { MixKernel::Path::Scalar, MixKernel::Path::SSE2, MixKernel::Path::AVX2 })
+		{
+			if (!MixKernel::setPath(path))
+			{
+				std::cout << std::setw(8) << MixKernel::getPathName(path) << ": not supported by this CPU" << std::endl;
+				continue;
+			}
+			const double intMilliseconds = timeMix(intVoices, voiceCount, repetitions, mixBuffer, output);
+			if (path == MixKernel::Path::Scalar)
+				scalarOutput = output;
+			const bool matchesScalar = output == scalarOutput;
+			const double floatMilliseconds = timeMix(floatVoices, voiceCount, repetitions, mixBuffer, output);
+
+			const double intVoicesPerMillisecond = static_cast<double>(voiceCount) * repetitions / intMilliseconds;
+			const double floatVoicesPerMillisecond = static_cast<double>(voiceCount) * repetitions / floatMilliseconds;
+			std::cout << std::setw(8) << MixKernel::getPathName(path) << ": "
+				<< "int16 " << intVoicesPerMillisecond << " voices/ms (" << intVoicesPerMillisecond * bufferMilliseconds << " per buffer), "
+				<< "float " << floatVoicesPerMillisecond << " voices/ms (" << floatVoicesPerMillisecond * bufferMilliseconds << " per buffer)"
+				<< (matchesScalar ? "" : ", output differs from scalar!") << std::endl;
+		}
+		MixKernel::setPath(originalPath);
+	}
+
+	// The frame state of a song at BENCHMARK_BPM, <frame> frames in
+	StarBatch::FrameState getStarFrame(int frame)
+	{
+		const float elapsedTime = frame * FIXED_DELTA_TIME;
+		const float quarterNoteLength = 60.f / BENCHMARK_BPM;
+		StarBatch::FrameState state;
+		state.musicIsPlaying = true;
+		state.wholeNoteLength = quarterNoteLength * 4;
+		state.quarterNoteProgress = fmodf(elapsedTime, quarterNoteLength) / quarterNoteLength;
+		state.pulseMultiplier = 1 - state.quarterNoteProgress;
+		state.elapsedTime = elapsedTime;
+		return state;
+	}
+
+	// The size and alpha of a star with the formulas Rendering::drawStars() used before StarBatch, to check it against
+	void getReferenceStarLook(const LifeTimeObject& life, const StarShape& shape, const Color& color, const StarBatch::FrameState& frame, float& size, float& alpha)
+	{
+		const int lifeTime = static_cast<int>(std::round(life.totalLifeTime));
+		const float fadeInTime = lifeTime <= 4 ? 0.04f : 2.f;
+		const float beatMultiplier =
+			lifeTime == 1 ? frame.quarterNoteProgress * 0.5f + 0.5f :
+			lifeTime == 2 ? 1 - (frame.quarterNoteProgress * 0.5f + 0.5f) :
+			lifeTime == 3 ? Ease::Out(frame.pulseMultiplier, 3) :
+			lifeTime == 4 ? 1 - Ease::Out(frame.pulseMultiplier, 3) : 1.f;
+
+		const float normalizedLife = life.elapsedLifeTime / (frame.wholeNoteLength * life.totalLifeTime);
+		const float lifeMultiplier = 1 - Ease::Out(normalizedLife, 2);
+		const float fadeInMultiplier = Ease::Out(std::clamp(life.elapsedLifeTime / fadeInTime, 0.f, 1.f), 2);
+		size = std::clamp(shape.maxSize * lifeMultiplier, 1.f, shape.maxSize) * fadeInMultiplier;
+		alpha = std::clamp(color.a * lifeMultiplier * beatMultiplier * fadeInMultiplier, 0.f, 255.f);
+	}
+
+	// Writes the same triangles as StarBatch::emit(), but rotates every vertex around its star with Vector2D::rotatePoint()
+	void emitRotatingEveryVertex(const Stars& stars, const StarBatch& batch, float elapsedTime, std::vector<SDL_Vertex>& vertices)
+	{
+		vertices.clear();
+		for (size_t i = 0; i < stars.size(); i++)
+		{
+			const StarShape& star = stars.get<StarShape>(i);
+			const Color& color = stars.get<Color>(i);
+			const float size = batch.getSize(i);
+			const SDL_FPoint corners[StarBatch::VERTICES_PER_STAR] = {
+				{ star.x - size / 2, star.y - size / 2 + size / 8 }, { star.x + size / 2, star.y - size / 2 + size / 8 }, { star.x, star.y + size / 2 + size / 8 },
+				{ star.x - size / 2, star.y + size / 2 - size / 8 }, { star.x + size / 2, star.y + size / 2 - size / 8 }, { star.x, star.y - size / 2 - size / 8 }
+			};
+			for (SDL_FPoint corner : corners)
+			{
+				Vector2D::rotatePoint(corner.x, corner.y, star.x, star.y, elapsedTime * 50);
+				vertices.push_back(SDL_Vertex{ corner, SDL_Color{ color.r, color.g, color.b, static_cast<Uint8>(batch.getAlpha(i)) }, SDL_FPoint{ 0, 0 } });
+			}
+		}
+	}
+
+	void runStars(int starCount, int frameCount)
+	{
+		// the lifetimes and sizes World::createStar() is called with, at every point of their lives
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		const float wholeNoteLength = 60.f / BENCHMARK_BPM * 4;
+		Stars stars;
+		for (int i = 0; i < starCount; i++)
+		{
+			const int lifeTime = 1 + static_cast<int>(unit(random) * 10);
+			stars.push({ static_cast<float>(lifeTime), unit(random) * lifeTime * wholeNoteLength },
+				StarShape(unit(random) * WIDTH, unit(random) * HEIGHT, 1 + unit(random) * 5),
+				Color(200, 225, 255, static_cast<int>(55 + unit(random) * 200)));
+		}
+
+		StarBatch scalarBatch;
+		StarBatch batch;
+		StarAtlas atlas;
+		Uint64 startTicks = SDL_GetPerformanceCounter();
+		atlas.rasterize();
+		const double rasterizeSeconds = secondsSince(startTicks);
+
+		std::vector<SDL_Vertex> referenceVertices;
+		double scalarSeconds = 0, simdSeconds = 0, emitSeconds = 0, atlasSeconds = 0, referenceSeconds = 0;
+		size_t mismatches = 0;
+		size_t referenceMismatches = 0;
+		Uint64 vertexCount = 0, atlasVertexCount = 0;
+
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			const StarBatch::FrameState state = getStarFrame(frame);
+
+			startTicks = SDL_GetPerformanceCounter();
+			scalarBatch.updateScalar(stars, state);
+			scalarSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			batch.update(stars, state);
+			simdSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			vertexCount += batch.emit(stars);
+			emitSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			atlasVertexCount += batch.emit(stars, &atlas);
+			atlasSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			emitRotatingEveryVertex(stars, scalarBatch, state.elapsedTime, referenceVertices);
+			referenceSeconds += secondsSince(startTicks);
+
+			for (size_t i = 0; i < stars.size(); i++)
+			{
+				mismatches += batch.getSize(i) != scalarBatch.getSize(i) || batch.getAlpha(i) != scalarBatch.getAlpha(i);
+			}
+			// both updates could be wrong the same way, so one star is checked against the old formulas too
+			const size_t checkedStar = frame % stars.size();
+			float referenceSize, referenceAlpha;
+			getReferenceStarLook(stars.get<LifeTimeObject>(checkedStar), stars.get<StarShape>(checkedStar), stars.get<Color>(checkedStar), state, referenceSize, referenceAlpha);
+			referenceMismatches += std::abs(scalarBatch.getSize(checkedStar) - referenceSize) > 0.01f || std::abs(scalarBatch.getAlpha(checkedStar) - referenceAlpha) > 0.5f;
+		}
+
+		const double frames = (std::max)(frameCount, 1);
+		std::cout << "Updating " << starCount << " stars for " << frameCount << " frames, "
+			<< std::fixed << std::setprecision(3) << "in ms per frame:" << std::endl;
+		std::cout << "  update scalar: " << scalarSeconds * 1000 / frames << (referenceMismatches == 0 ? "" : ", differs from the old formulas!") << std::endl;
+		std::cout << "  update SSE:    " << simdSeconds * 1000 / frames << " (" << std::setprecision(2) << scalarSeconds / simdSeconds << "x)"
+			<< (mismatches == 0 ? "" : ", differs from scalar!") << std::endl;
+		std::cout << std::setprecision(3) << "  emit triangles:   " << emitSeconds * 1000 / frames << ", "
+			<< static_cast<double>(vertexCount) / frames << " vertices in one batch" << std::endl;
+		std::cout << "  emit atlas quads: " << atlasSeconds * 1000 / frames << ", "
+			<< static_cast<double>(atlasVertexCount) / frames << " vertices in one batch (rasterizing the atlas took " << rasterizeSeconds * 1000 << " ms once)" << std::endl;
+		std::cout << "  emit rotating every vertex: " << referenceSeconds * 1000 / frames << std::endl;
+		std::cout << "  total: " << (simdSeconds + atlasSeconds) * 1000 / frames << " ms against " << (scalarSeconds + referenceSeconds) * 1000 / frames
+			<< " ms per frame" << std::endl;
+	}
+
+	// Draws <objects> <frameCount> times with <draw>, advancing their lifetimes by a frame each time. Returns the milliseconds per frame
+	template<typename Storage, typename DrawFunction>
+	double timeDrawing(SDL_Renderer* renderer, Storage& objects, int frameCount, DrawFunction draw)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			SDL_SetRenderDrawColor(renderer, 0, 7, 14, 255);
+			SDL_RenderClear(renderer);
+			draw(objects);
+			// the software renderer queues the draw calls, this rasterizes them
+			SDL_RenderFlush(renderer);
+
+			objects.template forEachChunk<LifeTimeObject>([](size_t count, LifeTimeObject* lifeTimes)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					lifeTimes[i].elapsedLifeTime = fmodf(lifeTimes[i].elapsedLifeTime + FIXED_DELTA_TIME, lifeTimes[i].totalLifeTime);
+				}
+			});
+		}
+		return secondsSince(startTicks) * 1000 / frameCount;
+	}
+
+	// A software renderer drawing into <surface>, set as Rendering's renderer with the generated textures loaded
+	SDL_Renderer* beginSoftwareRendering(SDL_Surface*& surface)
+	{
+		surface = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+		SDL_Renderer* renderer = surface != nullptr ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+		if (renderer == nullptr)
+		{
+			std::cout << "Failed to create the software renderer! SDL Error: " << SDL_GetError() << std::endl;
+			SDL_FreeSurface(surface);
+			return nullptr;
+		}
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		Rendering::setRenderer(renderer);
+		Rendering::loadGeneratedTextures();
+		return renderer;
+	}
+
+	void endSoftwareRendering(SDL_Renderer* renderer, SDL_Surface* surface)
+	{
+		Rendering::unloadGeneratedTextures();
+		Rendering::setRenderer(nullptr);
+		SDL_DestroyRenderer(renderer);
+		SDL_FreeSurface(surface);
+	}
+
+	void runLasers(int laserCount, int frameCount)
+	{
+		SDL_Surface* surface;
+		SDL_Renderer* renderer = beginSoftwareRendering(surface);
+		if (renderer == nullptr) return;
+
+		// fired from where the player stands, spread over the top of the screen and over their lifetime
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		const Position playerPos(WIDTH / 2 - playerRadius / 2, HEIGHT * 0.8f, playerRadius);
+		Lasers lasers;
+		for (int i = 0; i < laserCount; i++)
+		{
+			const float elapsedLifeTime = LASER_DEFAULT_LIFETIME * i / laserCount;
+			const Line line{ playerPos.x, playerPos.y, unit(random) * WIDTH, unit(random) * HEIGHT * 0.6f };
+			lasers.push({ LASER_DEFAULT_LIFETIME, elapsedLifeTime }, line, i % 4 == 0 ? Color(255, 0, 0, 255) : Color(0, 200, 255, 255));
+		}
+
+		std::cout << "Drawing " << laserCount << " lasers for " << frameCount << " frames at " << WIDTH << "x" << HEIGHT << " with the software renderer" << std::endl;
+		const double linesMilliseconds = timeDrawing(renderer, lasers, frameCount, [playerPos](const Lasers& lasers) { Rendering::drawLaserLines(lasers, playerPos); });
+		const double batchMilliseconds = timeDrawing(renderer, lasers, frameCount, [playerPos](const Lasers& lasers) { Rendering::drawLasers(lasers, playerPos); });
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "  line by line:  " << linesMilliseconds << " ms per frame" << std::endl;
+		std::cout << "  strips:        " << batchMilliseconds << " ms per frame (" << std::setprecision(2) << linesMilliseconds / batchMilliseconds << "x)" << std::endl;
+
+		endSoftwareRendering(renderer, surface);
+	}
+
+	void runFadingObjects(int objectCount, int frameCount)
+	{
+		SDL_Surface* surface;
+		SDL_Renderer* renderer = beginSoftwareRendering(surface);
+		if (renderer == nullptr) return;
+
+		// a plain disc stands in for the asteroid textures, they're bound to the game's renderer
+		constexpr int SPRITE_SIZE = 64;
+		std::vector<Uint32> spritePixels(SPRITE_SIZE * SPRITE_SIZE);
+		for (int i = 0; i < SPRITE_SIZE * SPRITE_SIZE; i++)
+		{
+			const float x = i % SPRITE_SIZE - SPRITE_SIZE / 2 + 0.5f, y = i / SPRITE_SIZE - SPRITE_SIZE / 2 + 0.5f;
+			spritePixels[i] = x * x + y * y < SPRITE_SIZE * SPRITE_SIZE / 4 ? 0xB0B0B0FF : 0;
+		}
+		SDL_Texture* sprite = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, SPRITE_SIZE, SPRITE_SIZE);
+		SDL_UpdateTexture(sprite, nullptr, spritePixels.data(), SPRITE_SIZE * 4);
+		SDL_SetTextureBlendMode(sprite, SDL_BLENDMODE_BLEND);
+		const AssetCache::TextureHandle spriteHandle = AssetCache::addTexture("benchmark sprite", sprite);
+
+		// the fragments of a wave clear, at every point of their fade out, some of them at the health line
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		ObjectsPendingDeletion objects;
+		for (int i = 0; i < objectCount; i++)
+		{
+			const Position position(unit(random) * WIDTH, unit(random) * HEIGHT, 5 + unit(random) * 45);
+			const Appearance appearance{ spriteHandle };
+			objects.push({ OBJECT_FADEOUT_TIME, OBJECT_FADEOUT_TIME * i / objectCount }, position, appearance, Rotation(0, unit(random) * 360));
+		}
+
+		std::cout << "Drawing " << objectCount << " objects fading out for " << frameCount << " frames at " << WIDTH << "x" << HEIGHT << " with the software renderer" << std::endl;
+		const double linesMilliseconds = timeDrawing(renderer, objects, frameCount, Rendering::drawObjectsFadingOutLines);
+		const double batchMilliseconds = timeDrawing(renderer, objects, frameCount, Rendering::drawObjectsFadingOut);
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "  ring by ring:  " << linesMilliseconds << " ms per frame" << std::endl;
+		std::cout << "  glow atlas:    " << batchMilliseconds << " ms per frame (" << std::setprecision(2) << linesMilliseconds / batchMilliseconds << "x)" << std::endl;
+
+		AssetCache::unloadAll();
+		endSoftwareRendering(renderer, surface);
+	}
+
+	// The note timings of a song at BENCHMARK_BPM, <frame> frames in
+	MusicData getBeatFrame(int frame)
+	{
+		const float elapsedTime = frame * FIXED_DELTA_TIME;
+		MusicData music;
+		music.musicIsPlaying = true;
+		music.quarterNoteLength = 60.f / BENCHMARK_BPM;
+		music.halfNoteLength = music.quarterNoteLength * 2;
+		music.wholeNoteLength = music.quarterNoteLength * 4;
+		music.timeSinceLastQuarterNote = fmodf(elapsedTime, music.quarterNoteLength);
+		music.timeSinceLastHalfNote = fmodf(elapsedTime, music.halfNoteLength);
+		music.timeSinceLastWholeNote = fmodf(elapsedTime, music.wholeNoteLength);
+		music.quarterNoteProgress = music.timeSinceLastQuarterNote / music.quarterNoteLength;
+		music.halfNoteProgress = music.timeSinceLastHalfNote / music.halfNoteLength;
+		music.wholeNoteProgress = music.timeSinceLastWholeNote / music.wholeNoteLength;
+		return music;
+	}
+
+	void runBeatCircles(int objectCount, int frameCount)
+	{
+		SDL_Surface* surface;
+		SDL_Renderer* renderer = beginSoftwareRendering(surface);
+		if (renderer == nullptr) return;
+
+		// asteroids of every note size, a few of them disabled, the first one stands in for the player
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+		MovableObjects objects;
+		for (int i = 0; i < objectCount; i++)
+		{
+			const Position position(unit(random) * WIDTH, unit(random) * HEIGHT, 10 + unit(random) * 60);
+			objects.push(position, Velocity(0, 0), Rotation(0, 0), Appearance{}, i % 10 == 9 ? Tag::Unsplittable : Tag::Asteroid);
+		}
+		constexpr size_t PLAYER_INDEX = 0;
+		const float mouseX = WIDTH / 2.f, mouseY = HEIGHT / 2.f;
+		const SDL_FRect screen{ 0, 0, WIDTH, HEIGHT };
+
+		BeatCircleBatch scalarBatch;
+		BeatCircleBatch batch;
+		double scalarSeconds = 0, simdSeconds = 0, emitSeconds = 0;
+		size_t mismatches = 0;
+		Uint64 indexCount = 0;
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			const MusicData music = getBeatFrame(frame);
+
+			Uint64 startTicks = SDL_GetPerformanceCounter();
+			scalarBatch.classifyScalar(objects, PLAYER_INDEX, music, mouseX, mouseY, screen);
+			scalarSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			batch.classify(objects, PLAYER_INDEX, music, mouseX, mouseY, screen);
+			simdSeconds += secondsSince(startTicks);
+
+			startTicks = SDL_GetPerformanceCounter();
+			indexCount += batch.emit(Detail::Full);
+			emitSeconds += secondsSince(startTicks);
+
+			for (int bucket = 0; bucket < static_cast<int>(BeatCircleBatch::Bucket::Count); bucket++)
+			{
+				const std::vector<BeatCircleBatch::Circle>& circles = batch.getCircles(static_cast<BeatCircleBatch::Bucket>(bucket));
+				const std::vector<BeatCircleBatch::Circle>& scalarCircles = scalarBatch.getCircles(static_cast<BeatCircleBatch::Bucket>(bucket));
+				mismatches += circles.size() != scalarCircles.size();
+				for (size_t i = 0; i < (std::min)(circles.size(), scalarCircles.size()); i++)
+				{
+					mismatches += circles[i].distanceMultiplier != scalarCircles[i].distanceMultiplier;
+				}
+			}
+		}
+
+		// the draw functions read the mouse themselves, without a window it's at 0, 0
+		const auto timeBeatCircles = [&](auto draw)
+		{
+			const Uint64 startTicks = SDL_GetPerformanceCounter();
+			for (int frame = 0; frame < frameCount; frame++)
+			{
+				MusicData music = getBeatFrame(frame);
+				SDL_SetRenderDrawColor(renderer, 0, 7, 14, 255);
+				SDL_RenderClear(renderer);
+				draw(&music, objects, PLAYER_INDEX);
+				SDL_RenderFlush(renderer);
+			}
+			return secondsSince(startTicks) * 1000 / frameCount;
+		};
+		const double linesMilliseconds = timeBeatCircles(Rendering::drawBeatCircleLines);
+		const double batchMilliseconds = timeBeatCircles(Rendering::drawBeatCircles);
+
+		const double frames = (std::max)(frameCount, 1);
+		std::cout << "Drawing the beat circles of " << objectCount << " objects for " << frameCount << " frames at " << WIDTH << "x" << HEIGHT
+			<< " with the software renderer" << std::endl;
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "  classify scalar: " << scalarSeconds * 1000 / frames << " ms per frame" << std::endl;
+		std::cout << "  classify SSE:    " << simdSeconds * 1000 / frames << " ms per frame (" << std::setprecision(2) << scalarSeconds / simdSeconds << "x)"
+			<< (mismatches == 0 ? "" : ", differs from scalar!") << std::endl;
+		std::cout << std::setprecision(3) << "  emit:            " << emitSeconds * 1000 / frames << " ms per frame, "
+			<< static_cast<double>(indexCount) / frames / BeatCircleBatch::INDICES_PER_RING << " rings in one batch" << std::endl;
+		std::cout << "  object by object: " << linesMilliseconds << " ms per frame" << std::endl;
+		std::cout << "  batched:          " << batchMilliseconds << " ms per frame (" << std::setprecision(2) << linesMilliseconds / batchMilliseconds << "x)" << std::endl;
+
+		endSoftwareRendering(renderer, surface);
+	}
+
+	void runRasterizer(int frameCount, int threadCount, const char* wavesPath, const char* pngPath)
+	{
+		// headless worlds don't load any textures, all their objects have INVALID_TEXTURE
+		constexpr int SPRITE_SIZE = 64;
+		const std::vector<Uint8> spritePixels = HeadlessWorld::createStandInSprite(SPRITE_SIZE);
+		const SoftwareRasterizer::Texture sprite{ spritePixels.data(), SPRITE_SIZE, SPRITE_SIZE };
+
+		struct Pass
+		{
+			SoftwareRasterizer rasterizer;
+			double submitSeconds = 0;
+			double rasterizeSeconds = 0;
+
+			explicit Pass(int threadCount) : rasterizer(WIDTH, HEIGHT, threadCount) {}
+		};
+		Pass passes[2] = { Pass(1), Pass(threadCount) };
+		for (Pass& pass : passes)
+		{
+			pass.rasterizer.setTexture(AssetCache::INVALID_TEXTURE, sprite);
+		}
+
+		std::cout << "Drawing " << frameCount << " frames of a world at " << WIDTH << "x" << HEIGHT << " with the software rasterizer, "
+			<< "in tiles of " << SoftwareRasterizer::TILE_SIZE << " pixels on 1 and " << threadCount << " threads" << std::endl;
+
+		HeadlessWorld headlessWorld(wavesPath, BENCHMARK_BPM);
+		FrameSnapshot frame;
+		constexpr int PLAYER_HEALTH = 12; // full
+		size_t peakObjectCount = 0;
+		int differentFrames = 0;
+		for (int frameIndex = 0; frameIndex < frameCount; frameIndex++)
+		{
+			headlessWorld.step();
+			frame.record(headlessWorld.world, headlessWorld.getMusic(), PLAYER_HEALTH);
+			peakObjectCount = (std::max)(peakObjectCount, frame.objects.size() + frame.objectsToDelete.size());
+
+			for (Pass& pass : passes)
+			{
+				Rendering::setRasterizer(&pass.rasterizer);
+				Uint64 startTicks = SDL_GetPerformanceCounter();
+				Rendering::renderClear();
+				Engine::drawEverything(frame);
+				pass.submitSeconds += secondsSince(startTicks);
+
+				startTicks = SDL_GetPerformanceCounter();
+				Rendering::renderPresent();
+				pass.rasterizeSeconds += secondsSince(startTicks);
+			}
+			// the tiles are split differently between the threads every frame, the pixels have to come out the same
+			const size_t pixelCount = static_cast<size_t>(passes[0].rasterizer.getStride()) * HEIGHT;
+			differentFrames += !std::equal(passes[0].rasterizer.getPixels(), passes[0].rasterizer.getPixels() + pixelCount, passes[1].rasterizer.getPixels());
+		}
+		Rendering::setRasterizer(nullptr);
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "  peak objects: " << peakObjectCount << std::endl;
+		for (const Pass& pass : passes)
+		{
+			std::cout << "  " << pass.rasterizer.getThreadCount() << " thread(s): " << pass.submitSeconds * 1000 / frameCount << " ms per frame to record, "
+				<< pass.rasterizeSeconds * 1000 / frameCount << " ms to rasterize" << std::endl;
+		}
+		std::cout << "  " << std::setprecision(2) << passes[0].rasterizeSeconds / passes[1].rasterizeSeconds << "x faster on " << threadCount << " threads, "
+			<< (differentFrames == 0 ? "every frame the same" : std::to_string(differentFrames) + " frames differ!") << std::endl;
+
+		if (pngPath != nullptr && passes[1].rasterizer.savePNG(pngPath))
+			std::cout << "  saved the last frame to " << pngPath << std::endl;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/// <summary>
+/// Headless benchmarks, started with command line arguments (see main.cpp).
+/// Nothing in here opens a window or plays audio, so it can run on machines without a GPU.
+/// </summary>
+namespace Benchmark
+{
+	// Simulates <worldCount> worlds, one per thread, spawning asteroids from the given wave file.
+	// Prints the throughput of each world and in total.
+	void runWorlds(int worldCount, int frameCount, const char* wavesPath);
+
+	// Mixes <voiceCount> stereo voices into buffers of <bufferFrames> frames, with every MixKernel path the CPU supports.
+	// Prints how many voices are mixed per millisecond of callback time, and how many fit in the time a buffer lasts.
+	void runMixer(int voiceCount, int bufferFrames);
+
+	// Works out the look of <starCount> stars for <frameCount> frames with StarBatch, with and without SSE, and writes their triangles or atlas quads.
+	// Prints the time per frame of each step, next to rotating every vertex on its own the way stars used to be drawn.
+	void runStars(int starCount, int frameCount);
+
+	// Draws <laserCount> lasers at every point of their lifetime for <frameCount> frames with SDL's software renderer,
+	// line by line and as one batch of strips. Prints the frame time of both.
+	void runLasers(int laserCount, int frameCount);
+
+	// The same for <objectCount> objects fading out, their hexagon rings drawn one by one and from the glow atlas
+	void runFadingObjects(int objectCount, int frameCount);
+
+	// Sorts <objectCount> objects into beat circle buckets for <frameCount> frames of a song, with and without SSE,
+	// and draws their hexagons object by object and as one batch with the software renderer. Prints the time per frame of each
+	void runBeatCircles(int objectCount, int frameCount);
+
+	// Simulates a world with the waves in <wavesPath> for <frameCount> frames and draws every frame with Engine::drawEverything()
+	// into a SoftwareRasterizer, on 1 and on <threadCount> threads. Prints the time to record and to rasterize a frame with each,
+	// and whether they drew the same pixels. The last frame is saved to <pngPath>, unless it's nullptr
+	void runRasterizer(int frameCount, int threadCount, const char* wavesPath, const char* pngPath);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+/// <summary>
+/// Stores all entities of one kind in fixed size (16 KB) chunks.
+/// Inside a chunk each component has its own array (structure of arrays),
+/// so a loop that only needs positions only touches position memory,
+/// and the chunks themselves are never moved when the storage grows.
+///
+/// An entity is still just an index: (index >> CHUNK_SHIFT) is the chunk and
+/// (index & SLOT_MASK) the slot in each of the chunk's component arrays.
+/// Each component type can only be used once per storage, since components are looked up by type.
+/// </summary>
+template<typename... Components>
+struct ChunkedStorage
+{
+	static constexpr size_t CHUNK_BYTES = 16 * 1024;
+	static constexpr size_t BYTES_PER_ENTITY = (sizeof(Components) + ...);
+	// rounded down to a power of two, so finding an entity's chunk is a shift instead of a division
+	static constexpr size_t CHUNK_CAPACITY = std::bit_floor(CHUNK_BYTES / BYTES_PER_ENTITY);
+	static constexpr size_t CHUNK_SHIFT = std::countr_zero(CHUNK_CAPACITY);
+	static constexpr size_t SLOT_MASK = CHUNK_CAPACITY - 1;
+
+private:
+	template<typename C>
+	using Column = std::array<C, CHUNK_CAPACITY>;
+
+	struct Chunk
+	{
+		std::tuple<Column<Components>...> columns;
+	};
+
+	// chunks are kept when entities are removed, so they can be reused without allocating
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	size_t count = 0;
+
+	// Calls function(index, components...) for every entity, one chunk at a time
+	template<typename... Cs, typename Self, typename F>
+	static void iterate(Self& self, F& function)
+	{
+		for (size_t first = 0, chunkIndex = 0; first < self.count; first += CHUNK_CAPACITY, chunkIndex++)
+		{
+			auto& columns = self.chunks[chunkIndex]->columns;
+			const size_t slotCount = self.count - first < CHUNK_CAPACITY ? self.count - first : CHUNK_CAPACITY;
+			for (size_t slot = 0; slot < slotCount; slot++)
+			{
+				function(first + slot, std::get<Column<Cs>>(columns)[slot]...);
+			}
+		}
+	}
+
+	// Calls function(slotCount, componentArrays...) for every chunk, for loops that work on whole arrays
+	template<typename... Cs, typename Self, typename F>
+	static void iterateChunks(Self& self, F& function)
+	{
+		for (size_t first = 0, chunkIndex = 0; first < self.count; first += CHUNK_CAPACITY, chunkIndex++)
+		{
+			auto& columns = self.chunks[chunkIndex]->columns;
+			const size_t slotCount = self.count - first < CHUNK_CAPACITY ? self.count - first : CHUNK_CAPACITY;
+			function(slotCount, std::get<Column<Cs>>(columns).data()...);
+		}
+	}
+
+public:
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	// Adds an entity at the end and returns its index
+	size_t push(const Components&... components)
+	{
+		if ((count >> CHUNK_SHIFT) >= chunks.size())
+			chunks.push_back(std::make_unique<Chunk>());
+
+		const size_t index = count++;
+		((get<Components>(index) = components), ...);
+		return index;
+	}
+
+	template<typename C>
+	C& get(size_t index)
+	{
+		return std::get<Column<C>>(chunks[index >> CHUNK_SHIFT]->columns)[index & SLOT_MASK];
+	}
+	template<typename C>
+	const C& get(size_t index) const
+	{
+		return std::get<Column<C>>(chunks[index >> CHUNK_SHIFT]->columns)[index & SLOT_MASK];
+	}
+
+	void swap(size_t a, size_t b)
+	{
+		(std::swap(get<Components>(a), get<Components>(b)), ...);
+	}
+
+	// Removes an entity by moving the last entity into its place, so the order is not kept
+	void removeSwapBack(size_t index)
+	{
+		const size_t last = count - 1;
+		if (index != last)
+			((get<Components>(index) = get<Components>(last)), ...);
+		count--;
+	}
+
+	void clear() { count = 0; }
+
+	// Makes this a copy of <other>, reusing the chunks it already has
+	void copyFrom(const ChunkedStorage& other)
+	{
+		for (size_t first = 0, chunkIndex = 0; first < other.count; first += CHUNK_CAPACITY, chunkIndex++)
+		{
+			if (chunkIndex >= chunks.size())
+				chunks.push_back(std::make_unique<Chunk>());
+			*chunks[chunkIndex] = *other.chunks[chunkIndex];
+		}
+		count = other.count;
+	}
+
+	template<typename... Cs, typename F>
+	void forEach(F function) { iterate<Cs...>(*this, function); }
+	template<typename... Cs, typename F>
+	void forEach(F function) const { iterate<Cs...>(*this, function); }
+
+	template<typename... Cs, typename F>
+	void forEachChunk(F function) { iterateChunks<Cs...>(*this, function); }
+	template<typename... Cs, typename F>
+	void forEachChunk(F function) const { iterateChunks<Cs...>(*this, function); }
+};
@@ -6,11 +6,12 @@
 #include "SDL_image.h"
 #include "rendering.h"
 
-Crosshair::Crosshair(int width, int height, const char* path, SDL_Renderer* render)
+Crosshair::Crosshair(int width, int height, const char* path)
 {
 	rect.w = width;
 	rect.h = height;
-	texture = IMG_LoadTexture(render, path);
+	handle = AssetCache::acquireTexture(path);
+	texture = AssetCache::getTexture(handle);
 	SDL_ShowCursor(false);
 }
 
@@ -22,11 +23,16 @@ void Crosshair::draw(SDL_Renderer* render, float quarterProgress, float timeSinc
 	rect.x -= rect.w / 2;
 	rect.y -= rect.h / 2;
 
+	// the texture is shared through AssetCache, its tint is set for every draw. It fades from red back to white after a failed shot
+	const bool isFailing = timeSinceLastFail > 0 && timeSinceLastFail < 2;
+	const Uint8 textureColorValue = isFailing ? static_cast<Uint8>(255 * std::clamp(timeSinceLastFail / 1.f, 0.f, 1.f)) : 255;
+	SDL_SetTextureColorMod(texture, 255, textureColorValue, textureColorValue);
+
 	// render texture
 	SDL_RenderCopy(render, texture, NULL, &rect);
 
 	Color color = normalColor;
-	if (timeSinceLastFail > 0 && timeSinceLastFail < 2)
+	if (isFailing)
 	{
 		color = Color{
 			std::lerp(static_cast<float>(failColor.r), static_cast<float>(normalColor.r), timeSinceLastFail / 2.f),
@@ -34,9 +40,6 @@ void Crosshair::draw(SDL_Renderer* render, float quarterProgress, float timeSinc
 			std::lerp(static_cast<float>(failColor.b), static_cast<float>(normalColor.b), timeSinceLastFail / 2.f),
 			255.f
 		};
-
-		const UINT8 textureColorValue = static_cast<UINT8>(255 * std::clamp(timeSinceLastFail / 1.f, 0.f, 1.f));
-		SDL_SetTextureColorMod(texture, 255, textureColorValue, textureColorValue);
 	}
 
 	const int layerCount = static_cast<int>(std::lerp(12.f, 6.f, Ease::Out(quarterProgress, 3)));
@@ -46,7 +49,7 @@ void Crosshair::draw(SDL_Renderer* render, float quarterProgress, float timeSinc
 		float multiplier = 1 - (static_cast<float>(j) / static_cast<float>(layerCount));
 		multiplier = powf(multiplier, 2);
 
-		const auto a = static_cast<UINT8>(255 * multiplier * (1 - (Ease::Out(quarterProgress, 5) * 0.9f)));
+		const auto a = static_cast<Uint8>(255 * multiplier * (1 - (Ease::Out(quarterProgress, 5) * 0.9f)));
 		color = color.multiplied(multiplier);
 		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, a);
 		Rendering::drawHexagon(mouseX + 0.4f, mouseY + 0.4f, (8 + j + 7.f), 0.5f);
@@ -56,5 +59,5 @@ void Crosshair::draw(SDL_Renderer* render, float quarterProgress, float timeSinc
 
 void Crosshair::destroy()
 {
-	SDL_DestroyTexture(texture);
+	AssetCache::releaseTexture(handle);
 }
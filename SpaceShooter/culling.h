@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL.h>
+
+/// <summary>
+/// Skips objects before their draw calls are submitted when nothing they draw reaches the screen.
+/// Asteroids spawn above the top edge and are only removed well past it, so a lot of them are off screen.
+/// </summary>
+namespace Culling
+{
+	// Every object around it, the sprites and the rings, fits in a circle of <extent> around <x>, <y>
+	inline bool isVisible(const SDL_FRect& view, float x, float y, float extent)
+	{
+		return x + extent >= view.x && x - extent <= view.x + view.w
+			&& y + extent >= view.y && y - extent <= view.y + view.h;
+	}
+
+	// How many objects a layer drew and how many it skipped, summed over all frames
+	struct Counts
+	{
+		Uint64 visible = 0;
+		Uint64 culled = 0;
+	};
+}
@@ -7,7 +7,7 @@
  size_t getAddress(std::function<T(U...)> f) {
      typedef T(fnType)(U...);
      fnType** fnPointer = f.template target<fnType*>();
-     return (size_t)*fnPointer;
+     return fnPointer == nullptr ? 0 : (size_t)*fnPointer; // lambdas/bound functions have no plain address
  }
 
  /// <summary>
@@ -17,19 +17,37 @@
  template<class T>
  struct Delegate {
      std::vector<T> funcs;
-     Delegate& operator+=(T mFunc) { funcs.push_back(mFunc); return *this; }
+     std::vector<const void*> owners; // the instance each function belongs to (nullptr for static functions)
+
+     Delegate& operator+=(T mFunc) { funcs.push_back(mFunc); owners.push_back(nullptr); return *this; }
      Delegate& operator-=(T mFunc)
      {
          // couldn't get == overloading to work, so this is a workaround
          for (int i = 0; i < funcs.size(); i++)
          {
-             if (getAddress(funcs[i]) == getAddress(mFunc))
+             if (owners[i] == nullptr && getAddress(funcs[i]) == getAddress(mFunc))
              {
                  funcs.erase(funcs.begin() + i);
+                 owners.erase(owners.begin() + i);
              }
          }
          return *this;
      }
+
+     // Non-static methods are added as lambdas, which can't be compared by address,
+     // so they are registered together with their instance and removed by it instead
+     void subscribe(const void* owner, T mFunc) { funcs.push_back(mFunc); owners.push_back(owner); }
+     void unsubscribe(const void* owner)
+     {
+         for (size_t i = funcs.size(); i >= 1; i--)
+         {
+             if (owners[i - 1] == owner)
+             {
+                 funcs.erase(funcs.begin() + (i - 1));
+                 owners.erase(owners.begin() + (i - 1));
+             }
+         }
+     }
      void operator()() { for (auto& f : funcs) f(); }
  };
 
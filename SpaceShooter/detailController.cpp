@@ -0,0 +1,69 @@
+#include "detailController.h"
+#include <algorithm>
+
+void DetailController::update(float frameMilliseconds, size_t objectCount)
+{
+	constexpr int lowest = static_cast<int>(Detail::Minimal);
+
+	if (frameMilliseconds > FRAME_BUDGET)
+	{
+		fastFrames = 0;
+		if (++slowFrames >= FRAMES_TO_LOWER)
+		{
+			timeLevel = (std::min)(timeLevel + 1, lowest);
+			slowFrames = 0;
+		}
+	}
+	else if (frameMilliseconds < FRAME_BUDGET * RAISE_BELOW)
+	{
+		slowFrames = 0;
+		if (++fastFrames >= FRAMES_TO_RAISE)
+		{
+			timeLevel = (std::max)(timeLevel - 1, 0);
+			fastFrames = 0;
+		}
+	}
+	else
+	{
+		// close to the budget, keep the detail as it is
+		slowFrames = 0;
+		fastFrames = 0;
+	}
+
+	// the object count lowers the detail right away, but has to drop a bit below where it started to raise it
+	const size_t levelStarts[] = { 0, REDUCED_OBJECT_COUNT, MINIMAL_OBJECT_COUNT };
+	while (objectLevel < lowest && objectCount >= levelStarts[objectLevel + 1])
+	{
+		objectLevel++;
+	}
+	while (objectLevel > 0 && objectCount < levelStarts[objectLevel] * RAISE_OBJECT_FRACTION)
+	{
+		objectLevel--;
+	}
+
+	const Detail previous = detail;
+	detail = static_cast<Detail>((std::max)(timeLevel, objectLevel));
+	changes += detail != previous;
+	framesAt[static_cast<int>(detail)]++;
+}
+
+Detail DetailController::getDetail() const
+{
+	return detail;
+}
+
+const char* DetailController::getName(Detail detail)
+{
+	const char* names[] = { "full", "reduced", "minimal" };
+	return names[static_cast<int>(detail)];
+}
+
+Uint64 DetailController::getFrameCount(Detail detail) const
+{
+	return framesAt[static_cast<int>(detail)];
+}
+
+Uint64 DetailController::getChangeCount() const
+{
+	return changes;
+}
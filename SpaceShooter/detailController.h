@@ -0,0 +1,44 @@
+#pragma once
+#include <SDL.h>
+
+// How much of the effects around the objects is drawn, see DetailController
+enum class Detail { Full, Reduced, Minimal, Count };
+
+/// <summary>
+/// Lowers the detail of the beat circles, the glows of the objects fading out and the lasers when the frames
+/// take longer than the frame rate allows or there are a lot of objects, and brings it back when the load drops.
+///
+/// The detail only goes down after a few slow frames in a row, and only comes back up after a couple of seconds
+/// of frames well inside the budget, so it doesn't flip back and forth at the edge.
+/// </summary>
+struct DetailController
+{
+	static constexpr float FRAME_BUDGET = 1000.f / 120; // in ms, the frame rate Engine::delayNextFrame() keeps
+	static constexpr float RAISE_BELOW = 0.6f; // of the budget
+	static constexpr int FRAMES_TO_LOWER = 15;
+	static constexpr int FRAMES_TO_RAISE = 240;
+	// Objects, fading objects and lasers together, from which on the detail is lowered regardless of the frame time
+	static constexpr size_t REDUCED_OBJECT_COUNT = 400;
+	static constexpr size_t MINIMAL_OBJECT_COUNT = 1000;
+	static constexpr float RAISE_OBJECT_FRACTION = 0.8f; // of the count a level starts at
+
+private:
+	Detail detail = Detail::Full;
+	int timeLevel = 0; // lowered by slow frames
+	int objectLevel = 0; // lowered by the object count
+	int slowFrames = 0;
+	int fastFrames = 0;
+
+	Uint64 framesAt[static_cast<int>(Detail::Count)] = {};
+	Uint64 changes = 0;
+
+public:
+	// Call once per frame with the time the frame took before waiting for the next one
+	void update(float frameMilliseconds, size_t objectCount);
+	Detail getDetail() const;
+
+	static const char* getName(Detail detail);
+	// How many frames were drawn at <detail>, and how often it changed
+	Uint64 getFrameCount(Detail detail) const;
+	Uint64 getChangeCount() const;
+};
@@ -10,12 +10,12 @@ class Ease
 public:
 	static float In(float x, int power)
 	{
-		return std::powf(x, static_cast<float>(power));
+		return std::pow(x, static_cast<float>(power));
 	}
 
 	static float Out(float x, int power)
 	{
-		return 1 - std::powf(1 - x, static_cast<float>(power));
+		return 1 - std::pow(1 - x, static_cast<float>(power));
 	}
 
 	static float InOutSine(float x)
@@ -0,0 +1,91 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+#include <xmmintrin.h>
+
+FFT::FFT(int size) : size(size), bitReversed(size), twiddleReal(size > 1 ? size - 1 : 0), twiddleImaginary(twiddleReal.size())
+{
+	int bits = 0;
+	while ((1 << bits) < size) bits++;
+	for (int i = 0; i < size; i++)
+	{
+		int reversed = 0;
+		for (int bit = 0; bit < bits; bit++)
+		{
+			if (i & (1 << bit))
+				reversed |= 1 << (bits - 1 - bit);
+		}
+		bitReversed[i] = reversed;
+	}
+
+	const double pi = 3.14159265358979323846;
+	for (int half = 1; half < size; half *= 2)
+	{
+		for (int k = 0; k < half; k++)
+		{
+			const double angle = -pi * k / half;
+			twiddleReal[half - 1 + k] = static_cast<float>(std::cos(angle));
+			twiddleImaginary[half - 1 + k] = static_cast<float>(std::sin(angle));
+		}
+	}
+}
+
+void FFT::forward(float* real, float* imaginary) const
+{
+	for (int i = 0; i < size; i++)
+	{
+		const int j = bitReversed[i];
+		if (i < j)
+		{
+			std::swap(real[i], real[j]);
+			std::swap(imaginary[i], imaginary[j]);
+		}
+	}
+
+	for (int half = 1; half < size; half *= 2)
+	{
+		const float* wReal = twiddleReal.data() + half - 1;
+		const float* wImaginary = twiddleImaginary.data() + half - 1;
+		for (int group = 0; group < size; group += half * 2)
+		{
+			float* aReal = real + group;
+			float* aImaginary = imaginary + group;
+			float* bReal = aReal + half;
+			float* bImaginary = aImaginary + half;
+
+			int k = 0;
+			// the first two stages are too short for four butterflies at a time
+			for (; half >= 4 && k < half; k += 4)
+			{
+				const __m128 wr = _mm_loadu_ps(wReal + k);
+				const __m128 wi = _mm_loadu_ps(wImaginary + k);
+				const __m128 br = _mm_loadu_ps(bReal + k);
+				const __m128 bi = _mm_loadu_ps(bImaginary + k);
+				const __m128 ar = _mm_loadu_ps(aReal + k);
+				const __m128 ai = _mm_loadu_ps(aImaginary + k);
+
+				// t = b * w
+				const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+				const __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+				_mm_storeu_ps(bReal + k, _mm_sub_ps(ar, tr));
+				_mm_storeu_ps(bImaginary + k, _mm_sub_ps(ai, ti));
+				_mm_storeu_ps(aReal + k, _mm_add_ps(ar, tr));
+				_mm_storeu_ps(aImaginary + k, _mm_add_ps(ai, ti));
+			}
+			for (; k < half; k++)
+			{
+				const float tr = bReal[k] * wReal[k] - bImaginary[k] * wImaginary[k];
+				const float ti = bReal[k] * wImaginary[k] + bImaginary[k] * wReal[k];
+				bReal[k] = aReal[k] - tr;
+				bImaginary[k] = aImaginary[k] - ti;
+				aReal[k] += tr;
+				aImaginary[k] += ti;
+			}
+		}
+	}
+}
+
+int FFT::getSize() const
+{
+	return size;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+
+/// <summary>
+/// An in-place radix-2 FFT, with the real and imaginary parts in separate arrays so the butterflies
+/// can be done four at a time with SSE. The twiddle factors and the bit reversal are computed once per size.
+/// </summary>
+struct FFT
+{
+private:
+	int size = 0;
+	std::vector<int> bitReversed;
+	// every stage's twiddles after each other, the stage with half size m starts at m - 1
+	std::vector<float> twiddleReal;
+	std::vector<float> twiddleImaginary;
+
+public:
+	// <size> has to be a power of two
+	explicit FFT(int size);
+
+	void forward(float* real, float* imaginary) const;
+	int getSize() const;
+};
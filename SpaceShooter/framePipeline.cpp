@@ -0,0 +1,98 @@
+#include "framePipeline.h"
+#include <iomanip>
+#include <iostream>
+#include "game.h"
+
+void FrameSnapshot::record(const World& world, const MusicData& musicData, int remainingHealth)
+{
+	objects.copyFrom(world.objects);
+	lasers.copyFrom(world.lasers);
+	objectsToDelete.copyFrom(world.objectsToDelete);
+	stars.copyFrom(world.stars);
+	playerIndex = world.playerIndex;
+	playerPos = world.getPlayerPos();
+	elapsedTime = world.elapsedTime;
+	music = musicData;
+	playerHealth = remainingHealth;
+}
+
+FramePipeline::FramePipeline(Step step, bool isThreaded) : step(std::move(step)), isThreaded(isThreaded)
+{
+	if (isThreaded)
+		worker = std::thread(&FramePipeline::run, this);
+}
+
+FramePipeline::~FramePipeline()
+{
+	if (!worker.joinable()) return;
+	{
+		std::lock_guard lock(mutex);
+		isQuitting = true;
+	}
+	stepReady.notify_one();
+	worker.join();
+}
+
+// Runs on the worker thread, one step per beginStep()
+void FramePipeline::run()
+{
+	std::unique_lock lock(mutex);
+	while (true)
+	{
+		stepReady.wait(lock, [this] { return hasStep || isQuitting; });
+		if (isQuitting) return;
+
+		// drawnFrame only changes in endStep(), after this step is done
+		lock.unlock();
+		step(frames[1 - drawnFrame]);
+		lock.lock();
+
+		hasStep = false;
+		stepDone.notify_one();
+	}
+}
+
+void FramePipeline::beginStep()
+{
+	if (!isThreaded)
+	{
+		step(frames[1 - drawnFrame]);
+		return;
+	}
+	{
+		std::lock_guard lock(mutex);
+		hasStep = true;
+	}
+	stepReady.notify_one();
+}
+
+void FramePipeline::endStep()
+{
+	if (isThreaded)
+	{
+		const Uint64 startTicks = SDL_GetPerformanceCounter();
+		std::unique_lock lock(mutex);
+		stepDone.wait(lock, [this] { return !hasStep; });
+		waitTicks += SDL_GetPerformanceCounter() - startTicks;
+	}
+	drawnFrame = 1 - drawnFrame;
+	steps++;
+}
+
+FrameSnapshot& FramePipeline::getDrawnFrame()
+{
+	return frames[drawnFrame];
+}
+
+void FramePipeline::printStats() const
+{
+	if (steps == 0) return;
+	if (!isThreaded)
+	{
+		std::cout << "Frame pipeline: " << steps << " steps, simulated and drawn one after the other" << std::endl;
+		return;
+	}
+	const double waitMilliseconds = 1000.0 * static_cast<double>(waitTicks) / SDL_GetPerformanceFrequency();
+	std::cout << "Frame pipeline: " << steps << " steps, waited " << std::fixed << std::setprecision(3) << waitMilliseconds / steps
+		<< " ms per frame for the simulation after drawing" << std::endl;
+}
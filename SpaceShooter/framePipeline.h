@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <SDL.h>
+#include "gameObject.h"
+#include "musicManager.h"
+
+using namespace GameObject;
+struct World;
+
+/// <summary>
+/// Everything Engine::drawEverything() reads about a frame, copied out of the World and the MusicData
+/// at the end of a simulation step. Nothing in here points back into them, so the frame can be drawn
+/// while the world is already simulating the next one.
+/// </summary>
+struct FrameSnapshot
+{
+	MovableObjects objects;
+	Lasers lasers;
+	ObjectsPendingDeletion objectsToDelete;
+	Stars stars;
+	size_t playerIndex = 0;
+	Position playerPos{};
+	float elapsedTime = 0;
+	MusicData music;
+	int playerHealth = 0;
+	// queued by the step, played on the main thread once the frame is handed over, see MusicManager::play()
+	std::vector<AudioEvent> audioEvents;
+
+	// Copies the state of <world>, reusing the memory of the last frame. The audio events are left alone
+	void record(const World& world, const MusicData& musicData, int remainingHealth);
+};
+
+/// <summary>
+/// Overlaps the simulation of the next frame with drawing the current one, with two FrameSnapshots.
+///
+/// beginStep() wakes a worker thread that runs the step (moving the objects, collisions and so on),
+/// which ends by recording the world into the snapshot that isn't being drawn. Meanwhile the main thread
+/// draws the other snapshot, then endStep() waits for the worker and swaps them.
+///
+/// The SDL renderer has to be used from the thread that created the window, so the drawing stays on
+/// the main thread and the simulation is what moves to the worker. The step must not call SDL's
+/// render functions or play sounds, and the main thread must not touch the world between beginStep() and endStep().
+/// </summary>
+struct FramePipeline
+{
+	using Step = std::function<void(FrameSnapshot& frame)>;
+
+private:
+	FrameSnapshot frames[2];
+	int drawnFrame = 0;
+	Step step;
+	bool isThreaded;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable stepReady;
+	std::condition_variable stepDone;
+	bool hasStep = false; // guarded by mutex
+	bool isQuitting = false; // guarded by mutex
+
+	Uint64 steps = 0;
+	Uint64 waitTicks = 0; // in endStep(), when the step took longer than drawing
+
+	void run();
+
+public:
+	// Without <isThreaded>, beginStep() runs the step right away, on the calling thread
+	FramePipeline(Step step, bool isThreaded);
+	~FramePipeline();
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	void beginStep();
+	void endStep();
+
+	// The snapshot to draw between beginStep() and endStep(). Recording into it directly
+	// is for when the world changed outside of a step, after a menu for example
+	FrameSnapshot& getDrawnFrame();
+
+	void printStats() const;
+};
@@ -1,2 +1,417 @@
 #include "game.h"
+#include <algorithm>
+#include <cmath>
+#include "collision.h"
+#include "engine.h"
+#include "player.h"
+#include "rendering.h"
 
+using namespace Vector2D;
+using namespace Collision;
+
+#pragma region OBJECT_MANAGEMENT
+
+void World::createObject(Position position, Rotation rotation, Velocity velocity, float scaleOffset, AssetCache::TextureHandle texture, Tag tag)
+{
+	// randomize texture if a texture wasn't included
+	if (texture == AssetCache::INVALID_TEXTURE)
+		texture = Engine::getRandomTexture();
+
+	// randomize color tint for each instance
+	const Color tint{ rand() % 25 + 200 , rand() % 20 + 220 , rand() % 15 + 240 , 255 };
+	const Appearance appearance(texture, static_cast<Uint8>(scaleOffset), tint);
+
+	const size_t index = objects.push(position, velocity, rotation, appearance, tag);
+	if (tag == Tag::Player) playerIndex = index;
+}
+
+void World::createObject(Position position, Rotation rotation, Velocity velocity, float scaleOffset, const char* texturePath, Tag tag)
+{
+	const AssetCache::TextureHandle texture = AssetCache::acquireTexture(texturePath);
+	if (texture == AssetCache::INVALID_TEXTURE)
+		return;
+
+	const Appearance appearance(texture, static_cast<Uint8>(scaleOffset));
+	const size_t index = objects.push(position, velocity, rotation, appearance, tag);
+	if (tag == Tag::Player) playerIndex = index;
+}
+
+// The last object takes the place of the removed one, sortObjects() puts it back in order next frame
+void World::removeObject(size_t index)
+{
+	if (index >= objects.size() || index == playerIndex) return;
+
+	const size_t last = objects.size() - 1;
+	objects.removeSwapBack(index);
+
+	if (last == playerIndex) playerIndex = index;
+}
+
+// Converts a movable object into an object that fades out, and removes it
+void World::fadeOutObject(size_t index, float fadeOutTime)
+{
+	objectsToDelete.push({ fadeOutTime }, objects.get<Position>(index), objects.get<Appearance>(index), objects.get<Rotation>(index));
+	removeObject(index);
+}
+
+void World::splitObject(size_t index, Vector2 splitDirection)
+{
+	int splits = 1;
+	Position& position = objects.get<Position>(index);
+	const float previousRadius = position.radius;
+	if (previousRadius > MIN_SIZE_WHOLENOTE)
+	{
+		position.radius *= 0.3f;
+		splits = 6;
+	}
+	else if (previousRadius > MIN_SIZE_TRIPPLESPLIT)
+	{
+		position.radius *= 0.4f;
+		splits = 2;
+	}
+	else
+		position.radius *= 0.5f;
+	if (position.radius < MIN_RADIUS)
+	{
+		// fade out and destroy object
+		fadeOutObject(index, 0.33f);
+		return;
+	}
+	float force = (rand() % 50 + 100) * 0.2f;
+	Vector2 velocityDirection = splitDirection.perpendicularVector();
+	objects.get<Velocity>(index) = Velocity(velocityDirection.x * force, velocityDirection.y * force);
+	position.x += velocityDirection.x * previousRadius;
+	position.y += velocityDirection.y * previousRadius;
+	objects.get<Rotation>(index).angle = static_cast<float>(rand() % 360);
+
+	for (int i = 0; i < splits; i++)
+	{
+		const float angleToRotate = 360.f / (splits + 1);
+		rotateVector(velocityDirection.x, velocityDirection.y, angleToRotate);
+
+		force = (rand() % 50 + 100) * 0.2f;
+		const Position newPosition(position.x + velocityDirection.x * previousRadius, position.y + velocityDirection.y * previousRadius, position.radius);
+		const Rotation newRotation(objects.get<Rotation>(index).force, static_cast<float>(rand() % 360));
+		const Velocity newVelocity(velocityDirection.x * force, velocityDirection.y * force);
+		createObject(newPosition, newRotation, newVelocity, 0, objects.get<Appearance>(index).texture);
+	}
+}
+
+void World::createStar(float x, float y, float maxSize, Color color, int lifeTime, float elapsedLifeTime)
+{
+	if (elapsedTime < 1.f)
+		elapsedLifeTime = 2.f;
+	stars.push({ static_cast<float>(lifeTime), elapsedLifeTime }, StarShape(x, y, maxSize), color);
+}
+
+void World::createStartingStars(int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const auto randomX = static_cast<float>(rand() % (WIDTH - 100) + 50);
+		const auto randomY = static_cast<float>(rand() % (HEIGHT - 150) + 50);
+		const auto randomElapsedTime = static_cast<float>(rand() % 700) * 0.01f;
+		createStar(randomX, randomY, 1, Color(200, 225, 255, 255), 10, randomElapsedTime);
+	}
+}
+
+// Works for every storage with a LifeTimeObject component.
+// Adds deltaTime to each lifetime, then removes the ones where elapsedLifeTime > totalLifeTime * lifeTimeMultiplier
+template<typename Storage>
+void updateLifetimes(Storage& storage, float deltaTime, float lifeTimeMultiplier = 1.f)
+{
+	storage.template forEachChunk<LifeTimeObject>([deltaTime](size_t count, LifeTimeObject* lifeTimes)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			lifeTimes[i].elapsedLifeTime += deltaTime;
+		}
+	});
+
+	for (size_t i = storage.size(); i >= 1; i--) //reverse, since the last object takes the place of a removed one
+	{
+		const LifeTimeObject& lifeTime = storage.template get<LifeTimeObject>(i - 1);
+		if (lifeTime.elapsedLifeTime > lifeTime.totalLifeTime * lifeTimeMultiplier)
+		{
+			storage.removeSwapBack(i - 1);
+		}
+	}
+}
+
+// Update elapsed lifetime of objects. Remove objects where elapsedLifeTime > totalLifeTime
+void World::updateObjectsLifetime(float wholeNoteLength, bool excludeStars)
+{
+	// star lifetimes are counted in whole notes
+	if (!excludeStars)
+		updateLifetimes(stars, deltaTime, wholeNoteLength);
+
+	updateLifetimes(lasers, deltaTime);
+	updateLifetimes(objectsToDelete, deltaTime);
+}
+
+Position World::getPlayerPos() const
+{
+	return objects.get<Position>(playerIndex);
+}
+
+void World::updatePlayerTextureMod(Color color) const
+{
+	SDL_SetTextureColorMod(AssetCache::getTexture(objects.get<Appearance>(playerIndex).texture), color.r, color.g, color.b);
+}
+
+int World::getObjectCount() const
+{
+	return static_cast<int>(objects.size());
+}
+
+// adds a laser to the list of lasers
+// returns true if the shot was successful
+bool World::addLaser(Laser line, MusicData* music)
+{
+	bool successfulShot = music->quarterNoteActive;
+	line.color = successfulShot ? Color(0, 200, 255, 255) : Color(255, 0, 0, 255);
+
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		if (i == playerIndex) continue;
+
+		Position& position = objects.get<Position>(i);
+		if (pointCircleIntersect(line.x2, line.y2, position))
+		{
+			Appearance& appearance = objects.get<Appearance>(i);
+			const bool isSplittable = appearance.tint.b > 0;
+
+			successfulShot = isSplittable && (
+				position.radius > MIN_SIZE_WHOLENOTE && music->wholeNoteActive ||
+				position.radius > MIN_SIZE_HALFNOTE  && music->halfNoteActive  ||
+				position.radius < MIN_SIZE_HALFNOTE  && music->quarterNoteActive);
+
+			if (successfulShot)
+			{
+				Vector2 splitDirection = Vector2(line.x1, line.y1) - Vector2(line.x2, line.y2);
+				splitDirection.normalize();
+				position.x = line.x2;
+				position.y = line.y2;
+				line.color = Color(0, 200, 255, 255);
+				splitObject(i, splitDirection);
+			}
+			else
+			{
+				line.color = Color(255, 0, 0, 255);
+				if (appearance.tint.b > 0)
+				{
+					appearance.tint = Color(150, 0, 0, 255);
+					objects.get<Tag>(i) = Tag::Unsplittable;
+				}
+			}
+			break;
+		}
+	}
+	lasers.push(line, line, line.color);
+	return successfulShot;
+}
+
+void World::sortObjects()
+{
+	if (objects.size() <= 1) return;
+	for (size_t i = 1; i < objects.size(); i++)
+	{
+		size_t j = i;
+		while (j > 0 && objects.get<Position>(j).x - objects.get<Position>(j).radius < objects.get<Position>(j - 1).x - objects.get<Position>(j - 1).radius)
+		{
+			objects.swap(j, j - 1);
+
+			if (j == playerIndex) playerIndex--;
+			else if (j - 1 == playerIndex) playerIndex++;
+
+			j--;
+		}
+	}
+}
+
+void World::clearObjects()
+{
+	for (size_t i = objects.size(); i >= 1; i--)
+	{
+		removeObject(i - 1);
+	}
+}
+
+// Removes everything but the player, used to start over between runs
+void World::reset()
+{
+	clearObjects();
+	lasers.clear();
+	objectsToDelete.clear();
+	stars.clear();
+	resetKeys();
+	elapsedTime = 0;
+	collisionChecksPerFrame = 0;
+}
+
+// Handles movement, collision and de-penetration of all movable objects in the game
+void World::moveObjects()
+{
+	const size_t objectCount = objects.size();
+
+	float depenetrateX, depenetrateY;
+	int count = 0;
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		Position& position = objects.get<Position>(i);
+		Velocity& velocity = objects.get<Velocity>(i);
+		const Tag tag = objects.get<Tag>(i);
+
+		position.x += velocity.xVelocity * deltaTime;
+		position.y += velocity.yVelocity * deltaTime;
+
+		for (size_t other = i + 1; other < objectCount; other++) // check collisions to the right
+		{
+			count++;
+			Position& otherPosition = objects.get<Position>(other);
+			// stop checking if the 'other' collider's left x coordinate is bigger than the original's right x coordinate
+			if (otherPosition.x - otherPosition.radius > position.x + position.radius)
+				break;
+			if (circleIntersect(position, otherPosition, depenetrateX, depenetrateY))
+			{
+				Velocity& otherVelocity = objects.get<Velocity>(other);
+				// unsplittable objects can't be affected by other objects
+				if (tag == Tag::Unsplittable)
+				{
+					otherVelocity = velocity;
+					otherPosition.x += depenetrateX;
+					otherPosition.y += depenetrateY;
+				}
+				else if (objects.get<Tag>(other) == Tag::Unsplittable)
+				{
+					velocity = otherVelocity;
+					position.x -= depenetrateX;
+					position.y -= depenetrateY;
+				}
+				// keep the velocity of the bigger collider
+				else if (position.radius > otherPosition.radius)
+				{
+					otherVelocity = velocity;
+					otherPosition.x += depenetrateX;
+					otherPosition.y += depenetrateY;
+				}
+				else
+				{
+					velocity = otherVelocity;
+					position.x -= depenetrateX;
+					position.y -= depenetrateY;
+				}
+			}
+		}
+
+		if (tag == Tag::Unsplittable)
+			velocity.yVelocity += deltaTime * std::lerp(200.f, 5.f, velocity.yVelocity / 500);
+		else
+			velocity.yVelocity += deltaTime * std::lerp(25.f, 5.f, velocity.yVelocity / 50);
+	}
+	collisionChecksPerFrame = count;
+}
+
+// Checks for object collision with health line/laser
+// and also out of bounds positions
+// player can be nullptr in headless simulations, where nobody takes damage
+void World::checkForObjectDestruction(Player* player)
+{
+	for (size_t i = objects.size(); i >= 1; i--) //reverse, since the last object takes the place of a removed one
+	{
+		const size_t index = i - 1;
+		// takeDamage() clears the world when the player dies, the objects left to check are gone then
+		if (index >= objects.size()) continue;
+		const Position& position = objects.get<Position>(index);
+		if (position.y + position.radius > HEALTH_LINE_HEIGHT && index != playerIndex)
+		{
+			fadeOutObject(index, OBJECT_FADEOUT_TIME);
+			if (player != nullptr)
+				player->takeDamage(2);
+			continue;
+		}
+		if (position.x + position.radius <  0 || position.x - position.radius > WIDTH ||
+			position.y + position.radius < -100 || position.y - position.radius > HEIGHT)
+		{
+			removeObject(index);
+		}
+	}
+}
+
+void World::rotateObjects()
+{
+	objects.forEachChunk<Rotation>([this](size_t count, Rotation* rotations)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (rotations[i].force == 0) continue;
+			rotations[i].angle += rotations[i].force * deltaTime;
+
+			if (rotations[i].angle > 360)
+				rotations[i].angle = 0;
+			if (rotations[i].angle < 0)
+				rotations[i].angle = 360;
+		}
+	});
+}
+void World::updateObjects(float wholeNoteLength)
+{
+	sortObjects();
+	moveObjects();
+	rotateObjects();
+	updateObjectsLifetime(wholeNoteLength);
+}
+void World::updatePlayerVelocity(float x, float y)
+{
+	objects.get<Velocity>(playerIndex).xVelocity = x;
+	objects.get<Velocity>(playerIndex).yVelocity = y;
+}
+
+#pragma endregion
+
+#pragma region DELTATIME_RELATED
+
+float World::updateTicks()
+{
+	const Uint64 currentTicks = SDL_GetPerformanceCounter();
+	if (previousTicks == 0) previousTicks = currentTicks;
+	const Uint64 deltaTicks = currentTicks - previousTicks;
+	deltaTime = static_cast<float>(deltaTicks) / SDL_GetPerformanceFrequency();
+	previousTicks = currentTicks;
+	elapsedTime += deltaTime;
+	framerate = deltaTime > 0 ? static_cast<int>(std::round(1 / deltaTime)) : 0;
+
+	return deltaTime;
+}
+
+// Advances time by a fixed amount instead of measuring it, used by headless simulations
+void World::step(float fixedDeltaTime)
+{
+	deltaTime = fixedDeltaTime;
+	elapsedTime += deltaTime;
+	framerate = static_cast<int>(std::round(1 / deltaTime));
+}
+
+#pragma endregion
+
+#pragma region KEY_MANAGEMENT
+
+bool World::getKeyDown(int index) const
+{
+	return keys[index];
+}
+
+void World::updateKey(int index, bool value)
+{
+	keys[index] = value;
+}
+
+void World::resetKeys()
+{
+	for (bool& key : keys)
+	{
+		key = false;
+	}
+}
+
+#pragma endregion
@@ -1,34 +1,64 @@
 #pragma once
-#include "engine.h"
-#include "player.h"
+#include <SDL.h>
+#include "gameObject.h"
 #include "musicManager.h"
+#include "vector2.h"
+
+using namespace GameObject;
+struct Player;
 
 /// <summary>
-/// I will restructure things from engine to here...
+/// Owns all simulation state of one game: objects, lasers, stars, keys and time.
+/// Nothing in here is shared with other worlds, so several worlds can be
+/// simulated at the same time (on different threads) and reset between runs.
+/// Window, renderer and textures are still handled by Engine.
 /// </summary>
+struct World
+{
+	// movable objects, an object is just an index in this storage
+	MovableObjects objects;
+	size_t playerIndex = 0;
+
+	Lasers lasers;
+	ObjectsPendingDeletion objectsToDelete;
+	Stars stars;
+
+	bool keys[SDL_NUM_SCANCODES] = { false };
+
+	Uint64 previousTicks = 0;
+	float deltaTime = 0;
+	float elapsedTime = 0;
+	int framerate = 0;
+	int collisionChecksPerFrame = 0;
+
+	// ---------- Object handling------------
+	void createObject(Position pos, Rotation rot, Velocity vel, float scaleOffset = 0, AssetCache::TextureHandle texture = AssetCache::INVALID_TEXTURE, Tag tag = Tag::Asteroid);
+	void createObject(Position position, Rotation rotation, Velocity velocity, float scaleOffset, const char* texturePath, Tag tag = Tag::Asteroid);
+	void removeObject(size_t index);
+	void splitObject(size_t index, Vector2D::Vector2 splitDirection);
+	void fadeOutObject(size_t index, float fadeOutTime);
+	void clearObjects();
+	bool addLaser(Laser line, MusicData* musicData);
+	void updateObjects(float wholeNoteLength);
+	void sortObjects();
+	void moveObjects();
+	void rotateObjects();
+	void checkForObjectDestruction(Player* player);
+	void updatePlayerVelocity(float x, float y);
+	int getObjectCount() const;
+	Position getPlayerPos() const;
+	void updatePlayerTextureMod(Color color) const;
+	void createStar(float x, float y, float maxSize, Color color, int lifeTime, float elapsedLifeTime = 0.f);
+	void createStartingStars(int count);
+	void updateObjectsLifetime(float wholeNoteLength, bool excludeStars = false);
+	void reset();
+
+	// ----------- Time related ------------
+	float updateTicks();
+	void step(float fixedDeltaTime);
 
-//struct Position { float x; float y; float radius = 50; };
-//struct Velocity { float xVelocity; float yVelocity; };
-//struct Rotation { float force; float angle; };
-//struct Appearance { SDL_Texture* texture; float scaleOffset = 0; SDL_Color tint = SDL_Color(255, 255, 255, 0); };
-//struct ObjectPendingDeletion { Position position; Appearance appearance; float elapsedFadeOutTime; float angle; };
-//
-//struct Game
-//{
-//public:
-//	Player player;
-//private:
-//	MovableObjects objects;
-//
-//	std::vector<Line> lineList;
-//	std::vector<ObjectPendingDeletion> objectsToDelete;
-//};
-//
-//struct MovableObjects
-//{
-//	std::vector<Position> positions;
-//	std::vector<Velocity> velocities;
-//	std::vector<Rotation> rotations;
-//	std::vector<Appearance> textures;
-//	std::vector<Tag> tags;
-//};
\ No newline at end of file
+	// ----------- Key related -------------
+	bool getKeyDown(int index) const;
+	void updateKey(int index, bool value);
+	void resetKeys();
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <SDL.h>
-#include <Windows.h>
+#include "assetCache.h"
+#include "chunkedStorage.h"
 
 /**
  * \brief A collection of all attributes and structs related to game objects.
@@ -24,22 +25,24 @@ namespace GameObject
 
 	#define LASER_DEFAULT_LIFETIME 0.7f
 
-	// To shorten multiplication of colors and avoid having to cast to UINT8 everywhere.
+	// To shorten multiplication of colors and avoid having to cast to Uint8 everywhere.
 	struct Color
 	{
-		UINT8 r, g, b, a;
+		Uint8 r, g, b, a;
 
-		Color(int r, int g, int b, int a) : r(static_cast<UINT8>(r)), g(static_cast<UINT8>(g)),
-											b(static_cast<UINT8>(b)), a(static_cast<UINT8>(a)) {}
+		Color() : r(0), g(0), b(0), a(0) {}
 
-		Color(float r, float g, float b, float a) : r(static_cast<UINT8>(r)), g(static_cast<UINT8>(g)),
-													b(static_cast<UINT8>(b)), a(static_cast<UINT8>(a)) {}
+		Color(int r, int g, int b, int a) : r(static_cast<Uint8>(r)), g(static_cast<Uint8>(g)),
+											b(static_cast<Uint8>(b)), a(static_cast<Uint8>(a)) {}
+
+		Color(float r, float g, float b, float a) : r(static_cast<Uint8>(r)), g(static_cast<Uint8>(g)),
+													b(static_cast<Uint8>(b)), a(static_cast<Uint8>(a)) {}
 
 		// Initialize by multiplying a previous color
-		Color(Color color, float multiplier, float alphaMultiplier = 1.f) : r(static_cast<UINT8>(static_cast<float>(color.r)* multiplier)),
-											   g(static_cast<UINT8>(static_cast<float>(color.g) * multiplier)),
-											   b(static_cast<UINT8>(static_cast<float>(color.b) * multiplier)),
-											   a(static_cast<UINT8>(static_cast<float>(color.a) * alphaMultiplier)) {}
+		Color(Color color, float multiplier, float alphaMultiplier = 1.f) : r(static_cast<Uint8>(static_cast<float>(color.r)* multiplier)),
+											   g(static_cast<Uint8>(static_cast<float>(color.g) * multiplier)),
+											   b(static_cast<Uint8>(static_cast<float>(color.b) * multiplier)),
+											   a(static_cast<Uint8>(static_cast<float>(color.a) * alphaMultiplier)) {}
 
 		Color multiplied(float multiplier, float alphaMultiplier = 1.f) { return { *this, multiplier, alphaMultiplier}; };
 	};
@@ -48,19 +51,28 @@ namespace GameObject
 	struct Position { float x; float y; float radius = 50; }; // Includes radius since it's used together with position most of the time
 	struct Velocity { float xVelocity; float yVelocity; };
 	struct Rotation { float force; float angle; };
-	struct Appearance { SDL_Texture* texture; float scaleOffset = 0; Color tint = Color(255, 255, 255, 0); };
-	enum class Tag { Asteroid, Unsplittable, Player, none };
+	// The texture is a 16-bit AssetCache handle instead of a pointer, which keeps this at 8 bytes instead of 16
+	struct Appearance { AssetCache::TextureHandle texture; Uint8 scaleOffset = 0; Color tint = Color(255, 255, 255, 0); };
+	enum class Tag : Uint8 { Asteroid, Unsplittable, Player, none };
 
 	// An object with a set lifetime, gets deleted when <elapsedLifeTime> is greater than <totalLifetime>
 	struct LifeTimeObject { float totalLifeTime; float elapsedLifeTime = 0.f; };
 
-	// Before destruction, any movable object will be converted into this struct, allowing the object to fade out without caring about collisions etc.
-	struct ObjectPendingDeletion : LifeTimeObject { Position position; Appearance appearance; float angle; };
+	struct Line { float x1; float y1; float x2; float y2; };
+
+	// Only used to create lasers, they are stored as separate components (see Lasers)
+	struct Laser : LifeTimeObject, Line { Color color = Color(0, 255, 255, 255); };
+
+	// This doesn't contain the actual geometry of the star. That is handled by StarBatch.
+	struct StarShape { float x; float y; float maxSize; };
 
-	struct Laser : LifeTimeObject { float x1; float y1; float x2; float y2; Color color = Color(0, 255, 255, 255); };
+	// Each kind of entity is stored as components in chunks, see chunkedStorage.h
+	typedef ChunkedStorage<Position, Velocity, Rotation, Appearance, Tag> MovableObjects;
+	typedef ChunkedStorage<LifeTimeObject, StarShape, Color> Stars;
+	typedef ChunkedStorage<LifeTimeObject, Line, Color> Lasers;
 
-	// This doesn't contain the actual geometry of the star. That's handled inside Rendering::drawStar() for now. 
-	struct Star : LifeTimeObject { float x; float y; float maxSize; Color color; };
+	// Before destruction, any movable object will be converted into this, allowing the object to fade out without caring about collisions etc.
+	typedef ChunkedStorage<LifeTimeObject, Position, Appearance, Rotation> ObjectsPendingDeletion;
 
 }
 
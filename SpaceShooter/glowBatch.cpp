@@ -0,0 +1,316 @@
+#include "glowBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "culling.h"
+#include "easingFunctions.h"
+#include "engine.h"
+#include "player.h"
+
+namespace
+{
+	constexpr int SUBSAMPLES = 2; // per axis
+	constexpr float COS_30 = 0.8660254f;
+	constexpr float GLOW_ALPHA = 150.f / 255;
+
+	const Color tintColors[static_cast<int>(GlowBatch::Tint::Count)] = { Color(0, 225, 255, 150), Color(255, 0, 0, 150) };
+	const Color edgeColor(0, 225, 255, 255);
+
+	// Half the width of the cell of a bucket, the outermost ring plus a pixel
+	int getCellRadius(float bucketRadius)
+	{
+		return static_cast<int>(std::ceil(bucketRadius + GlowBatch::GLOW_GAP + GlowBatch::GLOW_RINGS + 2));
+	}
+
+	// How far out of the center <x>, <y> is, measured like the apothem of a hexagon with a corner on the x axis.
+	// A point is on the outline of a hexagon with circumradius r when this is r * cos(30)
+	float getHexagonApothem(float x, float y)
+	{
+		// the normals of the edges, at 30, 90, 150 ... degrees. The opposite edges are the same normal negated
+		constexpr SDL_FPoint normals[3] = { { COS_30, 0.5f }, { 0.f, 1.f }, { -COS_30, 0.5f } };
+		float apothem = 0;
+		for (const SDL_FPoint& normal : normals)
+		{
+			apothem = (std::max)(apothem, std::abs(x * normal.x + y * normal.y));
+		}
+		return apothem;
+	}
+
+	// Blends a one pixel wide hexagon outline over the premultiplied <pixel>, like SDL_RenderDrawLinesF() did
+	void blendRing(float pixel[4], float apothem, float radius, Color color, float alpha)
+	{
+		const float coverage = std::clamp(1 - std::abs(apothem - radius * COS_30), 0.f, 1.f) * alpha;
+		if (coverage <= 0) return;
+		pixel[0] = color.r / 255.f * coverage + pixel[0] * (1 - coverage);
+		pixel[1] = color.g / 255.f * coverage + pixel[1] * (1 - coverage);
+		pixel[2] = color.b / 255.f * coverage + pixel[2] * (1 - coverage);
+		pixel[3] = coverage + pixel[3] * (1 - coverage);
+	}
+
+	// The rings drawn around an object of <radius> that isn't shrinking yet, in the order they were drawn
+	void shadeGlow(float pixel[4], float apothem, float radius, Color tint)
+	{
+		for (int j = 0; j < GlowBatch::GLOW_RINGS; j++)
+		{
+			const float fade = 1 - static_cast<float>(j) / GlowBatch::GLOW_RINGS;
+			const float multiplier = fade * fade;
+			const Color color(tint, multiplier);
+			blendRing(pixel, apothem, radius + j + GlowBatch::GLOW_GAP, color, GLOW_ALPHA * multiplier);
+			blendRing(pixel, apothem, radius + j + GlowBatch::GLOW_GAP + 0.5f, color, GLOW_ALPHA * multiplier);
+			blendRing(pixel, apothem, radius - j * 0.5f, color, GLOW_ALPHA * multiplier);
+		}
+		blendRing(pixel, apothem, radius + 1, edgeColor, 1);
+		blendRing(pixel, apothem, radius + 2, edgeColor, 1);
+		blendRing(pixel, apothem, radius + GlowBatch::GLOW_GAP, edgeColor, 1);
+	}
+
+	int getBucket(float radius)
+	{
+		int bucket = 0;
+		for (int i = 1; i < GlowBatch::RADIUS_BUCKETS; i++)
+		{
+			if (std::abs(GlowBatch::BUCKET_RADII[i] - radius) < std::abs(GlowBatch::BUCKET_RADII[bucket] - radius))
+				bucket = i;
+		}
+		return bucket;
+	}
+}
+
+void GlowBatch::rasterize()
+{
+	// the buckets side by side, a row per tint
+	atlasWidth = 0;
+	for (int bucket = 0; bucket < RADIUS_BUCKETS; bucket++)
+	{
+		atlasWidth += getCellRadius(BUCKET_RADII[bucket]) * 2;
+	}
+	const int cellHeight = getCellRadius(BUCKET_RADII[RADIUS_BUCKETS - 1]) * 2;
+	atlasHeight = cellHeight * static_cast<int>(Tint::Count);
+	pixels.assign(static_cast<size_t>(atlasWidth) * atlasHeight * 4, 0);
+
+	for (int tint = 0; tint < static_cast<int>(Tint::Count); tint++)
+	{
+		int cellX = 0;
+		for (int bucket = 0; bucket < RADIUS_BUCKETS; bucket++)
+		{
+			const int cellRadius = getCellRadius(BUCKET_RADII[bucket]);
+			const SDL_Rect cell{ cellX, tint * cellHeight, cellRadius * 2, cellRadius * 2 };
+			cells[tint][bucket] = cell;
+			cellX += cell.w;
+
+			// only the pixels between the innermost and the outermost ring are shaded, the rest stays transparent
+			const float innerApothem = (BUCKET_RADII[bucket] - (GLOW_RINGS - 1) * 0.5f) * COS_30 - 2;
+			const float outerApothem = (BUCKET_RADII[bucket] + GLOW_GAP + GLOW_RINGS) * COS_30 + 2;
+			for (int y = 0; y < cell.h; y++)
+			{
+				for (int x = 0; x < cell.w; x++)
+				{
+					const float centerApothem = getHexagonApothem(x + 0.5f - cellRadius, y + 0.5f - cellRadius);
+					if (centerApothem < innerApothem || centerApothem > outerApothem) continue;
+
+					float sum[4] = {};
+					for (int sample = 0; sample < SUBSAMPLES * SUBSAMPLES; sample++)
+					{
+						const float sampleX = x + (sample % SUBSAMPLES + 0.5f) / SUBSAMPLES - cellRadius;
+						const float sampleY = y + (sample / SUBSAMPLES + 0.5f) / SUBSAMPLES - cellRadius;
+						float pixel[4] = {};
+						shadeGlow(pixel, getHexagonApothem(sampleX, sampleY), BUCKET_RADII[bucket], tintColors[tint]);
+						for (int channel = 0; channel < 4; channel++)
+						{
+							sum[channel] += pixel[channel] / (SUBSAMPLES * SUBSAMPLES);
+						}
+					}
+
+					// stored straight, not premultiplied, for SDL_BLENDMODE_BLEND
+					Uint8* destination = pixels.data() + (static_cast<size_t>(cell.y + y) * atlasWidth + cell.x + x) * 4;
+					for (int channel = 0; channel < 3; channel++)
+					{
+						destination[channel] = static_cast<Uint8>(sum[3] > 0 ? std::clamp(sum[channel] / sum[3], 0.f, 1.f) * 255 : 0);
+					}
+					destination[3] = static_cast<Uint8>(sum[3] * 255);
+				}
+			}
+		}
+	}
+}
+
+bool GlowBatch::createTexture(SDL_Renderer* renderer)
+{
+	if (texture != nullptr) return true;
+	if (!isRasterized())
+		rasterize();
+
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, atlasWidth, atlasHeight);
+	if (texture == nullptr || SDL_UpdateTexture(texture, nullptr, pixels.data(), atlasWidth * 4) != 0)
+	{
+		std::cout << "Failed to create the glow atlas! SDL Error: " << SDL_GetError() << std::endl;
+		destroy();
+		return false;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	// the glows are scaled to the object's radius, and shrink with it
+	SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+	return true;
+}
+
+void GlowBatch::destroy()
+{
+	if (texture != nullptr)
+		SDL_DestroyTexture(texture);
+	texture = nullptr;
+}
+
+bool GlowBatch::isRasterized() const
+{
+	return !pixels.empty();
+}
+
+SDL_Texture* GlowBatch::getTexture() const
+{
+	return texture;
+}
+
+int GlowBatch::getWidth() const
+{
+	return atlasWidth;
+}
+
+int GlowBatch::getHeight() const
+{
+	return atlasHeight;
+}
+
+const Uint8* GlowBatch::getPixels() const
+{
+	return pixels.data();
+}
+
+// <corners> are top left, top right, bottom left and bottom right
+void GlowBatch::addQuad(std::vector<SDL_Vertex>& vertices, const SDL_FPoint corners[4], const SDL_FRect& source, SDL_Color color)
+{
+	vertices.push_back(SDL_Vertex{ corners[0], color, { source.x, source.y } });
+	vertices.push_back(SDL_Vertex{ corners[1], color, { source.x + source.w, source.y } });
+	vertices.push_back(SDL_Vertex{ corners[2], color, { source.x, source.y + source.h } });
+	vertices.push_back(SDL_Vertex{ corners[3], color, { source.x + source.w, source.y + source.h } });
+}
+
+void GlowBatch::emit(const ObjectsPendingDeletion& objects, const SDL_FRect& view, Detail detail)
+{
+	glowVertices.clear();
+	spriteVertices.clear();
+	spriteGroups.clear();
+
+	// the sprites are drawn a texture at a time, and only if they or their glow reach into the view
+	objectsByTexture.clear();
+	culledCount = 0;
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		const LifeTimeObject& lifeTime = objects.get<LifeTimeObject>(i);
+		const Appearance& appearance = objects.get<Appearance>(i);
+		const Position& pos = objects.get<Position>(i);
+		const float progress = lifeTime.elapsedLifeTime / lifeTime.totalLifeTime;
+		const float sizeMultiplier = 1.f - powf(progress, 2);
+		// the corner of the turned sprite, or the edge of the glow
+		const float spriteExtent = (pos.radius * sizeMultiplier + appearance.scaleOffset / 2.f) * 1.4143f;
+		const int bucket = getBucket(pos.radius);
+		const float glowExtent = cells[0][bucket].w * 0.5f * sizeMultiplier * pos.radius / BUCKET_RADII[bucket];
+		if (!Culling::isVisible(view, pos.x, pos.y, (std::max)(spriteExtent, glowExtent)))
+		{
+			culledCount++;
+			continue;
+		}
+		objectsByTexture.emplace_back(appearance.texture, i);
+	}
+	std::sort(objectsByTexture.begin(), objectsByTexture.end());
+
+	for (const auto& [textureHandle, i] : objectsByTexture)
+	{
+		const LifeTimeObject& lifeTime = objects.get<LifeTimeObject>(i);
+		const Appearance& appearance = objects.get<Appearance>(i);
+		const Position& pos = objects.get<Position>(i);
+		const float progress = lifeTime.elapsedLifeTime / lifeTime.totalLifeTime;
+		const float sizeMultiplier = 1.f - powf(progress, 2);
+		const Tint tint = pos.y + pos.radius > HEALTH_LINE_HEIGHT - 5 ? Tint::Red : Tint::Cyan;
+		const Color& tintColor = tintColors[static_cast<int>(tint)];
+
+		// the sprite, turned like SDL_RenderCopyEx() turns it around its center
+		const float halfSize = pos.radius * sizeMultiplier + appearance.scaleOffset / 2.f;
+		const float angle = objects.get<Rotation>(i).angle * (PI / 180);
+		const float cosAngle = std::cos(angle) * halfSize;
+		const float sinAngle = std::sin(angle) * halfSize;
+		const SDL_FPoint spriteCorners[4] = {
+			{ pos.x - cosAngle + sinAngle, pos.y - sinAngle - cosAngle }, { pos.x + cosAngle + sinAngle, pos.y + sinAngle - cosAngle },
+			{ pos.x - cosAngle - sinAngle, pos.y - sinAngle + cosAngle }, { pos.x + cosAngle - sinAngle, pos.y + sinAngle + cosAngle }
+		};
+		const SDL_Color spriteColor{ tintColor.r, tintColor.g, tintColor.b, static_cast<Uint8>(std::lerp(255, 0, progress)) };
+		if (spriteGroups.empty() || spriteGroups.back().texture != textureHandle)
+			spriteGroups.push_back(SpriteGroup{ textureHandle, static_cast<int>(spriteVertices.size() / 4 * 6), 0 });
+		addQuad(spriteVertices, spriteCorners, SDL_FRect{ 0, 0, 1, 1 }, spriteColor);
+		spriteGroups.back().indexCount += 6;
+
+		// reduced fades the glows out in half the time, minimal leaves them out
+		const float glowAlpha = detail == Detail::Full ? 1 - progress : detail == Detail::Reduced ? 1 - progress * 2 : 0.f;
+		if (glowAlpha <= 0) continue;
+
+		// the glow of the closest bucket, scaled to the object
+		const int bucket = getBucket(pos.radius);
+		const SDL_Rect& cell = cells[static_cast<int>(tint)][bucket];
+		const float halfWidth = cell.w * 0.5f * sizeMultiplier * pos.radius / BUCKET_RADII[bucket];
+		const SDL_FPoint glowCorners[4] = {
+			{ pos.x - halfWidth, pos.y - halfWidth }, { pos.x + halfWidth, pos.y - halfWidth },
+			{ pos.x - halfWidth, pos.y + halfWidth }, { pos.x + halfWidth, pos.y + halfWidth }
+		};
+		const SDL_FRect source{
+			static_cast<float>(cell.x) / atlasWidth, static_cast<float>(cell.y) / atlasHeight,
+			static_cast<float>(cell.w) / atlasWidth, static_cast<float>(cell.h) / atlasHeight
+		};
+		addQuad(glowVertices, glowCorners, source, SDL_Color{ 255, 255, 255, static_cast<Uint8>(255 * glowAlpha) });
+	}
+
+	// two triangles per quad, there are at most as many glows as sprites
+	for (int quad = static_cast<int>(indices.size()) / 6; quad < static_cast<int>(objectsByTexture.size()); quad++)
+	{
+		const int corner = quad * 4;
+		indices.insert(indices.end(), { corner, corner + 1, corner + 2, corner + 2, corner + 1, corner + 3 });
+	}
+}
+
+const std::vector<GlowBatch::SpriteGroup>& GlowBatch::getSpriteGroups() const
+{
+	return spriteGroups;
+}
+
+const SDL_Vertex* GlowBatch::getSpriteVertices() const
+{
+	return spriteVertices.data();
+}
+
+int GlowBatch::getSpriteVertexCount() const
+{
+	return static_cast<int>(spriteVertices.size());
+}
+
+const SDL_Vertex* GlowBatch::getGlowVertices() const
+{
+	return glowVertices.data();
+}
+
+int GlowBatch::getGlowVertexCount() const
+{
+	return static_cast<int>(glowVertices.size());
+}
+
+const int* GlowBatch::getIndices() const
+{
+	return indices.data();
+}
+
+int GlowBatch::getGlowIndexCount() const
+{
+	return static_cast<int>(glowVertices.size() / 4 * 6);
+}
+
+size_t GlowBatch::getCulledCount() const
+{
+	return culledCount;
+}
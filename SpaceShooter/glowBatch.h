@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "assetCache.h"
+#include "detailController.h"
+#include "gameObject.h"
+
+using namespace GameObject;
+
+/// <summary>
+/// Draws the objects that are fading out, with one SDL_RenderGeometry() call per asteroid texture and one for all glows.
+///
+/// The glow is the hexagon rings Rendering::drawObjectsFadingOutLines() draws around every dying object.
+/// They're pre-rendered at startup into an atlas, for a few radii and in the cyan and red tints, and drawn
+/// as one quad per object, scaled as the object shrinks and faded with the vertex alpha. The sprites are
+/// grouped by texture and tinted with vertex colors, so the texture mods aren't changed per object.
+/// </summary>
+struct GlowBatch
+{
+	static constexpr int RADIUS_BUCKETS = 6;
+	static constexpr float BUCKET_RADII[RADIUS_BUCKETS] = { 8, 16, 24, 32, 48, 64 };
+	static constexpr int GLOW_RINGS = 12;
+	static constexpr float GLOW_GAP = 7; // between the object and the first ring outside it
+
+	// Destroyed by the health line or by a laser
+	enum class Tint { Cyan, Red, Count };
+
+	// The sprites of the objects with the same texture, they're drawn with one call
+	struct SpriteGroup
+	{
+		AssetCache::TextureHandle texture;
+		int firstIndex;
+		int indexCount;
+	};
+
+private:
+	std::vector<Uint8> pixels; // RGBA32
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+	SDL_Rect cells[static_cast<int>(Tint::Count)][RADIUS_BUCKETS] = {};
+	SDL_Texture* texture = nullptr;
+
+	std::vector<SDL_Vertex> glowVertices;
+	std::vector<SDL_Vertex> spriteVertices;
+	std::vector<int> indices; // quads, the same for sprites and glows
+	std::vector<SpriteGroup> spriteGroups;
+	std::vector<std::pair<AssetCache::TextureHandle, size_t>> objectsByTexture;
+	size_t culledCount = 0;
+
+	void addQuad(std::vector<SDL_Vertex>& vertices, const SDL_FPoint corners[4], const SDL_FRect& source, SDL_Color color);
+
+public:
+	// Draws the rings into pixels, doesn't need a renderer
+	void rasterize();
+	// Rasterizes the atlas if it isn't yet, and uploads it
+	bool createTexture(SDL_Renderer* renderer);
+	void destroy();
+
+	bool isRasterized() const;
+	SDL_Texture* getTexture() const;
+	int getWidth() const;
+	int getHeight() const;
+	const Uint8* getPixels() const;
+
+	// Writes a sprite and a glow quad per object in <view>, the sprites sorted into groups by texture.
+	// Below full <detail> the glows fade out sooner, or are left out
+	void emit(const ObjectsPendingDeletion& objects, const SDL_FRect& view, Detail detail);
+	// Of the last emit(), valid until the next one
+	const std::vector<SpriteGroup>& getSpriteGroups() const;
+	const SDL_Vertex* getSpriteVertices() const;
+	int getSpriteVertexCount() const;
+	const SDL_Vertex* getGlowVertices() const;
+	int getGlowVertexCount() const;
+	// Shared by the sprites and the glows
+	const int* getIndices() const;
+	int getGlowIndexCount() const;
+	// The objects that were left out because they're outside the view
+	size_t getCulledCount() const;
+};
@@ -0,0 +1,309 @@
+#include "goldenFrames.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <emmintrin.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL_image.h>
+#include "engine.h"
+#include "framePipeline.h"
+#include "headlessWorld.h"
+#include "rendering.h"
+#include "softwareRasterizer.h"
+
+namespace
+{
+	struct Event
+	{
+		enum class Kind { Shoot, Health, Capture };
+
+		double time; // in seconds since the start
+		Kind kind;
+		float x = 0;
+		float y = 0;
+		int health = 0;
+		std::string name;
+	};
+
+	struct Replay
+	{
+		unsigned int seed = 1;
+		std::string wavesPath;
+		float bpm = 120;
+		// a capture fails if it's below minPsnr, or more than maxChangedFraction of its pixels have a channel over maxChannelDifference
+		double minPsnr = 40;
+		int maxChannelDifference = 16;
+		double maxChangedFraction = 0.001;
+		std::vector<Event> events; // in the order of their time
+	};
+
+	// Reads a replay, one setting or event per line. Empty lines and lines starting with # are ignored
+	bool loadReplay(const char* path, Replay& replay)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			std::cout << "Failed to open the replay at: " << path << std::endl;
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#') continue;
+
+			std::istringstream stream(line);
+			std::string word;
+			stream >> word;
+			bool isValid;
+			if (word == "seed")
+				isValid = static_cast<bool>(stream >> replay.seed);
+			else if (word == "waves")
+				isValid = static_cast<bool>(stream >> replay.wavesPath);
+			else if (word == "bpm")
+				isValid = stream >> replay.bpm && replay.bpm > 0;
+			else if (word == "tolerance")
+				isValid = static_cast<bool>(stream >> replay.minPsnr >> replay.maxChannelDifference >> replay.maxChangedFraction);
+			else
+			{
+				Event event{};
+				std::string kind;
+				isValid = static_cast<bool>(std::istringstream(word) >> event.time) && stream >> kind
+					&& (replay.events.empty() || event.time >= replay.events.back().time);
+				if (kind == "shoot")
+				{
+					event.kind = Event::Kind::Shoot;
+					isValid = isValid && stream >> event.x >> event.y;
+				}
+				else if (kind == "health")
+				{
+					event.kind = Event::Kind::Health;
+					isValid = isValid && stream >> event.health;
+				}
+				else if (kind == "capture")
+				{
+					event.kind = Event::Kind::Capture;
+					isValid = isValid && stream >> event.name;
+				}
+				else
+					isValid = false;
+
+				if (isValid) replay.events.push_back(event);
+			}
+
+			if (!isValid)
+			{
+				std::cout << "Invalid line in " << path << ": " << line << std::endl;
+				return false;
+			}
+		}
+		if (replay.wavesPath.empty())
+		{
+			std::cout << "The replay " << path << " has no waves" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Called with the name of every capture and the rasterizer it was drawn into, returns if it passed
+	using CaptureHandler = bool (*)(const Replay& replay, const std::string& name, const SoftwareRasterizer& rasterizer, const std::filesystem::path& directory);
+
+	// Plays <replay> back in a headless world and draws every capture, returns how many of them failed
+	int play(const Replay& replay, const std::filesystem::path& directory, CaptureHandler onCapture)
+	{
+		// headless worlds don't load any textures, all their objects have INVALID_TEXTURE
+		constexpr int SPRITE_SIZE = 64;
+		const std::vector<Uint8> spritePixels = HeadlessWorld::createStandInSprite(SPRITE_SIZE);
+		SoftwareRasterizer rasterizer(WIDTH, HEIGHT, (std::max)(static_cast<int>(std::thread::hardware_concurrency()), 1));
+		rasterizer.setTexture(AssetCache::INVALID_TEXTURE, { spritePixels.data(), SPRITE_SIZE, SPRITE_SIZE });
+
+		// the waves spawn with rand(), the seed has to be set before the world is
+		srand(replay.seed);
+		HeadlessWorld headlessWorld(replay.wavesPath.c_str(), replay.bpm);
+		FrameSnapshot frame;
+		int health = 12; // Player::maxHealth
+		int failures = 0;
+		for (const Event& event : replay.events)
+		{
+			// only whole steps, so the world is the same whatever the frame rate of the game was
+			while (headlessWorld.time + HeadlessWorld::FIXED_DELTA_TIME / 2 < event.time)
+			{
+				headlessWorld.step();
+			}
+
+			switch (event.kind)
+			{
+			case Event::Kind::Shoot:
+				headlessWorld.shootLaser(event.x, event.y);
+				break;
+			case Event::Kind::Health:
+				health = event.health;
+				break;
+			case Event::Kind::Capture:
+				frame.record(headlessWorld.world, headlessWorld.getMusic(), health);
+				Rendering::setRasterizer(&rasterizer);
+				Rendering::renderClear();
+				Engine::drawEverything(frame);
+				Rendering::renderPresent();
+				failures += !onCapture(replay, event.name, rasterizer, directory);
+				break;
+			}
+		}
+		Rendering::setRasterizer(nullptr);
+		return failures;
+	}
+
+	bool saveCapture(const Replay&, const std::string& name, const SoftwareRasterizer& rasterizer, const std::filesystem::path& directory)
+	{
+		const std::string path = (directory / (name + ".png")).string();
+		if (!rasterizer.savePNG(path.c_str())) return false;
+
+		std::cout << "  saved " << path << std::endl;
+		return true;
+	}
+
+	bool compareCapture(const Replay& replay, const std::string& name, const SoftwareRasterizer& rasterizer, const std::filesystem::path& directory)
+	{
+		std::cout << "  " << std::left << std::setw(20) << name << std::right;
+		const std::string actualPath = (directory / (name + ".actual.png")).string();
+
+		const std::string path = (directory / (name + ".png")).string();
+		SDL_Surface* loaded = IMG_Load(path.c_str());
+		SDL_Surface* reference = loaded != nullptr ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+		SDL_FreeSurface(loaded);
+		if (reference == nullptr || reference->w != rasterizer.getWidth() || reference->h != rasterizer.getHeight())
+		{
+			std::cout << (reference == nullptr ? "no reference" : "the reference is a different size") << ", FAILED" << std::endl;
+			SDL_FreeSurface(reference);
+			rasterizer.savePNG(actualPath.c_str());
+			return false;
+		}
+
+		const GoldenFrames::Difference difference = GoldenFrames::compareFrames(rasterizer.getPixels(), rasterizer.getStride(),
+			static_cast<const Uint32*>(reference->pixels), reference->pitch / 4, reference->w, reference->h, replay.maxChannelDifference);
+		const double pixelCount = static_cast<double>(reference->w) * reference->h;
+		SDL_FreeSurface(reference);
+
+		const bool isMatch = difference.psnr >= replay.minPsnr && difference.changedPixels <= replay.maxChangedFraction * pixelCount;
+		std::cout << "PSNR " << std::fixed << std::setprecision(1) << difference.psnr << " dB, " << difference.changedPixels << " pixels changed";
+		if (isMatch)
+		{
+			std::cout << std::endl;
+			return true;
+		}
+		std::cout << ", FAILED" << std::endl;
+		rasterizer.savePNG(actualPath.c_str());
+		return false;
+	}
+
+	int countCaptures(const Replay& replay)
+	{
+		int captures = 0;
+		for (const Event& event : replay.events)
+		{
+			captures += event.kind == Event::Kind::Capture;
+		}
+		return captures;
+	}
+}
+
+namespace GoldenFrames
+{
+	bool record(const char* replayPath, const char* directory)
+	{
+		Replay replay;
+		if (!loadReplay(replayPath, replay)) return false;
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		if (error)
+		{
+			std::cout << "Failed to create " << directory << ": " << error.message() << std::endl;
+			return false;
+		}
+
+		std::cout << "Recording the golden frames of " << replayPath << " to " << directory << std::endl;
+		return play(replay, directory, saveCapture) == 0;
+	}
+
+	bool compare(const char* replayPath, const char* directory)
+	{
+		Replay replay;
+		if (!loadReplay(replayPath, replay)) return false;
+
+		std::cout << "Comparing the golden frames of " << replayPath << " with " << directory << ", at least " << replay.minPsnr << " dB PSNR and at most "
+			<< replay.maxChangedFraction * 100 << "% of the pixels more than " << replay.maxChannelDifference << " apart" << std::endl;
+		const int failures = play(replay, directory, compareCapture);
+		const int captures = countCaptures(replay);
+		std::cout << captures - failures << " of " << captures << " frames match";
+		if (failures > 0)
+			std::cout << ", the failed ones are saved as <name>.actual.png. If the change was on purpose, --golden-record makes them the new references";
+		std::cout << std::endl;
+		return failures == 0;
+	}
+
+	Difference compareFrames(const Uint32* frame, int frameStride, const Uint32* reference, int referenceStride, int width, int height, int maxChannelDifference)
+	{
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i threshold = _mm_set1_epi8(static_cast<char>(std::clamp(maxChannelDifference, 0, 255)));
+		const __m128i zero = _mm_setzero_si128();
+
+		Uint64 squaredError = 0;
+		Uint64 changedPixels = 0;
+		for (int y = 0; y < height; y++)
+		{
+			const Uint32* a = frame + static_cast<size_t>(y) * frameStride;
+			const Uint32* b = reference + static_cast<size_t>(y) * referenceStride;
+
+			// each lane adds at most 4 * 255^2 per four pixels, a row would have to be over 60 000 pixels wide to overflow it
+			__m128i rowError = zero;
+			int x = 0;
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i pixelsA = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x)), colorMask);
+				const __m128i pixelsB = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x)), colorMask);
+				// |a - b| of every channel, one of the two saturates to 0
+				const __m128i difference = _mm_or_si128(_mm_subs_epu8(pixelsA, pixelsB), _mm_subs_epu8(pixelsB, pixelsA));
+
+				const __m128i low = _mm_unpacklo_epi8(difference, zero);
+				const __m128i high = _mm_unpackhi_epi8(difference, zero);
+				rowError = _mm_add_epi32(rowError, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+
+				// a pixel is unchanged if none of its channels is left after taking away the threshold
+				const __m128i isUnchanged = _mm_cmpeq_epi32(_mm_subs_epu8(difference, threshold), zero);
+				changedPixels += 4 - std::popcount(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(isUnchanged))));
+			}
+
+			alignas(16) Uint32 lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), rowError);
+			squaredError += static_cast<Uint64>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+
+			for (; x < width; x++)
+			{
+				bool isChanged = false;
+				for (int shift = 0; shift < 24; shift += 8)
+				{
+					const int channelDifference = std::abs(static_cast<int>((a[x] >> shift) & 0xFF) - static_cast<int>((b[x] >> shift) & 0xFF));
+					squaredError += channelDifference * channelDifference;
+					isChanged |= channelDifference > maxChannelDifference;
+				}
+				changedPixels += isChanged;
+			}
+		}
+
+		Difference result;
+		result.changedPixels = changedPixels;
+		const double meanSquaredError = static_cast<double>(squaredError) / (3.0 * width * height);
+		result.psnr = meanSquaredError > 0 ? 10 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+		return result;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <SDL.h>
+
+/// <summary>
+/// Golden frames: a replay file scripts a game - the seed, the wave file, and when to shoot, lose health
+/// and capture a frame. The replay is played back in a HeadlessWorld and every captured frame is drawn with
+/// Engine::drawEverything() into a SoftwareRasterizer, so the same replay always draws the same pixels.
+///
+/// record() saves the captures as the reference images, compare() draws them again and fails
+/// when a frame drifted further from its reference than the replay's tolerance.
+/// </summary>
+namespace GoldenFrames
+{
+	struct Difference
+	{
+		double psnr = 0; // in dB, over the red, green and blue of every pixel. Infinite when the frames are the same
+		Uint64 changedPixels = 0; // with any channel more than the allowed difference apart
+	};
+
+	// Plays <replayPath> back and saves every capture to <directory>/<name>.png
+	bool record(const char* replayPath, const char* directory);
+	// Plays <replayPath> back and compares every capture with <directory>/<name>.png. Prints the difference of each,
+	// frames that fail or have no reference are saved next to it as <name>.actual.png. Returns if all of them matched
+	bool compare(const char* replayPath, const char* directory);
+
+	// Compares two RGBA32 frames of <width> x <height>, <stride> pixels per row, four pixels at a time with SSE2. Alpha is ignored
+	Difference compareFrames(const Uint32* frame, int frameStride, const Uint32* reference, int referenceStride, int width, int height, int maxChannelDifference);
+}
@@ -0,0 +1,86 @@
+#include "headlessWorld.h"
+#include <algorithm>
+#include "engine.h"
+#include "player.h"
+#include "vector2.h"
+
+using namespace Vector2D;
+
+namespace
+{
+	// MusicManager's accepted offset, the time around a beat a shot counts as on it
+	constexpr float ACCEPTED_OFFSET = 0.1f;
+
+	bool isBeatActive(float timeSinceLastBeat, float noteLength)
+	{
+		return timeSinceLastBeat < ACCEPTED_OFFSET * 1.25f || timeSinceLastBeat > noteLength - ACCEPTED_OFFSET * 0.75f;
+	}
+}
+
+HeadlessWorld::HeadlessWorld(const char* wavesPath, float bpm) : waveManager(&world, nullptr, wavesPath), timeline(bpm, 4, AUDIO_FREQUENCY)
+{
+	const Position playerPos(WIDTH / 2 - playerRadius / 2, HEIGHT * 0.8f, playerRadius);
+	world.createObject(playerPos, Rotation(10, 0), Velocity(), 20, AssetCache::INVALID_TEXTURE, Tag::Player);
+}
+
+void HeadlessWorld::step()
+{
+	world.step(FIXED_DELTA_TIME);
+	time += FIXED_DELTA_TIME;
+	const BeatTimeline::GridPosition position = timeline.at(time);
+	if (position.beat > lastBeat)
+	{
+		lastBeat = position.beat;
+		waveManager.onQuarterNote();
+		waveManager.spawnStar();
+	}
+	world.updateObjects(position.wholeNoteLength);
+	world.checkForObjectDestruction(nullptr);
+}
+
+MusicData HeadlessWorld::getMusic() const
+{
+	const BeatTimeline::GridPosition position = timeline.at(time);
+	MusicData music;
+	music.musicIsPlaying = true;
+	music.currentQuarterNote = position.quarterNote;
+	music.timeSinceLastQuarterNote = position.timeSinceQuarterNote;
+	music.timeSinceLastHalfNote = position.timeSinceHalfNote;
+	music.timeSinceLastWholeNote = position.timeSinceWholeNote;
+	music.quarterNoteLength = position.quarterNoteLength;
+	music.halfNoteLength = position.halfNoteLength;
+	music.wholeNoteLength = position.wholeNoteLength;
+	music.wholeNoteActive = isBeatActive(position.timeSinceWholeNote, position.wholeNoteLength);
+	music.halfNoteActive = isBeatActive(position.timeSinceHalfNote, position.halfNoteLength);
+	music.quarterNoteActive = isBeatActive(position.timeSinceQuarterNote, position.quarterNoteLength);
+	music.quarterNoteProgress = position.quarterNoteProgress;
+	music.halfNoteProgress = position.halfNoteProgress;
+	music.wholeNoteProgress = position.wholeNoteProgress;
+	music.pulseMultiplier = music.halfNoteProgress < 0.5f ? music.halfNoteProgress * 2.f : 1 - (music.halfNoteProgress - 0.5f) * 2.f;
+	return music;
+}
+
+bool HeadlessWorld::shootLaser(float x, float y)
+{
+	const Position playerPos = world.getPlayerPos();
+	Vector2 direction = Vector2(x, y) - Vector2(playerPos.x, playerPos.y);
+	direction.normalize();
+	const Vector2 start = Vector2(playerPos.x, playerPos.y) + direction * playerRadius;
+
+	const Laser laser{ { LASER_DEFAULT_LIFETIME }, start.x, start.y, x, y };
+	MusicData music = getMusic();
+	return world.addLaser(laser, &music);
+}
+
+std::vector<Uint8> HeadlessWorld::createStandInSprite(int size)
+{
+	std::vector<Uint8> pixels(static_cast<size_t>(size) * size * 4);
+	for (int i = 0; i < size * size; i++)
+	{
+		const float x = i % size - size / 2 + 0.5f, y = i / size - size / 2 + 0.5f;
+		const bool isInside = x * x + y * y < size * size / 4;
+		std::fill_n(pixels.begin() + i * 4, 3, static_cast<Uint8>(isInside ? 0xB0 : 0));
+		pixels[i * 4 + 3] = isInside ? 0xFF : 0;
+	}
+	return pixels;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "beatTimeline.h"
+#include "game.h"
+#include "waveManager.h"
+
+/// <summary>
+/// A World without a window, music or input, for the benchmarks and the golden frames.
+/// It has a player and spawns the waves of a wave file, advanced a fixed time step at a time
+/// as if the music was playing at <bpm>.
+///
+/// The asteroids are spawned with rand(), so after the same srand() a headless world plays out the same every time.
+/// </summary>
+struct HeadlessWorld
+{
+	static constexpr float FIXED_DELTA_TIME = 1.f / 120.f;
+
+	World world;
+	WaveManager waveManager;
+	BeatTimeline timeline;
+	double time = 0;
+	Sint64 lastBeat = 0;
+
+	HeadlessWorld(const char* wavesPath, float bpm);
+	// Moves the world on by FIXED_DELTA_TIME, spawning the waves on every quarter note
+	void step();
+
+	// The note timings at the current time, the way MusicManager::update() works them out while the music plays
+	MusicData getMusic() const;
+	// Fires a laser from the edge of the player to <x>, <y>, like Player::shootLaser(). Returns if it was on the beat
+	bool shootLaser(float x, float y);
+
+	// The objects of a headless world don't have textures, these pixels (RGBA32, <size> x <size>) stand in for them, a plain disc
+	static std::vector<Uint8> createStandInSprite(int size);
+};
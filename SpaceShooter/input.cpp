@@ -2,7 +2,7 @@
 #include "musicManager.h"
 
 
-void handleInputEvents(Player& player, MusicManager& musicManager, bool& gameRunning, bool& gamePaused, float deltaTime)
+void handleInputEvents(World& world, Player& player, MusicManager& musicManager, bool& gameRunning, bool& gamePaused, float deltaTime)
 {
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
@@ -37,13 +37,13 @@ void handleInputEvents(Player& player, MusicManager& musicManager, bool& gameRun
 					musicManager.changeBeat();
 				}
 
-				Engine::updateKey(scanCode, true);
+				world.updateKey(scanCode, true);
 				break;
 			}
 
 		case SDL_KEYUP:
 			{
-				Engine::updateKey(scanCode, false);
+				world.updateKey(scanCode, false);
 				break;
 			}
 		case SDL_QUIT:
@@ -5,7 +5,7 @@
 
 using namespace Collision;
 
-void handleInputEvents(Player& player, MusicManager& musicManager, bool& gameRunning, bool& gamePaused, float deltaTime);
+void handleInputEvents(World& world, Player& player, MusicManager& musicManager, bool& gameRunning, bool& gamePaused, float deltaTime);
 
 bool isPressingMouseButton();
 
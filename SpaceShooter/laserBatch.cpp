@@ -0,0 +1,363 @@
+#include "laserBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "easingFunctions.h"
+#include "vector2.h"
+
+using namespace Vector2D;
+
+namespace
+{
+	constexpr int ROW_HEIGHT = 4; // in texels, the rows are sampled in their middle so they don't bleed into each other
+	constexpr int BURST_LINES = 6;
+	constexpr float BURST_MAX_LENGTH = 40.f; // the longest of the random lengths the burst lines were drawn with
+	constexpr float BURST_MIN_LENGTH = 10.f;
+	constexpr float RING_RADIUS = 3.f;
+
+	// A line along the beam, <offset> pixels from its center
+	struct Stroke { float offset; float brightness; float alpha; };
+
+	struct CrossSection
+	{
+		float halfWidth = 1; // in pixels, the width of the strip is scaled to it
+		std::vector<Stroke> strokes;
+	};
+
+	SDL_Rect getTexels(LaserBatch::Region region)
+	{
+		switch (region)
+		{
+		case LaserBatch::Region::Burst: return SDL_Rect{ 0, 32, LaserBatch::TEXTURE_WIDTH, 32 };
+		case LaserBatch::Region::Ring: return SDL_Rect{ 0, 64, 32, 32 };
+		default: return SDL_Rect{ 0, static_cast<int>(region) * ROW_HEIGHT, LaserBatch::TEXTURE_WIDTH, ROW_HEIGHT };
+		}
+	}
+
+	// The lines drawLaserLines() draws for each part of a laser, mirrored on both sides of the center
+	CrossSection getCrossSection(LaserBatch::Region region)
+	{
+		CrossSection section;
+		const auto addMirrored = [&section](float offset, float brightness, float alpha)
+		{
+			section.strokes.push_back(Stroke{ offset, brightness, alpha });
+			if (offset != 0)
+				section.strokes.push_back(Stroke{ -offset, brightness, alpha });
+		};
+
+		switch (region)
+		{
+		case LaserBatch::Region::Beam1:
+		case LaserBatch::Region::Beam2:
+		case LaserBatch::Region::Beam3:
+		case LaserBatch::Region::Beam4:
+		{
+			// every layer is one pixel further out and a bit darker
+			const int layerCount = static_cast<int>(region) - static_cast<int>(LaserBatch::Region::Beam1) + 1;
+			section.halfWidth = static_cast<float>(layerCount + 1);
+			for (int j = 0; j < layerCount; j++)
+			{
+				addMirrored(static_cast<float>(j + 1), 1 - j * 0.15f, 1.f);
+			}
+			break;
+		}
+		case LaserBatch::Region::Trail:
+			section.halfWidth = 2;
+			addMirrored(0, 1, 0.5f);
+			addMirrored(1, 1, 0.25f);
+			break;
+		case LaserBatch::Region::Line:
+			section.halfWidth = 1;
+			addMirrored(0, 1, 1);
+			break;
+		case LaserBatch::Region::DarkLines:
+			section.halfWidth = 8;
+			for (int j = 1; j < 8; j += 2)
+			{
+				addMirrored(static_cast<float>(j), 1, 1);
+			}
+			break;
+		case LaserBatch::Region::Burst:
+			section.halfWidth = 3 + (BURST_LINES - 1) * 4 + 1.f;
+			for (int j = 0; j < BURST_LINES; j++)
+			{
+				addMirrored(3 + j * 4.f, 1, 1 - j * 0.15f);
+			}
+			break;
+		case LaserBatch::Region::Ring:
+			// the three circles of Rendering::drawCircles(), darker toward the center
+			section.halfWidth = RING_RADIUS + 1;
+			section.strokes = { { RING_RADIUS, 1, 1 }, { RING_RADIUS * 0.67f, 1 / 1.5f, 1 }, { RING_RADIUS * 0.34f, 1 / 2.25f, 1 } };
+			break;
+		default:
+			break;
+		}
+		return section;
+	}
+
+	// The strokes are a pixel wide and antialiased, overlapping ones add up like the blended lines did
+	void shade(const CrossSection& section, float offset, float& brightness, float& alpha)
+	{
+		float transparency = 1;
+		float strongestCoverage = 0;
+		brightness = 1;
+		for (const Stroke& stroke : section.strokes)
+		{
+			const float coverage = std::clamp(1 - std::abs(offset - stroke.offset), 0.f, 1.f) * stroke.alpha;
+			transparency *= 1 - coverage;
+			if (coverage > strongestCoverage)
+			{
+				strongestCoverage = coverage;
+				brightness = stroke.brightness;
+			}
+		}
+		alpha = 1 - transparency;
+	}
+
+	void setPixel(std::vector<Uint8>& pixels, int x, int y, float brightness, float alpha)
+	{
+		Uint8* pixel = pixels.data() + (static_cast<size_t>(y) * LaserBatch::TEXTURE_WIDTH + x) * 4;
+		pixel[0] = pixel[1] = pixel[2] = static_cast<Uint8>(brightness * 255);
+		pixel[3] = static_cast<Uint8>(alpha * 255);
+	}
+
+	SDL_FPoint toPoint(const Vector2& vector)
+	{
+		return SDL_FPoint{ vector.x, vector.y };
+	}
+
+	SDL_Color withAlpha(Color color, float brightness, float alpha)
+	{
+		const Color tint(color, brightness);
+		return SDL_Color{ tint.r, tint.g, tint.b, static_cast<Uint8>(std::clamp(alpha, 0.f, 255.f)) };
+	}
+}
+
+void LaserBatch::rasterize()
+{
+	pixels.assign(static_cast<size_t>(TEXTURE_WIDTH) * TEXTURE_HEIGHT * 4, 0);
+	for (int i = 0; i < static_cast<int>(Region::Count); i++)
+	{
+		const Region region = static_cast<Region>(i);
+		const CrossSection section = getCrossSection(region);
+		const SDL_Rect texels = getTexels(region);
+		for (int y = 0; y < texels.h; y++)
+		{
+			const float v = (y + 0.5f) / texels.h;
+			for (int x = 0; x < texels.w; x++)
+			{
+				const float u = (x + 0.5f) / texels.w;
+				float brightness, alpha;
+				if (region == Region::Ring)
+				{
+					// the offset is the distance from the center
+					const float dx = (u * 2 - 1) * section.halfWidth;
+					const float dy = (v * 2 - 1) * section.halfWidth;
+					shade(section, std::sqrt(dx * dx + dy * dy), brightness, alpha);
+				}
+				else
+				{
+					shade(section, (u * 2 - 1) * section.halfWidth, brightness, alpha);
+				}
+				// the burst lines were between BURST_MIN_LENGTH and BURST_MAX_LENGTH long, the cone fades out over that range
+				if (region == Region::Burst)
+					alpha *= std::clamp((1 - v) / (1 - BURST_MIN_LENGTH / BURST_MAX_LENGTH), 0.f, 1.f);
+				setPixel(pixels, texels.x + x, texels.y + y, brightness, alpha);
+			}
+		}
+	}
+}
+
+bool LaserBatch::createTexture(SDL_Renderer* renderer)
+{
+	if (texture != nullptr) return true;
+	if (!isRasterized())
+		rasterize();
+
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	if (texture == nullptr || SDL_UpdateTexture(texture, nullptr, pixels.data(), TEXTURE_WIDTH * 4) != 0)
+	{
+		std::cout << "Failed to create the beam texture! SDL Error: " << SDL_GetError() << std::endl;
+		destroy();
+		return false;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	// the cross sections are stretched across strips of any width
+	SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+	return true;
+}
+
+void LaserBatch::destroy()
+{
+	if (texture != nullptr)
+		SDL_DestroyTexture(texture);
+	texture = nullptr;
+}
+
+bool LaserBatch::isRasterized() const
+{
+	return !pixels.empty();
+}
+
+SDL_Texture* LaserBatch::getTexture() const
+{
+	return texture;
+}
+
+const Uint8* LaserBatch::getPixels() const
+{
+	return pixels.data();
+}
+
+// A quad from <start> to <end>, the cross section of <region> is stretched across it
+void LaserBatch::addStrip(Region region, SDL_FPoint start, SDL_FPoint end, SDL_FPoint across, float startHalfWidth, float endHalfWidth, SDL_Color color)
+{
+	const SDL_Rect texels = getTexels(region);
+	const float left = static_cast<float>(texels.x) / TEXTURE_WIDTH;
+	const float right = static_cast<float>(texels.x + texels.w) / TEXTURE_WIDTH;
+	const float middle = (texels.y + texels.h * 0.5f) / TEXTURE_HEIGHT;
+
+	const int first = static_cast<int>(vertices.size());
+	vertices.push_back(SDL_Vertex{ { start.x - across.x * startHalfWidth, start.y - across.y * startHalfWidth }, color, { left, middle } });
+	vertices.push_back(SDL_Vertex{ { start.x + across.x * startHalfWidth, start.y + across.y * startHalfWidth }, color, { right, middle } });
+	vertices.push_back(SDL_Vertex{ { end.x - across.x * endHalfWidth, end.y - across.y * endHalfWidth }, color, { left, middle } });
+	vertices.push_back(SDL_Vertex{ { end.x + across.x * endHalfWidth, end.y + across.y * endHalfWidth }, color, { right, middle } });
+	indices.insert(indices.end(), { first, first + 1, first + 2, first + 2, first + 1, first + 3 });
+}
+
+// A triangle that widens from <apex>, so the lines of the burst fan out like a cone
+void LaserBatch::addCone(SDL_FPoint apex, SDL_FPoint baseCenter, SDL_FPoint across, float halfWidth, SDL_Color color)
+{
+	const SDL_Rect texels = getTexels(Region::Burst);
+	const float left = static_cast<float>(texels.x) / TEXTURE_WIDTH;
+	const float right = static_cast<float>(texels.x + texels.w) / TEXTURE_WIDTH;
+	const float top = static_cast<float>(texels.y) / TEXTURE_HEIGHT;
+	const float bottom = static_cast<float>(texels.y + texels.h) / TEXTURE_HEIGHT;
+
+	const int first = static_cast<int>(vertices.size());
+	vertices.push_back(SDL_Vertex{ apex, color, { (left + right) * 0.5f, top } });
+	vertices.push_back(SDL_Vertex{ { baseCenter.x - across.x * halfWidth, baseCenter.y - across.y * halfWidth }, color, { left, bottom } });
+	vertices.push_back(SDL_Vertex{ { baseCenter.x + across.x * halfWidth, baseCenter.y + across.y * halfWidth }, color, { right, bottom } });
+	indices.insert(indices.end(), { first, first + 1, first + 2 });
+}
+
+void LaserBatch::addRing(SDL_FPoint center, SDL_Color color)
+{
+	const SDL_Rect texels = getTexels(Region::Ring);
+	const float halfWidth = getCrossSection(Region::Ring).halfWidth;
+	const float left = static_cast<float>(texels.x) / TEXTURE_WIDTH;
+	const float right = static_cast<float>(texels.x + texels.w) / TEXTURE_WIDTH;
+	const float top = static_cast<float>(texels.y) / TEXTURE_HEIGHT;
+	const float bottom = static_cast<float>(texels.y + texels.h) / TEXTURE_HEIGHT;
+
+	const int first = static_cast<int>(vertices.size());
+	vertices.push_back(SDL_Vertex{ { center.x - halfWidth, center.y - halfWidth }, color, { left, top } });
+	vertices.push_back(SDL_Vertex{ { center.x + halfWidth, center.y - halfWidth }, color, { right, top } });
+	vertices.push_back(SDL_Vertex{ { center.x - halfWidth, center.y + halfWidth }, color, { left, bottom } });
+	vertices.push_back(SDL_Vertex{ { center.x + halfWidth, center.y + halfWidth }, color, { right, bottom } });
+	indices.insert(indices.end(), { first, first + 1, first + 2, first + 2, first + 1, first + 3 });
+}
+
+int LaserBatch::emit(const Lasers& lasers, Position playerPos, Detail detail)
+{
+	vertices.clear();
+	indices.clear();
+	// reduced leaves out the burst and the darker lines, minimal also the ring at the end and the moving trail
+	const bool isFull = detail == Detail::Full;
+	const bool isMinimal = detail == Detail::Minimal;
+
+	// the widths of the parts that don't change from laser to laser
+	static const float burstHalfWidth = getCrossSection(Region::Burst).halfWidth;
+	static const float trailHalfWidth = getCrossSection(Region::Trail).halfWidth;
+	static const float lineHalfWidth = getCrossSection(Region::Line).halfWidth;
+	static const float darkLinesHalfWidth = getCrossSection(Region::DarkLines).halfWidth;
+
+	lasers.forEachChunk<LifeTimeObject, Line, Color>([&](size_t count, const LifeTimeObject* lifeTimes, const Line* lines, const Color* colors)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const LifeTimeObject& lifeTime = lifeTimes[i];
+			const Line& line = lines[i];
+			Color color = colors[i];
+
+			const Vector2 playerToEndDirection = unitDirection(playerPos.x, playerPos.y, line.x2, line.y2);
+			const Vector2 playerEdgePosition = Vector2(playerPos.x, playerPos.y) + playerToEndDirection * playerPos.radius;
+
+			// the line's lifetime eased with the same functions as drawLaserLines()
+			const float progress = lifeTime.elapsedLifeTime / lifeTime.totalLifeTime;
+			const float progress1 = Ease::InOutSine(progress);
+			const float progress2 = Ease::Out(progress1, 4);
+			const float progress3 = Ease::Out(progress, 5);
+
+			color.a *= 1 - progress2;
+
+			const Vector2 basePosition(line.x1, line.y1);
+			const Vector2 endPosition(line.x2, line.y2);
+			const Vector2 startPosition(std::lerp(line.x1, endPosition.x, progress1), std::lerp(line.y1, endPosition.y, progress1));
+			const Vector2 direction = unitDirection(basePosition, endPosition);
+			const SDL_FPoint across = toPoint(direction.perpendicularVector());
+
+			// the layers get fewer toward the end of the laser's lifetime, and start narrow at the beginning of the beam
+			const int layerCount =
+				progress2 < 0.4f ? 4 :
+				progress2 < 0.5f ? 3 :
+				progress2 < 0.6f ? 2 :
+				progress2 < 0.7f ? 1 : 0;
+			if (layerCount > 0)
+			{
+				const float halfWidth = static_cast<float>(layerCount + 1);
+				const float startHalfWidth = progress3 > 0.f ? halfWidth * (1 - progress3) : 0.f;
+				const Region region = static_cast<Region>(static_cast<int>(Region::Beam1) + layerCount - 1);
+				addStrip(region, toPoint(startPosition), toPoint(endPosition), across, startHalfWidth, halfWidth, withAlpha(color, 1.f, color.a));
+			}
+
+			if (progress2 < 0.4f && !isMinimal)
+			{
+				addRing(toPoint(endPosition), withAlpha(color, 1.f, color.a * 0.25f));
+				if (progress2 < 0.2f && isFull)
+				{
+					const float burstProgress = lifeTime.elapsedLifeTime / 0.2f;
+					const Vector2 apex = playerEdgePosition - direction * 20;
+					const Vector2 baseCenter = basePosition + direction * (BURST_MAX_LENGTH * (0.5f + burstProgress));
+					addCone(toPoint(apex), toPoint(baseCenter), across, burstHalfWidth, withAlpha(color, 1.f, color.a * (1 - burstProgress)));
+
+					if (progress2 < 0.1f)
+					{
+						// the darker lines meet at the end of the beam, a strip can only narrow them toward it
+						const SDL_Color darkColor = withAlpha(color, 0.7f, color.a * (1 - lifeTime.elapsedLifeTime / 0.1f));
+						addStrip(Region::DarkLines, toPoint(basePosition), toPoint(endPosition), across, darkLinesHalfWidth, darkLinesHalfWidth * 5 / 7, darkColor);
+					}
+				}
+			}
+
+			// static transparent trail
+			addStrip(Region::Trail, toPoint(basePosition), toPoint(endPosition), across, trailHalfWidth, trailHalfWidth, withAlpha(color, 0.8f, color.a * (1 - progress2)));
+
+			// moving transparent trail
+			if (progress2 < 0.8f && progress2 > 0.05f && !isMinimal)
+			{
+				addStrip(Region::Line, toPoint(startPosition - direction * 50.f), toPoint(endPosition), across, lineHalfWidth, lineHalfWidth,
+					withAlpha(color, 1.f, 255 * (1 - progress2 / 0.8f)));
+			}
+
+			// highlight
+			addStrip(Region::Line, toPoint(startPosition), toPoint(endPosition), across, lineHalfWidth, lineHalfWidth, SDL_Color{ 255, 255, 255, color.a });
+		}
+	});
+	return static_cast<int>(indices.size());
+}
+
+const SDL_Vertex* LaserBatch::getVertices() const
+{
+	return vertices.data();
+}
+
+int LaserBatch::getVertexCount() const
+{
+	return static_cast<int>(vertices.size());
+}
+
+const int* LaserBatch::getIndices() const
+{
+	return indices.data();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "detailController.h"
+#include "gameObject.h"
+
+using namespace GameObject;
+
+/// <summary>
+/// Draws all lasers as one batch of textured strips, with a single SDL_RenderGeometry() call.
+///
+/// The lines Rendering::drawLaserLines() draws one by one (the layers of the beam, the burst cone,
+/// the darker lines, the trails and the highlight) are pre-rendered as cross sections into a small
+/// beam texture. Every part of a laser then becomes one quad, stretched from its start to its end and
+/// tinted with the vertex color, with the same easing curves driving its width and alpha.
+///
+/// The burst used to be 18 lines of random lengths every frame, it's one cone that fades out over
+/// the range those lengths were picked from, so it no longer flickers.
+/// </summary>
+struct LaserBatch
+{
+	static constexpr int TEXTURE_WIDTH = 64; // across the beam
+	static constexpr int TEXTURE_HEIGHT = 96;
+
+	// The cross sections in the beam texture, each a row, except the burst cone and the ring at the end
+	enum class Region { Beam1, Beam2, Beam3, Beam4, Trail, Line, DarkLines, Burst, Ring, Count };
+
+private:
+	std::vector<Uint8> pixels; // RGBA32
+	SDL_Texture* texture = nullptr;
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+
+	void addStrip(Region region, SDL_FPoint start, SDL_FPoint end, SDL_FPoint across, float startHalfWidth, float endHalfWidth, SDL_Color color);
+	void addCone(SDL_FPoint apex, SDL_FPoint baseCenter, SDL_FPoint across, float halfWidth, SDL_Color color);
+	void addRing(SDL_FPoint center, SDL_Color color);
+
+public:
+	// Draws the cross sections into pixels, doesn't need a renderer
+	void rasterize();
+	// Rasterizes the beam texture if it isn't yet, and uploads it
+	bool createTexture(SDL_Renderer* renderer);
+	void destroy();
+
+	bool isRasterized() const;
+	SDL_Texture* getTexture() const;
+	const Uint8* getPixels() const;
+
+	// Writes the strips of every laser, fired from the player at <playerPos>, fewer of them below full <detail>.
+	// Returns how many indices were written
+	int emit(const Lasers& lasers, Position playerPos, Detail detail);
+	// Of the last emit(), valid until the next one
+	const SDL_Vertex* getVertices() const;
+	int getVertexCount() const;
+	const int* getIndices() const;
+};
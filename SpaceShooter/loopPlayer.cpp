@@ -0,0 +1,152 @@
+#include "loopPlayer.h"
+#include "audioMixer.h"
+
+// Runs on the audio thread. The stream is silent when this is called, and sound effects are mixed on top afterwards
+void SDLCALL LoopPlayer::mix(void* userData, Uint8* stream, int length)
+{
+	LoopPlayer& player = *static_cast<LoopPlayer*>(userData);
+	Sint16* output = reinterpret_cast<Sint16*>(stream);
+	const int frameCount = length / static_cast<int>(sizeof(Sint16) * player.channels);
+
+	SDL_AtomicLock(&player.lock);
+	if (player.currentLoop < 0)
+	{
+		SDL_AtomicUnlock(&player.lock);
+		return;
+	}
+	const Loop& loop = player.loops[player.currentLoop];
+	const float volume = static_cast<float>(player.volume) / MIX_MAX_VOLUME;
+
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		if (player.gain != player.targetGain)
+		{
+			player.gain += player.gainStep;
+			if ((player.gainStep > 0 && player.gain >= player.targetGain) || (player.gainStep < 0 && player.gain <= player.targetGain))
+				player.gain = player.targetGain;
+		}
+		if (player.stopAtTarget && player.gain == player.targetGain)
+		{
+			player.currentLoop = -1;
+			break;
+		}
+
+		const float frameGain = player.gain * volume;
+		const Sint16* samples = loop.samples + player.cursor * player.channels;
+		for (int channel = 0; channel < player.channels; channel++)
+		{
+			output[frame * player.channels + channel] = static_cast<Sint16>(samples[channel] * frameGain);
+		}
+
+		if (++player.cursor == loop.frameCount)
+			player.cursor = 0;
+		player.playedFrames++;
+	}
+	SDL_AtomicUnlock(&player.lock);
+}
+
+bool LoopPlayer::hook()
+{
+	Uint16 format;
+	if (Mix_QuerySpec(&frequency, &format, &channels) == 0 || format != AUDIO_S16SYS)
+		return false;
+
+	AudioMixer::hookMusic(mix, this);
+	return true;
+}
+
+void LoopPlayer::unhook()
+{
+	AudioMixer::hookMusic(nullptr, nullptr);
+	currentLoop = -1;
+}
+
+bool LoopPlayer::load(int index, const Mix_Chunk* chunk)
+{
+	const Uint32 frameSize = static_cast<Uint32>(sizeof(Sint16) * channels);
+	if (index < 0 || index >= MAX_LOOPS || chunk == nullptr || chunk->alen < frameSize)
+		return false;
+
+	SDL_AtomicLock(&lock);
+	loops[index] = Loop{ reinterpret_cast<const Sint16*>(chunk->abuf), chunk->alen / frameSize };
+	SDL_AtomicUnlock(&lock);
+	return true;
+}
+
+// Starts the loop from its first sample, fading in from silence
+void LoopPlayer::play(int index, int fadeInMilliseconds)
+{
+	if (index < 0 || index >= MAX_LOOPS || loops[index].samples == nullptr) return;
+
+	const float fadeFrames = static_cast<float>(fadeInMilliseconds) * 0.001f * frequency;
+
+	SDL_AtomicLock(&lock);
+	currentLoop = index;
+	cursor = 0;
+	playedFrames = 0;
+	gain = fadeFrames > 0 ? 0.f : 1.f;
+	targetGain = 1.f;
+	gainStep = fadeFrames > 0 ? 1.f / fadeFrames : 0.f;
+	stopAtTarget = false;
+	SDL_AtomicUnlock(&lock);
+}
+
+// Fades out from the current gain, and stops when it reaches silence
+void LoopPlayer::fadeOut(int milliseconds)
+{
+	const float fadeFrames = static_cast<float>(milliseconds) * 0.001f * frequency;
+
+	SDL_AtomicLock(&lock);
+	targetGain = 0.f;
+	gainStep = fadeFrames > 0 ? -gain / fadeFrames : -gain;
+	stopAtTarget = true;
+	SDL_AtomicUnlock(&lock);
+}
+
+void LoopPlayer::stop()
+{
+	SDL_AtomicLock(&lock);
+	currentLoop = -1;
+	SDL_AtomicUnlock(&lock);
+}
+
+void LoopPlayer::setVolume(int newVolume)
+{
+	SDL_AtomicLock(&lock);
+	volume = newVolume;
+	SDL_AtomicUnlock(&lock);
+}
+
+bool LoopPlayer::isPlaying()
+{
+	SDL_AtomicLock(&lock);
+	const bool playing = currentLoop >= 0;
+	SDL_AtomicUnlock(&lock);
+	return playing;
+}
+
+Uint32 LoopPlayer::getFrameCount(int index) const
+{
+	return index >= 0 && index < MAX_LOOPS ? loops[index].frameCount : 0;
+}
+
+int LoopPlayer::getFrequency() const
+{
+	return frequency;
+}
+
+double LoopPlayer::getPosition()
+{
+	SDL_AtomicLock(&lock);
+	const Uint64 frames = cursor;
+	SDL_AtomicUnlock(&lock);
+	return static_cast<double>(frames) / frequency;
+}
+
+Sint64 LoopPlayer::getPlayedFrames()
+{
+	SDL_AtomicLock(&lock);
+	const Uint64 frames = playedFrames;
+	SDL_AtomicUnlock(&lock);
+	return static_cast<Sint64>(frames);
+}
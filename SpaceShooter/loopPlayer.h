@@ -0,0 +1,55 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+/// <summary>
+/// Plays music loops that are already decoded into memory (Mix_Chunks in the mixer's format),
+/// instead of streaming them from disk with Mix_PlayMusic.
+/// It replaces the music player through AudioMixer::hookMusic(), and keeps a cursor
+/// in sample frames, so the loop point and the playback position are sample accurate.
+/// Changing loops never touches the disk or a decoder, so there's nothing to warm up.
+///
+/// Only 16-bit output is supported, load() fails for other formats.
+/// </summary>
+struct LoopPlayer
+{
+private:
+	struct Loop { const Sint16* samples; Uint32 frameCount; };
+
+	static constexpr int MAX_LOOPS = 8;
+	Loop loops[MAX_LOOPS] = {};
+	int channels = 2;
+	int frequency = 44100;
+
+	// everything below is shared with the audio thread, guarded by lock
+	SDL_SpinLock lock = 0;
+	int currentLoop = -1;
+	Uint64 cursor = 0; // in sample frames, from the start of the current loop
+	Uint64 playedFrames = 0; // since play(), counting every time the loop came around
+	float gain = 0;
+	float gainStep = 0; // per frame
+	float targetGain = 0;
+	bool stopAtTarget = false;
+	int volume = MIX_MAX_VOLUME;
+
+	static void SDLCALL mix(void* userData, Uint8* stream, int length);
+
+public:
+	// Starts feeding the mixer, call after the audio device is opened
+	bool hook();
+	void unhook();
+
+	// The chunk has to stay loaded as long as this player uses it
+	bool load(int index, const Mix_Chunk* chunk);
+	void play(int index, int fadeInMilliseconds = 0);
+	void fadeOut(int milliseconds);
+	void stop();
+	void setVolume(int newVolume);
+
+	bool isPlaying();
+	double getPosition(); // in seconds
+	// The audio cursor in sample frames since play(), for the beat grid
+	Sint64 getPlayedFrames();
+	Uint32 getFrameCount(int index) const;
+	int getFrequency() const;
+};
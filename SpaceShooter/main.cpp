@@ -5,11 +5,23 @@
 // where an object oriented approach probably would make more sense
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <map>
+#include <cstring>
+#include <thread>
 #include <SDL.h>
+#include "assetArchive.h"
+#include "assetCache.h"
+#include "assetLoader.h"
 #include "assets.h"
+#include "audioMixer.h"
+#include "beatAnalyzer.h"
+#include "benchmark.h"
 #include "engine.h"
+#include "framePipeline.h"
+#include "game.h"
+#include "goldenFrames.h"
 #include "player.h"
 #include "sprite.h"
 #include "crosshair.h"
@@ -21,87 +33,219 @@
 using namespace std;
 using namespace Engine;
 
-UI::Button waitForButtonPress(UI::Menu menu, MusicManager& musicManager, Crosshair& crosshair, int playerHealth);
+UI::Button waitForButtonPress(UI::Menu menu, World& world, MusicManager& musicManager, Crosshair& crosshair, int playerHealth);
+bool hasArgument(int argc, char** args, const char* argument);
+int getIntArgument(int argc, char** args, const char* argument, int defaultValue);
 
 int main(int argc, char** args)
 {
-	Engine::initializeEngine(Assets::texturePaths, size(Assets::texturePaths));
+	// headless: --benchmark [worldCount] [frameCount]
+	if (argc > 1 && strcmp(args[1], "--benchmark") == 0)
+	{
+		const int worldCount = argc > 2 ? atoi(args[2]) : static_cast<int>(thread::hardware_concurrency());
+		const int frameCount = argc > 3 ? atoi(args[3]) : 120 * 60;
+		Benchmark::runWorlds(worldCount > 0 ? worldCount : 1, frameCount, Assets::stressWavesPath);
+		return 0;
+	}
+	// headless: --benchmark-mixer [voiceCount] [bufferFrames]
+	if (argc > 1 && strcmp(args[1], "--benchmark-mixer") == 0)
+	{
+		const int voiceCount = argc > 2 ? atoi(args[2]) : 32;
+		const int bufferFrames = argc > 3 ? atoi(args[3]) : 256;
+		Benchmark::runMixer((std::max)(voiceCount, 1), std::clamp(bufferFrames, AudioMixer::MIN_BUFFER_FRAMES, AudioMixer::MAX_BUFFER_FRAMES));
+		return 0;
+	}
+	// headless: --benchmark-stars [starCount] [frameCount]
+	if (argc > 1 && strcmp(args[1], "--benchmark-stars") == 0)
+	{
+		const int starCount = argc > 2 ? atoi(args[2]) : 100'000;
+		const int frameCount = argc > 3 ? atoi(args[3]) : 300;
+		Benchmark::runStars((std::max)(starCount, 1), (std::max)(frameCount, 1));
+		return 0;
+	}
+	// headless: --benchmark-lasers [laserCount] [frameCount]
+	if (argc > 1 && strcmp(args[1], "--benchmark-lasers") == 0)
+	{
+		const int laserCount = argc > 2 ? atoi(args[2]) : 50;
+		const int frameCount = argc > 3 ? atoi(args[3]) : 300;
+		Benchmark::runLasers((std::max)(laserCount, 1), (std::max)(frameCount, 1));
+		return 0;
+	}
+	// headless: --benchmark-glows [objectCount] [frameCount]
+	if (argc > 1 && strcmp(args[1], "--benchmark-glows") == 0)
+	{
+		const int objectCount = argc > 2 ? atoi(args[2]) : 300;
+		const int frameCount = argc > 3 ? atoi(args[3]) : 300;
+		Benchmark::runFadingObjects((std::max)(objectCount, 1), (std::max)(frameCount, 1));
+		return 0;
+	}
+	// headless: --benchmark-beats [objectCount] [frameCount]
+	if (argc > 1 && strcmp(args[1], "--benchmark-beats") == 0)
+	{
+		const int objectCount = argc > 2 ? atoi(args[2]) : 300;
+		const int frameCount = argc > 3 ? atoi(args[3]) : 300;
+		Benchmark::runBeatCircles((std::max)(objectCount, 1), (std::max)(frameCount, 1));
+		return 0;
+	}
+	// headless: --benchmark-raster [frameCount] [threadCount] [pngPath]
+	if (argc > 1 && strcmp(args[1], "--benchmark-raster") == 0)
+	{
+		const int frameCount = argc > 2 ? atoi(args[2]) : 600;
+		const int threadCount = argc > 3 ? atoi(args[3]) : static_cast<int>(thread::hardware_concurrency());
+		Benchmark::runRasterizer((std::max)(frameCount, 1), (std::max)(threadCount, 1), Assets::stressWavesPath, argc > 4 ? args[4] : nullptr);
+		return 0;
+	}
+	// headless: --golden-record [replayPath] [directory], draws the captures of a replay as the reference images
+	if (argc > 1 && strcmp(args[1], "--golden-record") == 0)
+	{
+		return GoldenFrames::record(argc > 2 ? args[2] : Assets::goldenReplayPath, argc > 3 ? args[3] : Assets::goldenFramesPath) ? 0 : 1;
+	}
+	// headless: --golden-compare [replayPath] [directory], fails if a capture drifted from its reference image
+	if (argc > 1 && strcmp(args[1], "--golden-compare") == 0)
+	{
+		return GoldenFrames::compare(argc > 2 ? args[2] : Assets::goldenReplayPath, argc > 3 ? args[3] : Assets::goldenFramesPath) ? 0 : 1;
+	}
+	// build step: --pack [--decoded], writes all startup assets into one archive
+	if (argc > 1 && strcmp(args[1], "--pack") == 0)
+	{
+		const bool preDecode = argc > 2 && strcmp(args[2], "--decoded") == 0;
+		return AssetArchive::pack(Assets::archivePath, Assets::getStartupAssets(), preDecode) ? 0 : 1;
+	}
+	// build step: --analyze [--song] [--signature <beats>] [files...], writes a .beats grid next to every file (the beat loops by default).
+	// --song is for tracks that aren't loops, their tempo isn't snapped to the length
+	if (argc > 1 && strcmp(args[1], "--analyze") == 0)
+	{
+		std::vector<std::string> paths;
+		for (int i = 2; i < argc; i++)
+		{
+			if (strcmp(args[i], "--signature") == 0 || strcmp(args[i], "--song") == 0)
+				i += strcmp(args[i], "--signature") == 0;
+			else
+				paths.push_back(args[i]);
+		}
+		if (paths.empty())
+		{
+			for (const Beat& beat : Assets::beats)
+			{
+				paths.push_back(beat.path);
+			}
+		}
+		const bool areLoops = !hasArgument(argc, args, "--song");
+		return BeatAnalyzer::analyzeFiles(paths, getIntArgument(argc, args, "--signature", 4), areLoops) ? 0 : 1;
+	}
+
+	// --audio-buffer <frames> sets the output buffer (64 - 1024), --sdl-mixer mixes sounds with SDL_mixer instead of AudioMixer's own callback
+	const AudioMixer::Backend audioBackend = hasArgument(argc, args, "--sdl-mixer") ? AudioMixer::Backend::SDLMixer : AudioMixer::Backend::Callback;
+	Engine::initializeEngine(audioBackend, getIntArgument(argc, args, "--audio-buffer", 256));
+	AssetArchive::open(Assets::archivePath);
+	// --stream-music streams the beat loops from disk instead of decoding them up front,
+	// --music-prefetch <milliseconds> is how far ahead they're read (20 - 5000)
+	const bool streamMusic = hasArgument(argc, args, "--stream-music");
+	AssetLoader::loadAll(Assets::getStartupAssets(!streamMusic));
+	Engine::loadTextures(Assets::texturePaths, size(Assets::texturePaths));
 	
 	
-	Crosshair crosshair(25, 25, Assets::crosshairTexturePath, Rendering::getRenderer());
+	Crosshair crosshair(25, 25, Assets::crosshairTexturePath);
 
-	MusicManager musicManager{ Assets::beats };
-	Player player{ &musicManager , Rendering::getRenderer() };
+	MusicManager musicManager{ Assets::beats, !streamMusic, getIntArgument(argc, args, "--music-prefetch", 500) };
+	World world;
+	Player player{ &world, &musicManager , Rendering::getRenderer() };
 
-	WaveManager::initialize(&musicManager, 10);
+	const bool stressTest = hasArgument(argc, args, "--stress");
+	WaveManager waveManager{ &world, &musicManager, stressTest ? Assets::stressWavesPath : Assets::defaultWavesPath };
+	waveManager.initialize(10);
 
-	UI::Button buttonPressed = waitForButtonPress(UI::Menu::intro, musicManager, crosshair, player.remainingHealth);
+	UI::Button buttonPressed = waitForButtonPress(UI::Menu::intro, world, musicManager, crosshair, player.remainingHealth);
 	bool gameRunning = buttonPressed != UI::Button::quit;
 	bool gamePaused = false;
 
 	musicManager.startPlaying();
-	WaveManager::start();
+	waveManager.start();
+
+	// the objects move and collide on a worker while the frame they were recorded in last is drawn,
+	// --serial-frames runs both on the main thread, one after the other
+	FramePipeline pipeline([&](FrameSnapshot& frame)
+	{
+		world.updateObjects(musicManager.data->wholeNoteLength);
+		world.checkForObjectDestruction(&player);
+		frame.record(world, *musicManager.data, player.remainingHealth);
+		frame.audioEvents.swap(player.audioEvents);
+	}, !hasArgument(argc, args, "--serial-frames"));
+	pipeline.getDrawnFrame().record(world, *musicManager.data, player.remainingHealth);
 
 	// MAIN GAME LOOP
 	while (gameRunning)
 	{
-		const float deltaTime = Engine::updateTicks();
-		Engine::updateObjects(musicManager.data->wholeNoteLength);
-		Engine::printTimeStats();
+		const float deltaTime = world.updateTicks();
+		Engine::printTimeStats(world);
 
 		musicManager.update(deltaTime);
 		musicManager.printStats();
 
+		pipeline.beginStep();
+		const FrameSnapshot& frame = pipeline.getDrawnFrame();
+		const Position drawnPlayerPos = frame.playerPos;
 		Rendering::renderClear();
-		Engine::drawEverything(musicManager.data, player.remainingHealth);
-		Engine::checkForObjectDestruction(&player);
+		Engine::drawEverything(frame);
+		pipeline.endStep();
+		// the mixer and the voices belong to the main thread
+		musicManager.play(pipeline.getDrawnFrame().audioEvents);
 		
-		player.update(deltaTime, musicManager.data->pulseMultiplier);
+		player.update(deltaTime, musicManager.data->pulseMultiplier, drawnPlayerPos);
 		crosshair.draw(Rendering::getRenderer(), musicManager.data->quarterNoteProgress, player.timeSinceLastFail);
 
-		handleInputEvents(player, musicManager, gameRunning, gamePaused, deltaTime);
+		handleInputEvents(world, player, musicManager, gameRunning, gamePaused, deltaTime);
 		if (gamePaused)
 		{
-			WaveManager::pause();
-			buttonPressed = waitForButtonPress(UI::Menu::pause, musicManager, crosshair, player.remainingHealth);
+			waveManager.pause();
+			buttonPressed = waitForButtonPress(UI::Menu::pause, world, musicManager, crosshair, player.remainingHealth);
 			gameRunning = buttonPressed != UI::Button::quit;
 			gamePaused = false;
 			if (gameRunning)
 			{
-				WaveManager::start();
+				waveManager.start();
 			}
+			// the menu moved the objects, outside of the pipeline
+			pipeline.getDrawnFrame().record(world, *musicManager.data, player.remainingHealth);
 		}
 		else if (player.remainingHealth <= 0)
 		{
-			WaveManager::pause();
-			buttonPressed = waitForButtonPress(UI::Menu::gameOver, musicManager, crosshair, player.remainingHealth);
+			waveManager.pause();
+			buttonPressed = waitForButtonPress(UI::Menu::gameOver, world, musicManager, crosshair, player.remainingHealth);
 			gameRunning = buttonPressed != UI::Button::quit;
 			if (!gameRunning) break;
 			
 			player.reset();
 			musicManager.changeBeat(0);
-			WaveManager::restart();
-			Engine::resetKeys();
+			waveManager.restart();
+			world.resetKeys();
+			pipeline.getDrawnFrame().record(world, *musicManager.data, player.remainingHealth);
 		}
 
 		Rendering::renderPresent();
-		Engine::delayNextFrame();
+		Engine::delayNextFrame(world);
 	}
-	Engine::unloadTextures();
 	musicManager.unload();
 	crosshair.destroy();
 	player.destroy();
+	AssetCache::printStats();
+	AudioMixer::printStats();
+	musicManager.printSoundStats();
+	Rendering::printLayerStats();
+	pipeline.printStats();
+	Engine::unloadTextures();
 	cout << "Quitting ..." << endl;
+	AssetArchive::close();
 	Engine::quit();
 
 	return 0;
 }
 
 // Loops during intro, pause and game over menu until player presses a button
-UI::Button waitForButtonPress(UI::Menu menu, MusicManager& musicManager, Crosshair& crosshair, int playerHealth)
+UI::Button waitForButtonPress(UI::Menu menu, World& world, MusicManager& musicManager, Crosshair& crosshair, int playerHealth)
 {
 	SDL_Renderer* renderer = Rendering::getRenderer();
-	UI::Buttons buttons(renderer, menu);
+	UI::Buttons buttons(menu);
 
 	Sprite overlay(WIDTH, HEIGHT);
 	overlay.load(Assets::menuOverlayPaths.at(menu), Rendering::getRenderer());
@@ -114,10 +258,10 @@ UI::Button waitForButtonPress(UI::Menu menu, MusicManager& musicManager, Crossha
 	while (buttonPressed == UI::Button::none || elapsedFadeTime < fadeOutTime)
 	{
 		Rendering::renderClear();
-		const float deltaTime = Engine::updateTicks();
-		Engine::rotateObjects();
-		Engine::updateObjectsLifetime(musicManager.data->wholeNoteLength, true);
-		Engine::drawEverything(musicManager.data, playerHealth, true);
+		const float deltaTime = world.updateTicks();
+		world.rotateObjects();
+		world.updateObjectsLifetime(musicManager.data->wholeNoteLength, true);
+		Engine::drawEverything(world, musicManager.data, playerHealth, true);
 		musicManager.update(deltaTime);
 
 		if (buttonPressed == UI::Button::none)
@@ -130,9 +274,10 @@ UI::Button waitForButtonPress(UI::Menu menu, MusicManager& musicManager, Crossha
 		{
 			elapsedFadeTime += deltaTime;
 			fadeOutProgress = clamp(elapsedFadeTime / (fadeOutTime+0.05f), 0.f, 0.99f);
-			overlay.updateOpacity(powf(1.f - fadeOutProgress,2));
 		}
 
+		// the overlay texture is shared with the other menus, set its opacity for every draw
+		overlay.updateOpacity(powf(1.f - fadeOutProgress,2));
 		overlay.draw(0, 0, WIDTH, HEIGHT, renderer);
 
 		if (fadeOutProgress <= 0.001f)
@@ -149,3 +294,24 @@ UI::Button waitForButtonPress(UI::Menu menu, MusicManager& musicManager, Crossha
 	return buttonPressed;
 }
 
+// Checks if <argument> was passed on the command line, in any position
+bool hasArgument(int argc, char** args, const char* argument)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(args[i], argument) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Returns the number after <argument> on the command line, or <defaultValue> if it wasn't passed
+int getIntArgument(int argc, char** args, const char* argument, int defaultValue)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(args[i], argument) == 0)
+			return atoi(args[i + 1]);
+	}
+	return defaultValue;
+}
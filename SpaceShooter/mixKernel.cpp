@@ -0,0 +1,203 @@
+#include "mixKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+// MSVC lets any function use any intrinsics, other compilers have to be told which functions may use AVX2
+#if defined(__GNUC__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+namespace MixKernel
+{
+	constexpr float FLOAT_TO_INT16 = 32768.f;
+
+	Path detectPath()
+	{
+		if (SDL_HasAVX2()) return Path::AVX2;
+		if (SDL_HasSSE2()) return Path::SSE2;
+		return Path::Scalar;
+	}
+
+	Path path = detectPath();
+
+#pragma region Scalar
+	void accumulateScalar(float* mixBuffer, const Sint16* voice, Uint32 sampleCount, float gain)
+	{
+		for (Uint32 i = 0; i < sampleCount; i++)
+		{
+			mixBuffer[i] += static_cast<float>(voice[i]) * gain;
+		}
+	}
+
+	void accumulateScalar(float* mixBuffer, const float* voice, Uint32 sampleCount, float gain)
+	{
+		for (Uint32 i = 0; i < sampleCount; i++)
+		{
+			mixBuffer[i] += voice[i] * gain;
+		}
+	}
+
+	void clipScalar(Sint16* output, const float* mixBuffer, Uint32 sampleCount)
+	{
+		for (Uint32 i = 0; i < sampleCount; i++)
+		{
+			output[i] = static_cast<Sint16>(std::lrint(std::clamp(mixBuffer[i], -32768.f, 32767.f)));
+		}
+	}
+#pragma endregion
+
+#pragma region SSE2
+	// 8 samples per iteration, the rest is done by the scalar version
+	void accumulateSSE2(float* mixBuffer, const Sint16* voice, Uint32 sampleCount, float gain)
+	{
+		const __m128 gains = _mm_set1_ps(gain);
+		Uint32 i = 0;
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			// SSE2 has no sign extension, so the samples are put in the top half of each int and shifted down
+			const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(voice + i));
+			const __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+			const __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+			_mm_storeu_ps(mixBuffer + i, _mm_add_ps(_mm_loadu_ps(mixBuffer + i), _mm_mul_ps(low, gains)));
+			_mm_storeu_ps(mixBuffer + i + 4, _mm_add_ps(_mm_loadu_ps(mixBuffer + i + 4), _mm_mul_ps(high, gains)));
+		}
+		accumulateScalar(mixBuffer + i, voice + i, sampleCount - i, gain);
+	}
+
+	void accumulateSSE2(float* mixBuffer, const float* voice, Uint32 sampleCount, float gain)
+	{
+		const __m128 gains = _mm_set1_ps(gain);
+		Uint32 i = 0;
+		for (; i + 4 <= sampleCount; i += 4)
+		{
+			_mm_storeu_ps(mixBuffer + i, _mm_add_ps(_mm_loadu_ps(mixBuffer + i), _mm_mul_ps(_mm_loadu_ps(voice + i), gains)));
+		}
+		accumulateScalar(mixBuffer + i, voice + i, sampleCount - i, gain);
+	}
+
+	void clipSSE2(Sint16* output, const float* mixBuffer, Uint32 sampleCount)
+	{
+		const __m128 minimum = _mm_set1_ps(-32768.f);
+		const __m128 maximum = _mm_set1_ps(32767.f);
+		Uint32 i = 0;
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			const __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(mixBuffer + i), minimum), maximum);
+			const __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(mixBuffer + i + 4), minimum), maximum);
+			const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+		}
+		clipScalar(output + i, mixBuffer + i, sampleCount - i);
+	}
+#pragma endregion
+
+#pragma region AVX2
+	// 16 samples per iteration, the rest is done by the scalar version
+	AVX2_FUNCTION void accumulateAVX2(float* mixBuffer, const Sint16* voice, Uint32 sampleCount, float gain)
+	{
+		const __m256 gains = _mm256_set1_ps(gain);
+		Uint32 i = 0;
+		for (; i + 16 <= sampleCount; i += 16)
+		{
+			const __m256 low = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(voice + i))));
+			const __m256 high = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(voice + i + 8))));
+			_mm256_storeu_ps(mixBuffer + i, _mm256_add_ps(_mm256_loadu_ps(mixBuffer + i), _mm256_mul_ps(low, gains)));
+			_mm256_storeu_ps(mixBuffer + i + 8, _mm256_add_ps(_mm256_loadu_ps(mixBuffer + i + 8), _mm256_mul_ps(high, gains)));
+		}
+		accumulateScalar(mixBuffer + i, voice + i, sampleCount - i, gain);
+	}
+
+	AVX2_FUNCTION void accumulateAVX2(float* mixBuffer, const float* voice, Uint32 sampleCount, float gain)
+	{
+		const __m256 gains = _mm256_set1_ps(gain);
+		Uint32 i = 0;
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			_mm256_storeu_ps(mixBuffer + i, _mm256_add_ps(_mm256_loadu_ps(mixBuffer + i), _mm256_mul_ps(_mm256_loadu_ps(voice + i), gains)));
+		}
+		accumulateScalar(mixBuffer + i, voice + i, sampleCount - i, gain);
+	}
+
+	AVX2_FUNCTION void clipAVX2(Sint16* output, const float* mixBuffer, Uint32 sampleCount)
+	{
+		const __m256 minimum = _mm256_set1_ps(-32768.f);
+		const __m256 maximum = _mm256_set1_ps(32767.f);
+		Uint32 i = 0;
+		for (; i + 16 <= sampleCount; i += 16)
+		{
+			const __m256 low = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(mixBuffer + i), minimum), maximum);
+			const __m256 high = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(mixBuffer + i + 8), minimum), maximum);
+			// packs works within each 128-bit lane, so the 64-bit quarters are put back in order afterwards
+			const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(low), _mm256_cvtps_epi32(high));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+		clipScalar(output + i, mixBuffer + i, sampleCount - i);
+	}
+#pragma endregion
+
+	Path getPath()
+	{
+		return path;
+	}
+
+	bool setPath(Path newPath)
+	{
+		if (!isSupported(newPath)) return false;
+		path = newPath;
+		return true;
+	}
+
+	bool isSupported(Path checkedPath)
+	{
+		switch (checkedPath)
+		{
+		case Path::AVX2: return SDL_HasAVX2();
+		case Path::SSE2: return SDL_HasSSE2();
+		default: return true;
+		}
+	}
+
+	const char* getPathName(Path namedPath)
+	{
+		switch (namedPath)
+		{
+		case Path::AVX2: return "AVX2";
+		case Path::SSE2: return "SSE2";
+		default: return "scalar";
+		}
+	}
+
+	void accumulate(float* mixBuffer, const Sint16* voice, Uint32 sampleCount, float gain)
+	{
+		switch (path)
+		{
+		case Path::AVX2: accumulateAVX2(mixBuffer, voice, sampleCount, gain); break;
+		case Path::SSE2: accumulateSSE2(mixBuffer, voice, sampleCount, gain); break;
+		default: accumulateScalar(mixBuffer, voice, sampleCount, gain); break;
+		}
+	}
+
+	void accumulate(float* mixBuffer, const float* voice, Uint32 sampleCount, float gain)
+	{
+		gain *= FLOAT_TO_INT16;
+		switch (path)
+		{
+		case Path::AVX2: accumulateAVX2(mixBuffer, voice, sampleCount, gain); break;
+		case Path::SSE2: accumulateSSE2(mixBuffer, voice, sampleCount, gain); break;
+		default: accumulateScalar(mixBuffer, voice, sampleCount, gain); break;
+		}
+	}
+
+	void clipToInt16(Sint16* output, const float* mixBuffer, Uint32 sampleCount)
+	{
+		switch (path)
+		{
+		case Path::AVX2: clipAVX2(output, mixBuffer, sampleCount); break;
+		case Path::SSE2: clipSSE2(output, mixBuffer, sampleCount); break;
+		default: clipScalar(output, mixBuffer, sampleCount); break;
+		}
+	}
+}
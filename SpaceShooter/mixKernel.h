@@ -0,0 +1,28 @@
+#pragma once
+#include <SDL.h>
+
+/// <summary>
+/// The inner loops of AudioMixer. Voices are summed into a float mix buffer, each with its own gain,
+/// and the sum is clipped to 16-bit once at the end, so the result doesn't depend on the order voices are mixed in.
+/// Samples are interleaved, the functions don't care about the channel count.
+///
+/// Every function has an AVX2, SSE2 and scalar version, the fastest one the CPU supports is used.
+/// </summary>
+namespace MixKernel
+{
+	enum class Path { Scalar, SSE2, AVX2 };
+
+	Path getPath();
+	// Returns false and keeps the current path if the CPU doesn't support <path>
+	bool setPath(Path path);
+	bool isSupported(Path path);
+	const char* getPathName(Path path);
+
+	// mixBuffer += voice * gain
+	void accumulate(float* mixBuffer, const Sint16* voice, Uint32 sampleCount, float gain);
+	// Same, for float voices that are in -1 to 1
+	void accumulate(float* mixBuffer, const float* voice, Uint32 sampleCount, float gain);
+
+	// Rounds the mix buffer to 16-bit samples, saturating at the ends of the range
+	void clipToInt16(Sint16* output, const float* mixBuffer, Uint32 sampleCount);
+}
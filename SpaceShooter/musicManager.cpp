@@ -1,64 +1,174 @@
 #include "musicManager.h"
-#include <windows.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include "assetLoader.h"
+#include "audioMixer.h"
 #include "assets.h"
+#include "engine.h"
 
-MusicManager::MusicManager(Beat inputBeats[3])
+MusicManager::MusicManager(Beat inputBeats[3], bool decodeLoops, int prefetchMilliseconds)
 {
-	//Initialize SDL_mixer
-	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 512) < 0)
-	{
-		printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
-	}
-	// load music
+	// load music, the audio device is opened in Engine::initializeEngine() (see AudioMixer)
+	// everything that was loaded in AssetLoader::loadAll() is just taken over
+	if (decodeLoops && loopPlayer.hook())
+		playback = MusicPlayback::DecodedLoops;
 	for (int i = 0; i < NUMBER_OF_BEATS; i++)
 	{
 		beats[i] = inputBeats[i];
-		beats[i].music = Mix_LoadMUS(inputBeats[i].path);
+		if (playback != MusicPlayback::DecodedLoops) continue;
+
+		beats[i].decodedMusic = AssetLoader::takeSound(inputBeats[i].path);
+		if (!loopPlayer.load(i, beats[i].decodedMusic))
+		{
+			// all loops have to be played the same way, so stream all of them
+			printf("Failed to decode music loop, streaming music instead! SDL_mixer Error: %s\n", Mix_GetError());
+			loopPlayer.unhook();
+			playback = MusicPlayback::SDLMixer;
+		}
+	}
+	if (playback == MusicPlayback::SDLMixer && streamer.hook(prefetchMilliseconds))
+	{
+		playback = MusicPlayback::Streamed;
+		for (int i = 0; i < NUMBER_OF_BEATS; i++)
+		{
+			if (!streamer.load(i, beats[i].path))
+			{
+				printf("Failed to stream music loop, playing it with SDL_mixer instead!\n");
+				streamer.unhook();
+				playback = MusicPlayback::SDLMixer;
+				break;
+			}
+		}
+	}
+	for (int i = 0; i < NUMBER_OF_BEATS && playback == MusicPlayback::SDLMixer; i++)
+	{
+		beats[i].music = AssetLoader::takeMusic(inputBeats[i].path);
 		if (beats[i].music == nullptr)
 		{
 			printf("Failed to load music! SDL_mixer Error: %s\n", Mix_GetError());
 		}
 	}
+	for (int i = 0; i < NUMBER_OF_BEATS; i++)
+	{
+		// the length of a loop played by SDL_mixer isn't known, so its grid is just repeated bar after bar
+		int frequency = AUDIO_FREQUENCY;
+		Sint64 loopFrames = 0;
+		if (playback == MusicPlayback::DecodedLoops)
+		{
+			frequency = loopPlayer.getFrequency();
+			loopFrames = loopPlayer.getFrameCount(i);
+		}
+		else if (playback == MusicPlayback::Streamed)
+		{
+			frequency = streamer.getFrequency();
+			loopFrames = streamer.getFrameCount(i);
+		}
+
+		// a grid from BeatAnalyzer (--analyze) is only valid for the audio it was made from
+		BeatGrid grid;
+		if (grid.load(BeatGrid::getPath(beats[i].path)))
+		{
+			if (grid.sampleRate == frequency && (loopFrames == 0 || grid.frames == loopFrames))
+			{
+				beats[i].BPM = static_cast<float>(grid.bpm);
+				beats[i].timeSignature = grid.timeSignature;
+				beats[i].timeline = BeatTimeline(grid);
+				continue;
+			}
+			std::cout << "Beat grid doesn't match the loop, using its BPM instead: " << beats[i].path << std::endl;
+		}
+		beats[i].timeline = BeatTimeline(beats[i].BPM, beats[i].timeSignature, frequency, loopFrames);
+	}
 	currentBeat = beats[0];
 	data = new MusicData();
 
-	transitionSound = Mix_LoadWAV(Assets::transitionSFX);
-	glitchSound = Mix_LoadWAV(Assets::glitchSFX);
+	transitionSound = AssetLoader::takeSound(Assets::transitionSFX);
+	glitchSound = AssetLoader::takeSound(Assets::glitchSFX);
 
 	//load laser SFXs
 	for (int i = 0; i < 4; i++)
 	{
-		std::string path = Assets::laserSFX + std::to_string(i + 1) + ".wav";
-		laserSounds[i] = Mix_LoadWAV(path.c_str());
+		laserSounds[i] = AssetLoader::takeSound(Assets::getLaserSFXPath(i).c_str());
 	}
-	badLaserSound = Mix_LoadWAV(Assets::badLaserSFX);
+	badLaserSound = AssetLoader::takeSound(Assets::badLaserSFX);
 
 	if (badLaserSound == nullptr || glitchSound == nullptr || transitionSound == nullptr )
 	{
 		printf("Failed to load sound! SDL_mixer Error: %s\n", Mix_GetError());
 	}
 
-	data->quarterNoteLength = 60.f / currentBeat.BPM;
-	data->halfNoteLength = data->quarterNoteLength * 2.f;
-	data->wholeNoteLength = data->quarterNoteLength * static_cast<float>(currentBeat.timeSignature);
+	setNoteLengths(currentBeat.timeline);
 
-	Mix_ReserveChannels(2);
+	// lasers can overlap a bit, the rest restart when they're played again.
+	// The transition sound masks a beat change, so it's never stolen by spammed lasers
+	transitionSoundId = voiceManager.addSound(transitionSound, 1, 3);
+	glitchSoundId = voiceManager.addSound(glitchSound, 1, 2);
+	laserSoundId = voiceManager.addSound(laserSounds[0], 4, 1);
+	badLaserSoundId = voiceManager.addSound(badLaserSound, 2, 1);
 }
 
 void MusicManager::startPlaying()
 {
-	Mix_FadeInMusic(currentBeat.music, -1, (int)(data->wholeNoteLength*2000));
-	loadTime = 0.2f;
+	playMusic(static_cast<int>(data->wholeNoteLength * 2000));
 	data->musicIsPlaying = true;
 }
+
+void MusicManager::playMusic(int fadeInMilliseconds)
+{
+	if (playback == MusicPlayback::DecodedLoops)
+	{
+		// starts exactly at the first sample, so there's no need to warm up
+		loopPlayer.play(currentBeatIndex, fadeInMilliseconds);
+		isLoading = false;
+		resetNoteTimers();
+		return;
+	}
+	if (playback == MusicPlayback::Streamed)
+	{
+		// loading until the decoder has caught up and the first samples are played, see update()
+		streamer.play(currentBeatIndex, fadeInMilliseconds);
+		isLoading = true;
+		return;
+	}
+	Mix_FadeInMusic(currentBeat.music, -1, fadeInMilliseconds);
+	loadTime = 0.2f;
+}
+
+void MusicManager::fadeOutMusic(int milliseconds) const
+{
+	if (playback == MusicPlayback::DecodedLoops)
+		loopPlayer.fadeOut(milliseconds);
+	else if (playback == MusicPlayback::Streamed)
+		streamer.fadeOut(milliseconds);
+	else
+		Mix_FadeOutMusic(milliseconds);
+}
+
+bool MusicManager::isMusicPlaying() const
+{
+	switch (playback)
+	{
+	case MusicPlayback::DecodedLoops: return loopPlayer.isPlaying();
+	case MusicPlayback::Streamed: return streamer.isPlaying();
+	default: return Mix_PlayingMusic();
+	}
+}
+
+void MusicManager::resetNoteTimers()
+{
+	// adjust for audio delay
+	songTime = -OUTPUT_LATENCY;
+	lastBeat = 0;
+	data->currentQuarterNote = 1;
+}
+
 void MusicManager::stopPlaying() const
 {
-	Mix_FadeOutMusic(2000);
-	Mix_PlayChannel(transitionChannel, transitionSound, 0);
-	Mix_Volume(transitionChannel, MIX_MAX_VOLUME);
+	fadeOutMusic(2000);
+	voiceManager.play(transitionSoundId, MIX_MAX_VOLUME);
 	isTransitioning = true;
 	data->musicIsPlaying = false;
 }
@@ -69,18 +179,14 @@ void MusicManager::changeBeat(int index)
 		currentBeatIndex = ++currentBeatIndex % 3; // toggle
 	else
 		currentBeatIndex = index;
-	Mix_FadeOutMusic(2000);
+	fadeOutMusic(2000);
 	isChangingBeat = true;
-	data->quarterNoteLength = 60.f / beats[currentBeatIndex].BPM;
-	data->halfNoteLength = data->quarterNoteLength * 2;
-	data->wholeNoteLength = data->quarterNoteLength * currentBeat.timeSignature;
+	setNoteLengths(beats[currentBeatIndex].timeline);
 
 	// play transition sfx to mask the transition
-	if (Mix_PlayingMusic() && !Mix_Playing(transitionChannel))
+	if (isMusicPlaying() && !voiceManager.isPlaying(transitionSoundId))
 	{
-		Mix_PlayChannel(transitionChannel, transitionSound, 0);
-
-		Mix_Volume(transitionChannel, transitionVolume);
+		voiceManager.play(transitionSoundId, transitionVolume);
 		isTransitioning = true;
 	}
 }
@@ -94,6 +200,16 @@ bool MusicManager::getBeatActiveState(float timeSinceLastBeat, float noteLength)
 
 bool MusicManager::update(float deltaTime)
 {
+	voiceManager.nextFrame();
+	if (isLoading && playback == MusicPlayback::Streamed)
+	{
+		if (streamer.hasStarted())
+		{
+			isLoading = false;
+			resetNoteTimers();
+		}
+		return false;
+	}
 	if (isLoading)
 	{
 		// Lets the music play muted for a time and then sets the position to the start.
@@ -103,18 +219,15 @@ bool MusicManager::update(float deltaTime)
 		if (currentTime * 0.001 > loadTime)
 		{
 			isLoading = false;
-			// adjust for audio delay - this is not precise but will do for now
-			data->timeSinceLastQuarterNote = -0.015f;
-			data->timeSinceLastWholeNote = -0.015f;
-			data->timeSinceLastHalfNote = -0.015f;
-			data->currentQuarterNote = 1;
+			resetNoteTimers();
 			Mix_SetMusicPosition(0);
 		}
 		return false;
 	}
 	if (isChangingBeat)
 	{
-		if (Mix_GetMusicVolume(currentBeat.music) == 0)
+		const bool fadedOut = playback == MusicPlayback::SDLMixer ? Mix_GetMusicVolume(currentBeat.music) == 0 : !isMusicPlaying();
+		if (fadedOut)
 		{
 			isTransitioning = false;
 			currentBeat = beats[currentBeatIndex];
@@ -123,40 +236,30 @@ bool MusicManager::update(float deltaTime)
 			startPlaying();
 		}
 	}
-	if (!Mix_PlayingMusic()) return false;
+	if (!isMusicPlaying()) return false;
 
-	// update timers
-	data->timeSinceLastWholeNote += deltaTime;
-	data->timeSinceLastHalfNote += deltaTime;
-	data->timeSinceLastQuarterNote += deltaTime;
+	const BeatTimeline::GridPosition position = getGridPosition(deltaTime);
+	data->currentQuarterNote = position.quarterNote;
+	data->timeSinceLastQuarterNote = position.timeSinceQuarterNote;
+	data->timeSinceLastHalfNote = position.timeSinceHalfNote;
+	data->timeSinceLastWholeNote = position.timeSinceWholeNote;
 
-	// quarter note has passed, which is true when all other note lengths passes
-	if (data->timeSinceLastQuarterNote >= data->quarterNoteLength)
+	// a quarter note has passed, the first beat doesn't count since the music just started
+	if (position.beat > lastBeat)
 	{
-		data->timeSinceLastQuarterNote = data->timeSinceLastQuarterNote - data->quarterNoteLength;
-		data->currentQuarterNote = (data->currentQuarterNote++ % currentBeat.timeSignature) + 1;
+		lastBeat = position.beat;
 		onQuarterNote();
-
-		if (data->currentQuarterNote == 1)
-		{
-			data->timeSinceLastWholeNote = data->timeSinceLastWholeNote - data->wholeNoteLength;
-			data->timeSinceLastHalfNote = data->timeSinceLastHalfNote - data->halfNoteLength;
-		}
-		else if (data->currentQuarterNote == 3)
-		{
-			data->timeSinceLastHalfNote = data->timeSinceLastHalfNote - data->halfNoteLength;
-		}
 	}
 
 	// update active state of each note length - decides when certain input actions are acceptable
-	data->wholeNoteActive = getBeatActiveState(data->timeSinceLastWholeNote, data->wholeNoteLength);
-	data->halfNoteActive = getBeatActiveState(data->timeSinceLastHalfNote, data->halfNoteLength);
-	data->quarterNoteActive = getBeatActiveState(data->timeSinceLastQuarterNote, data->quarterNoteLength);
+	data->wholeNoteActive = getBeatActiveState(position.timeSinceWholeNote, position.wholeNoteLength);
+	data->halfNoteActive = getBeatActiveState(position.timeSinceHalfNote, position.halfNoteLength);
+	data->quarterNoteActive = getBeatActiveState(position.timeSinceQuarterNote, position.quarterNoteLength);
 
-	// update the progress of each note length - from 0 (beat just happened) to 1 (note length just ended)
-	data->quarterNoteProgress = data->timeSinceLastQuarterNote / data->quarterNoteLength;
-	data->wholeNoteProgress = data->timeSinceLastWholeNote / data->wholeNoteLength;
-	data->halfNoteProgress = data->timeSinceLastHalfNote / data->halfNoteLength;
+	// the progress of each note length - from 0 (beat just happened) to 1 (note length just ended)
+	data->quarterNoteProgress = position.quarterNoteProgress;
+	data->wholeNoteProgress = position.wholeNoteProgress;
+	data->halfNoteProgress = position.halfNoteProgress;
 
 	if (data->halfNoteProgress < 0.5f)
 		data->pulseMultiplier = data->halfNoteProgress * 2.f;
@@ -166,52 +269,96 @@ bool MusicManager::update(float deltaTime)
 	return true;
 }
 
+BeatTimeline::GridPosition MusicManager::getGridPosition(float deltaTime)
+{
+	// the decoded and streamed loops count the frames they hand to the mixer, so the grid follows the audio to the sample
+	Sint64 playedFrames;
+	int frequency;
+	switch (playback)
+	{
+	case MusicPlayback::DecodedLoops:
+		playedFrames = loopPlayer.getPlayedFrames();
+		frequency = loopPlayer.getFrequency();
+		break;
+	case MusicPlayback::Streamed:
+		playedFrames = streamer.getPlayedFrames();
+		frequency = streamer.getFrequency();
+		break;
+	default:
+		// SDL_mixer's position isn't sample accurate, nothing is accumulated except the time itself
+		songTime += deltaTime;
+		return currentBeat.timeline.at((std::max)(songTime, 0.0));
+	}
+	const Sint64 latencyFrames = std::llround(OUTPUT_LATENCY * frequency);
+	return currentBeat.timeline.atFrame((std::max)(playedFrames - latencyFrames, Sint64{ 0 }));
+}
+
+void MusicManager::setNoteLengths(const BeatTimeline& timeline)
+{
+	const BeatTimeline::GridPosition start = timeline.atStart();
+	data->quarterNoteLength = start.quarterNoteLength;
+	data->halfNoteLength = start.halfNoteLength;
+	data->wholeNoteLength = start.wholeNoteLength;
+}
+
 void MusicManager::printStats() const
 {
-	const SHORT x = 80;
+	const int x = 80;
 	const char* trueString = "TRUE -       ";
 	const char* falseString = "     - FALSE";
 
-	static const HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)0});
+	Engine::setConsoleCursor(x, 0);
 	std::cout << "-------------------------------------- ";
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)1});
+	Engine::setConsoleCursor(x, 1);
 	std::cout << "|                 MUSIC";
 
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)2});
+	Engine::setConsoleCursor(x, 2);
 	std::cout << "| Current Quarter note: " << data->currentQuarterNote;
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)3});
+	Engine::setConsoleCursor(x, 3);
 	std::cout << "| Whole note synched:   " << (data->wholeNoteActive ? trueString : falseString);
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)4});
+	Engine::setConsoleCursor(x, 4);
 	std::cout << "| Half note synched:    " << (data->halfNoteActive ? trueString : falseString);
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)5});
+	Engine::setConsoleCursor(x, 5);
 	std::cout << "| Quarter note synched: " << (data->quarterNoteActive ? trueString : falseString);
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)6});
+	Engine::setConsoleCursor(x, 6);
 	std::cout << "| Time since whole note: " << data->timeSinceLastWholeNote << "\n";
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)7});
+	Engine::setConsoleCursor(x, 7);
 	std::cout << "| Time since half note : " << data->timeSinceLastHalfNote << "\n";
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)8});
+	Engine::setConsoleCursor(x, 8);
 	std::cout << "| Is transitioning:     " << (isTransitioning ? trueString : falseString) << "\n";
-	SetConsoleCursorPosition(hOut, COORD{x, (SHORT)9});
+	Engine::setConsoleCursor(x, 9);
 
 	std::cout << "-------------------------------------- ";
 
 	for (int i = 0; i < 8; i++)
 	{
-		SetConsoleCursorPosition(hOut, {(SHORT)(x + 37), (SHORT)(1 + i)});
+		Engine::setConsoleCursor(x + 37, 1 + i);
 		std::cout << "| ";
 	}
 
-	SetConsoleCursorPosition(hOut, COORD{(SHORT)0, (SHORT)10});
+	Engine::setConsoleCursor(0, 10);
 	std::cout.flush();
 }
 
+void MusicManager::printSoundStats() const
+{
+	voiceManager.printStats();
+	if (playback == MusicPlayback::Streamed)
+		streamer.printStats();
+}
+
 void MusicManager::unload() const
 {
+	// nothing may be playing when the sounds are freed
+	loopPlayer.unhook();
+	streamer.unhook();
+	AudioMixer::close();
 	for (size_t i = 0; i < std::size(beats); i++)
 	{
 		if (beats[i].music != nullptr)
 			Mix_FreeMusic(beats[i].music);
+		if (beats[i].decodedMusic != nullptr)
+			Mix_FreeChunk(beats[i].decodedMusic);
 	}
 	for (size_t i = 0; i < std::size(laserSounds); i++)
 	{
@@ -234,17 +381,32 @@ void MusicManager::playLaserSound(bool successfulLaser) const
 	
 	//int index = data->currentQuarterNote - 1; 
 
-	const int channel = Mix_PlayChannel(-1, successfulLaser ? laserSounds[0] : badLaserSound, 0);
-	Mix_Volume(channel, successfulLaser ? 50 : MIX_MAX_VOLUME);
+	voiceManager.play(successfulLaser ? laserSoundId : badLaserSoundId, successfulLaser ? 50 : MIX_MAX_VOLUME);
 }
 
 void  MusicManager::playGlitchSound() const
 {
-	Mix_PlayChannel(glitchChannel, glitchSound, 0);
 	const int volume = rand() % 28 + 70;
-	Mix_Volume(glitchChannel, volume);
+	voiceManager.play(glitchSoundId, volume);
+}
+
+void MusicManager::play(std::vector<AudioEvent>& events) const
+{
+	for (const AudioEvent event : events)
+	{
+		switch (event)
+		{
+		case AudioEvent::GlitchSound:
+			playGlitchSound();
+			break;
+		case AudioEvent::StopPlaying:
+			stopPlaying();
+			break;
+		}
+	}
+	events.clear();
 }
 
-Beat::Beat(int bpm, int signature, const char* path) : BPM(bpm), timeSignature(signature), path(path)
+Beat::Beat(float bpm, int signature, const char* path) : BPM(bpm), timeSignature(signature), path(path)
 {
 }
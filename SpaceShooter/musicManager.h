@@ -1,16 +1,28 @@
 #pragma once
+#include <vector>
 #include <SDL_mixer.h>
+#include "beatTimeline.h"
 #include "delegate.h"
+#include "loopPlayer.h"
+#include "musicStreamer.h"
+#include "voiceManager.h"
 #define NUMBER_OF_BEATS 3
 
+// the format the mixer is opened with, in AudioMixer::open()
+#define AUDIO_FREQUENCY 44100
+#define AUDIO_FORMAT MIX_DEFAULT_FORMAT
+#define AUDIO_CHANNELS 2
+
 struct Beat
 {
-	int BPM = 114;
+	float BPM = 114; // replaced by the analyzed tempo when the loop has a .beats file
 	int timeSignature = 4; // beats per bar
 	const char* path = "";
-	Mix_Music* music = nullptr;
+	Mix_Music* music = nullptr; // played by SDL_mixer, if the loop can't be decoded or streamed
+	Mix_Chunk* decodedMusic = nullptr; // played by LoopPlayer
+	BeatTimeline timeline; // built by MusicManager once the length of the loop is known
 
-	Beat(int bpm=120, int signature=4, const char* path ="");
+	Beat(float bpm=120, int signature=4, const char* path ="");
 };
 
 // contains data used for rhythm game features
@@ -42,6 +54,9 @@ struct MusicData
 	float pulseMultiplier{};
 };
 
+// Sounds the simulation asks for, it can run on another thread than the audio (see FramePipeline), so they're played later by MusicManager::play()
+enum class AudioEvent : Uint8 { GlitchSound, StopPlaying };
+
 // handles all audio / music 
 struct MusicManager
 {
@@ -61,13 +76,31 @@ private:
 	float loadTime = 0.2f;
 	bool isLoading = true;
 	bool isChangingBeat = false;
-	int glitchChannel = 0;
-	int transitionChannel = 1;
+	// the played audio frames are handed to the device this long before they're heard - not precise but will do for now
+	static constexpr double OUTPUT_LATENCY = 0.015;
+	// seconds since the current beat started, added up frame by frame when SDL_mixer plays it
+	double songTime = 0;
+	Sint64 lastBeat = 0;
+
+	// decoded loops are played through LoopPlayer, streamed ones through MusicStreamer,
+	// and if neither works they're played with Mix_FadeInMusic
+	enum class MusicPlayback { DecodedLoops, Streamed, SDLMixer };
+	MusicPlayback playback = MusicPlayback::SDLMixer;
+	mutable LoopPlayer loopPlayer;
+	mutable MusicStreamer streamer;
+
+	// every sound effect is played through this, it limits how many voices each of them can take
+	mutable VoiceManager voiceManager;
+	VoiceManager::SoundId transitionSoundId = VoiceManager::INVALID_SOUND;
+	VoiceManager::SoundId laserSoundId = VoiceManager::INVALID_SOUND;
+	VoiceManager::SoundId badLaserSoundId = VoiceManager::INVALID_SOUND;
+	VoiceManager::SoundId glitchSoundId = VoiceManager::INVALID_SOUND;
 
 public:
 	Delegate<std::function<void()>> onQuarterNote;
 
-	MusicManager(Beat inputBeats[NUMBER_OF_BEATS]);
+	// Without <decodeLoops> the loops are streamed, with <prefetchMilliseconds> read ahead
+	MusicManager(Beat inputBeats[NUMBER_OF_BEATS], bool decodeLoops = true, int prefetchMilliseconds = 500);
 	bool update(float deltaTime);
 	void startPlaying();
 	void stopPlaying() const;
@@ -76,7 +109,20 @@ public:
 
 	void playLaserSound(bool successfulLaser) const;
 	void playGlitchSound() const;
+	// Plays the sounds the simulation queued, in order, and clears them. Call it on the main thread
+	void play(std::vector<AudioEvent>& events) const;
 
 	void printStats() const;
+	void printSoundStats() const;
 	void unload() const;
+
+private:
+	void playMusic(int fadeInMilliseconds);
+	void fadeOutMusic(int milliseconds) const;
+	bool isMusicPlaying() const;
+	void resetNoteTimers();
+	// Where the music is on the current beat's grid, <deltaTime> is only used when SDL_mixer plays it
+	BeatTimeline::GridPosition getGridPosition(float deltaTime);
+	// The note lengths of the first bar of <timeline>
+	void setNoteLengths(const BeatTimeline& timeline);
 };
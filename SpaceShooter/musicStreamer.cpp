@@ -0,0 +1,321 @@
+#include "musicStreamer.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "audioMixer.h"
+#include "wavReader.h"
+
+// Runs on the audio thread. The stream is silent when this is called, and sound effects are mixed on top afterwards
+void SDLCALL MusicStreamer::mix(void* userData, Uint8* stream, int length)
+{
+	MusicStreamer& streamer = *static_cast<MusicStreamer*>(userData);
+	Sint16* output = reinterpret_cast<Sint16*>(stream);
+	const int frameCount = length / static_cast<int>(sizeof(Sint16) * streamer.channels);
+
+	SDL_AtomicLock(&streamer.lock);
+	// silent until the decoder has started on the track that was asked for
+	if (streamer.currentTrack < 0 || streamer.decodedRequest.load(std::memory_order_acquire) != streamer.playingRequest)
+	{
+		SDL_AtomicUnlock(&streamer.lock);
+		return;
+	}
+	if (!streamer.skippedToTrack)
+	{
+		streamer.readFrame.store(streamer.trackStartFrame.load(std::memory_order_relaxed), std::memory_order_release);
+		streamer.skippedToTrack = true;
+	}
+
+	const Uint64 read = streamer.readFrame.load(std::memory_order_relaxed);
+	const Uint64 available = streamer.writeFrame.load(std::memory_order_acquire) - read;
+	const int frames = static_cast<int>((std::min)(available, static_cast<Uint64>(frameCount)));
+	if (streamer.started)
+	{
+		streamer.lowestFill = (std::min)(streamer.lowestFill, available);
+		if (frames < frameCount)
+		{
+			streamer.underruns++;
+			streamer.underrunFrames += frameCount - frames;
+		}
+	}
+
+	const float volume = static_cast<float>(streamer.volume) / MIX_MAX_VOLUME;
+	const Uint64 mask = streamer.ringFrames - 1;
+	int frame = 0;
+	for (; frame < frames; frame++)
+	{
+		if (streamer.gain != streamer.targetGain)
+		{
+			streamer.gain += streamer.gainStep;
+			if ((streamer.gainStep > 0 && streamer.gain >= streamer.targetGain) || (streamer.gainStep < 0 && streamer.gain <= streamer.targetGain))
+				streamer.gain = streamer.targetGain;
+		}
+		if (streamer.stopAtTarget && streamer.gain == streamer.targetGain)
+		{
+			streamer.currentTrack = -1;
+			break;
+		}
+
+		const float frameGain = streamer.gain * volume;
+		const Sint16* samples = streamer.ring.data() + ((read + frame) & mask) * streamer.channels;
+		for (int channel = 0; channel < streamer.channels; channel++)
+		{
+			output[frame * streamer.channels + channel] = static_cast<Sint16>(samples[channel] * frameGain);
+		}
+	}
+	streamer.readFrame.store(read + frame, std::memory_order_release);
+	streamer.playedFrames += frame;
+	streamer.started |= frame > 0;
+	SDL_AtomicUnlock(&streamer.lock);
+}
+
+// Runs on the decoder thread, keeps the ring full of the last requested track
+void MusicStreamer::decode()
+{
+	WavReader reader;
+	SDL_AudioStream* converter = nullptr;
+	std::vector<float> samples;
+	std::vector<Sint16> converted(static_cast<size_t>(chunkFrames) * channels);
+	const int frameBytes = static_cast<int>(sizeof(Sint16)) * channels;
+	const auto sleepTime = std::chrono::milliseconds((std::max)(1, chunkFrames * 250 / frequency));
+	Uint32 handledRequest = 0;
+
+	while (decoderRunning.load(std::memory_order_relaxed))
+	{
+		const Uint32 latestRequest = request.load(std::memory_order_acquire);
+		if (latestRequest != handledRequest)
+		{
+			handledRequest = latestRequest;
+			reader.close();
+			if (converter != nullptr)
+			{
+				SDL_FreeAudioStream(converter);
+				converter = nullptr;
+			}
+
+			// the file's format is converted to the mixer's, so any sample rate or channel count can be streamed
+			const int index = requestedTrack.load(std::memory_order_relaxed);
+			if (index >= 0 && reader.open(tracks[index].path))
+			{
+				converter = SDL_NewAudioStream(AUDIO_F32SYS, static_cast<Uint8>(reader.getChannels()), reader.getSampleRate(),
+					AUDIO_S16SYS, static_cast<Uint8>(channels), frequency);
+				if (converter == nullptr)
+					printf("Failed to convert streamed music! SDL Error: %s\n", SDL_GetError());
+				samples.resize(static_cast<size_t>(chunkFrames) * reader.getChannels());
+				decoderBytes.store(samples.size() * sizeof(float) * 2 + converted.size() * sizeof(Sint16), std::memory_order_relaxed);
+			}
+			trackStartFrame.store(writeFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			decodedRequest.store(handledRequest, std::memory_order_release);
+		}
+
+		const Uint64 write = writeFrame.load(std::memory_order_relaxed);
+		const Uint64 freeFrames = ringFrames - (write - readFrame.load(std::memory_order_acquire));
+		if (converter == nullptr || freeFrames < static_cast<Uint64>(chunkFrames))
+		{
+			std::this_thread::sleep_for(sleepTime);
+			continue;
+		}
+
+		const int frames = SDL_AudioStreamGet(converter, converted.data(), chunkFrames * frameBytes) / frameBytes;
+		if (frames <= 0)
+		{
+			// the converter is empty, feed it the next chunk of the file, looping back to the start at the end
+			int read = reader.read(samples.data(), chunkFrames);
+			if (read == 0 && reader.rewind())
+				read = reader.read(samples.data(), chunkFrames);
+			if (read == 0 || SDL_AudioStreamPut(converter, samples.data(), read * reader.getChannels() * static_cast<int>(sizeof(float))) != 0)
+			{
+				printf("Failed to stream music, it's stopped! SDL Error: %s\n", SDL_GetError());
+				SDL_FreeAudioStream(converter);
+				converter = nullptr;
+
+				// the track is over, unless another one was asked for meanwhile. What's left of it in the ring is dropped
+				SDL_AtomicLock(&lock);
+				if (playingRequest == handledRequest)
+				{
+					currentTrack = -1;
+					readFrame.store(write, std::memory_order_release);
+				}
+				SDL_AtomicUnlock(&lock);
+			}
+			continue;
+		}
+
+		const Uint64 mask = ringFrames - 1;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			Sint16* destination = ring.data() + ((write + frame) & mask) * channels;
+			std::copy_n(converted.data() + frame * channels, channels, destination);
+		}
+		writeFrame.store(write + frames, std::memory_order_release);
+		chunksDecoded.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (converter != nullptr)
+		SDL_FreeAudioStream(converter);
+}
+
+MusicStreamer::~MusicStreamer()
+{
+	unhook();
+}
+
+bool MusicStreamer::hook(int prefetchMilliseconds)
+{
+	Uint16 format;
+	if (decoderRunning || Mix_QuerySpec(&frequency, &format, &channels) == 0 || format != AUDIO_S16SYS)
+		return false;
+
+	// the ring is a power of two, so positions wrap with a mask, and holds at least four chunks
+	const Sint64 prefetchFrames = static_cast<Sint64>(std::clamp(prefetchMilliseconds, MIN_PREFETCH_MILLISECONDS, MAX_PREFETCH_MILLISECONDS)) * frequency / 1000;
+	ringFrames = 1;
+	while (ringFrames < static_cast<Uint64>(prefetchFrames)) ringFrames *= 2;
+	chunkFrames = static_cast<int>((std::min)(static_cast<Uint64>(CHUNK_FRAMES), ringFrames / 4));
+	ring.assign(ringFrames * channels, 0);
+	writeFrame = 0;
+	readFrame = 0;
+	lowestFill = ringFrames;
+
+	decoderRunning = true;
+	decoder = std::thread(&MusicStreamer::decode, this);
+	AudioMixer::hookMusic(mix, this);
+	return true;
+}
+
+void MusicStreamer::unhook()
+{
+	if (!decoderRunning) return;
+
+	AudioMixer::hookMusic(nullptr, nullptr);
+	decoderRunning = false;
+	decoder.join();
+	currentTrack = -1;
+}
+
+bool MusicStreamer::load(int index, const char* path)
+{
+	if (index < 0 || index >= MAX_TRACKS) return false;
+
+	WavReader reader;
+	if (!reader.open(path)) return false;
+	tracks[index] = Track{ path, reader.getFrameCount(), reader.getSampleRate() };
+	return true;
+}
+
+// Starts the track from its first sample, fading in from silence once the decoder has caught up
+void MusicStreamer::play(int index, int fadeInMilliseconds)
+{
+	if (index < 0 || index >= MAX_TRACKS || tracks[index].path.empty()) return;
+
+	const float fadeFrames = static_cast<float>(fadeInMilliseconds) * 0.001f * frequency;
+	requestedTrack.store(index, std::memory_order_relaxed);
+	const Uint32 newRequest = request.fetch_add(1, std::memory_order_release) + 1;
+
+	SDL_AtomicLock(&lock);
+	currentTrack = index;
+	playingRequest = newRequest;
+	skippedToTrack = false;
+	started = false;
+	playedFrames = 0;
+	gain = fadeFrames > 0 ? 0.f : 1.f;
+	targetGain = 1.f;
+	gainStep = fadeFrames > 0 ? 1.f / fadeFrames : 0.f;
+	stopAtTarget = false;
+	SDL_AtomicUnlock(&lock);
+}
+
+// Fades out from the current gain, and stops when it reaches silence
+void MusicStreamer::fadeOut(int milliseconds)
+{
+	const float fadeFrames = static_cast<float>(milliseconds) * 0.001f * frequency;
+
+	SDL_AtomicLock(&lock);
+	targetGain = 0.f;
+	gainStep = fadeFrames > 0 ? -gain / fadeFrames : -gain;
+	stopAtTarget = true;
+	SDL_AtomicUnlock(&lock);
+}
+
+void MusicStreamer::stop()
+{
+	SDL_AtomicLock(&lock);
+	currentTrack = -1;
+	SDL_AtomicUnlock(&lock);
+}
+
+void MusicStreamer::setVolume(int newVolume)
+{
+	SDL_AtomicLock(&lock);
+	volume = newVolume;
+	SDL_AtomicUnlock(&lock);
+}
+
+bool MusicStreamer::isPlaying()
+{
+	SDL_AtomicLock(&lock);
+	const bool playing = currentTrack >= 0;
+	SDL_AtomicUnlock(&lock);
+	return playing;
+}
+
+bool MusicStreamer::hasStarted()
+{
+	SDL_AtomicLock(&lock);
+	const bool hasStarted = started;
+	SDL_AtomicUnlock(&lock);
+	return hasStarted;
+}
+
+double MusicStreamer::getPosition()
+{
+	SDL_AtomicLock(&lock);
+	const Uint64 frames = playedFrames;
+	SDL_AtomicUnlock(&lock);
+	return static_cast<double>(frames) / frequency;
+}
+
+Sint64 MusicStreamer::getPlayedFrames()
+{
+	SDL_AtomicLock(&lock);
+	const Uint64 frames = playedFrames;
+	SDL_AtomicUnlock(&lock);
+	return static_cast<Sint64>(frames);
+}
+
+// Rounded when the file's sample rate isn't the mixer's, so a grid built from it can drift by a frame per loop
+Sint64 MusicStreamer::getFrameCount(int index) const
+{
+	if (index < 0 || index >= MAX_TRACKS || tracks[index].sampleRate == 0) return 0;
+	const Track& track = tracks[index];
+	return track.sampleRate == frequency ? track.frameCount : track.frameCount * frequency / track.sampleRate;
+}
+
+int MusicStreamer::getFrequency() const
+{
+	return frequency;
+}
+
+MusicStreamer::Stats MusicStreamer::getStats()
+{
+	Stats stats{};
+	SDL_AtomicLock(&lock);
+	stats.underruns = underruns;
+	stats.underrunFrames = underrunFrames;
+	stats.lowestFillMilliseconds = 1000.0 * lowestFill / frequency;
+	SDL_AtomicUnlock(&lock);
+
+	stats.prefetchMilliseconds = 1000.0 * ringFrames / frequency;
+	stats.chunksDecoded = chunksDecoded.load(std::memory_order_relaxed);
+	stats.bufferBytes = ring.size() * sizeof(Sint16) + decoderBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void MusicStreamer::printStats()
+{
+	const Stats stats = getStats();
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Music streaming: " << stats.prefetchMilliseconds << " ms prefetched, " << stats.bufferBytes / 1024 << " KB of buffers, "
+		<< stats.chunksDecoded << " chunks decoded\n";
+	std::cout << "  underruns: " << stats.underruns << " (" << 1000.0 * stats.underrunFrames / frequency << " ms of silence), lowest fill "
+		<< stats.lowestFillMilliseconds << " ms" << std::endl;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+/// <summary>
+/// Streams music tracks from WAV files, so memory stays the same however long they are.
+///
+/// A decoder thread reads a track a chunk at a time (see WavReader), converts it to the mixer's format
+/// and writes it into a ring that holds <prefetchMilliseconds> of audio. The audio callback reads from
+/// the ring without locking it (one writer, one reader), and plays silence when the decoder couldn't
+/// keep up, which is counted as an underrun. Tracks loop, the decoder goes back to the start by itself.
+///
+/// The control state (the track, fades and volume) works like in LoopPlayer.
+/// Only 16-bit output is supported, hook() fails for other formats.
+/// </summary>
+struct MusicStreamer
+{
+	static constexpr int MIN_PREFETCH_MILLISECONDS = 20;
+	static constexpr int MAX_PREFETCH_MILLISECONDS = 5000;
+
+	struct Stats
+	{
+		Uint64 underruns; // callbacks that didn't get all their frames
+		Uint64 underrunFrames; // frames of silence played because of them
+		double prefetchMilliseconds; // the size of the ring
+		double lowestFillMilliseconds; // the least that was left in the ring while playing
+		Uint64 chunksDecoded;
+		size_t bufferBytes; // everything that's allocated for streaming, however long the tracks are
+	};
+
+private:
+	static constexpr int MAX_TRACKS = 8;
+	static constexpr int CHUNK_FRAMES = 4096; // decoded at a time, at most
+
+	struct Track { std::string path; Sint64 frameCount; int sampleRate; };
+	Track tracks[MAX_TRACKS] = {};
+	int channels = 2;
+	int frequency = 44100;
+
+	// the ring, written by the decoder thread and read by the audio thread
+	std::vector<Sint16> ring;
+	Uint64 ringFrames = 0; // a power of two
+	int chunkFrames = CHUNK_FRAMES;
+	std::atomic<Uint64> writeFrame{ 0 }; // only written by the decoder
+	std::atomic<Uint64> readFrame{ 0 }; // written by the audio thread, and by the decoder under lock when a track fails
+	std::atomic<Uint64> trackStartFrame{ 0 }; // where the data of the last requested track starts
+	std::atomic<Uint32> decodedRequest{ 0 }; // the last request the decoder started on
+
+	std::thread decoder;
+	std::atomic<bool> decoderRunning{ false };
+	std::atomic<int> requestedTrack{ -1 };
+	std::atomic<Uint32> request{ 0 }; // increased for every play()
+	std::atomic<Uint64> chunksDecoded{ 0 };
+	std::atomic<size_t> decoderBytes{ 0 };
+
+	// everything below is shared with the audio thread, guarded by lock
+	SDL_SpinLock lock = 0;
+	int currentTrack = -1;
+	Uint32 playingRequest = 0; // the request the audio thread is playing
+	bool skippedToTrack = false; // the data of earlier tracks has been skipped
+	bool started = false; // the first frames of the track have been played
+	Uint64 playedFrames = 0;
+	float gain = 0;
+	float gainStep = 0; // per frame
+	float targetGain = 0;
+	bool stopAtTarget = false;
+	int volume = MIX_MAX_VOLUME;
+	Uint64 underruns = 0;
+	Uint64 underrunFrames = 0;
+	Uint64 lowestFill = 0;
+
+	static void SDLCALL mix(void* userData, Uint8* stream, int length);
+	void decode();
+
+public:
+	MusicStreamer() = default;
+	MusicStreamer(const MusicStreamer&) = delete;
+	MusicStreamer& operator=(const MusicStreamer&) = delete;
+	~MusicStreamer();
+
+	// Starts the decoder thread and feeds the mixer, call after the audio device is opened
+	bool hook(int prefetchMilliseconds);
+	void unhook();
+
+	// Only reads the header, the file is opened again by the decoder when it's played
+	bool load(int index, const char* path);
+	void play(int index, int fadeInMilliseconds = 0);
+	void fadeOut(int milliseconds);
+	void stop();
+	void setVolume(int newVolume);
+
+	bool isPlaying();
+	// False until the first frames of the track have reached the mixer
+	bool hasStarted();
+	double getPosition(); // in seconds, since the track started
+	// The same in sample frames at the mixer's frequency, for the beat grid
+	Sint64 getPlayedFrames();
+	// The length of a track at the mixer's frequency
+	Sint64 getFrameCount(int index) const;
+	int getFrequency() const;
+
+	Stats getStats();
+	void printStats();
+};
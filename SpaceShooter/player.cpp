@@ -8,28 +8,28 @@
 #define MAXVELOCITY 400.f
 #define FRICTION 2.f
 
-using namespace Engine;
 
-Player::Player(MusicManager* musicManager, SDL_Renderer* renderer) : remainingHealth(maxHealth), musicManager(musicManager)
+Player::Player(World* world, MusicManager* musicManager, SDL_Renderer* renderer) : remainingHealth(maxHealth), musicManager(musicManager), world(world)
 {
 	const Position pos(Position( WIDTH / 2 - playerRadius / 2, HEIGHT * 0.8f, playerRadius));
-	Engine::createObject(pos, Rotation(10, 0), Velocity(), 20, Assets::playerTexturePath, Tag::Player);
+	world->createObject(pos, Rotation(10, 0), Velocity(), 20, Assets::playerTexturePath, Tag::Player);
 
 	overlay = Sprite(200, 200);
 	overlay.load(Assets::sphericalLightPath, renderer);
 	SDL_SetTextureBlendMode(overlay.texture, SDL_BLENDMODE_ADD);
 }
 
-void Player::update(float deltaTime, float pulseMultiplier)
+// The overlay is drawn around <drawnPlayerPos>, where the player is in the frame that's being drawn
+void Player::update(float deltaTime, float pulseMultiplier, Position drawnPlayerPos)
 {
 	Vector2 inputDirection;
-	if (Engine::getKeyDown(InputKey::moveLeft))
+	if (world->getKeyDown(InputKey::moveLeft))
 		inputDirection.x -= 1;
-	if (Engine::getKeyDown(InputKey::moveRight))
+	if (world->getKeyDown(InputKey::moveRight))
 		inputDirection.x += 1;
-	if (Engine::getKeyDown(InputKey::moveUp))
+	if (world->getKeyDown(InputKey::moveUp))
 		inputDirection.y -= 1;
-	if (Engine::getKeyDown(InputKey::moveDown))
+	if (world->getKeyDown(InputKey::moveDown))
 		inputDirection.y += 1;
 
 	inputDirection.normalize();
@@ -39,7 +39,7 @@ void Player::update(float deltaTime, float pulseMultiplier)
 
 	const Vector2 friction = velocity * deltaTime * FRICTION;
 	velocity -= friction;
-	Engine::updatePlayerVelocity(velocity.x, velocity.y);
+	world->updatePlayerVelocity(velocity.x, velocity.y);
 
 	constexpr float fadeOutTime = 2.f;
 
@@ -54,11 +54,11 @@ void Player::update(float deltaTime, float pulseMultiplier)
 			// tint player texture red for a duration after failed shot
 			const int c = std::lerp(0, 255, Ease::Out(std::clamp(timeSinceLastFail / fadeOutTime, 0.f, 1.f), 2));
 			const Color tint(255, c, c, 255);
-			Engine::updatePlayerTextureMod(tint);
+			world->updatePlayerTextureMod(tint);
 
 			const float progress = timeSinceLastFail / fadeOutTime;
 			const int size = 150;
-			const Position playerPos = Engine::getPlayerPos();
+			const Position playerPos = drawnPlayerPos;
 			overlay.updateOpacity(1 - Ease::Out(progress, 3));
 			overlay.draw(playerPos.x - size / 2, playerPos.y - size / 2, size, size);
 		}
@@ -66,12 +66,12 @@ void Player::update(float deltaTime, float pulseMultiplier)
 		{
 			const float progress = timeSinceLastSuccess / fadeOutTime;
 			const int size = static_cast<int>(std::lerp(150, 100, Ease::Out(progress, 2)));
-			const Position playerPos = Engine::getPlayerPos();
-			const float opacityMultiplier = max(1 - Ease::Out(progress, 5), Ease::InOutSine(pulseMultiplier) * 0.2f + 0.3f);
+			const Position playerPos = drawnPlayerPos;
+			const float opacityMultiplier = (std::max)(1 - Ease::Out(progress, 5), Ease::InOutSine(pulseMultiplier) * 0.2f + 0.3f);
 			overlay.updateOpacity(opacityMultiplier);
 			overlay.draw(playerPos.x - size / 2, playerPos.y - size / 2, size, size);
 
-			Engine::updatePlayerTextureMod(Color(255 * Ease::Out(progress + 0.1f, 5), 255.f, 255.f, 255.f));
+			world->updatePlayerTextureMod(Color(255 * Ease::Out(progress + 0.1f, 5), 255.f, 255.f, 255.f));
 		}
 		if (timeSinceLastSuccess > fadeOutTime && timeSinceLastFail > fadeOutTime)
 		{
@@ -82,18 +82,18 @@ void Player::update(float deltaTime, float pulseMultiplier)
 	else
 	{
 		const int size = 100;
-		const Position playerPos = Engine::getPlayerPos();
+		const Position playerPos = drawnPlayerPos;
 		overlay.updateOpacity(Ease::InOutSine(pulseMultiplier) * 0.2f + 0.3f);
 		overlay.draw(playerPos.x - size / 2, playerPos.y - size / 2, size, size);
 	}
-		//Engine::updatePlayerTextureMod(Color(255, 255, 255, 255).multiplied(1 - (Ease::InOutSine(1 - pulseMultiplier) * 0.2f)));
+		//world->updatePlayerTextureMod(Color(255, 255, 255, 255).multiplied(1 - (Ease::InOutSine(1 - pulseMultiplier) * 0.2f)));
 
 }
 
 void Player::shootLaser(int mouseX, int mouseY, MusicData* musicData, bool& wasShotSuccessful)
 {
 	const Vector2 mousePosition{ static_cast<float>(mouseX), static_cast<float>(mouseY) };
-	Position playerPos = Engine::getPlayerPos();
+	Position playerPos = world->getPlayerPos();
 	Vector2 centerPos = Vector2(playerPos.x, playerPos.y);
 	Vector2 direction = mousePosition - centerPos;
 	direction.normalize();
@@ -101,7 +101,7 @@ void Player::shootLaser(int mouseX, int mouseY, MusicData* musicData, bool& wasS
 	playerPos = Position{ centerPos.x, centerPos.y };
 
 	const Laser newLaser{ {LASER_DEFAULT_LIFETIME}, playerPos.x, playerPos.y, mousePosition.x, mousePosition.y };
-	wasShotSuccessful = Engine::addLaser(newLaser, musicData);
+	wasShotSuccessful = world->addLaser(newLaser, musicData);
 
 	if (!wasShotSuccessful)
 	{
@@ -126,19 +126,20 @@ void Player::reset()
 
 void Player::takeDamage(int damage)
 {
-	musicManager->playGlitchSound();
+	audioEvents.push_back(AudioEvent::GlitchSound);
 	if (remainingHealth > 0)
 		remainingHealth -= damage;
 
 	if(remainingHealth <= 0)
 	{
-		musicManager->stopPlaying();
-		Engine::clearObjects();
-		musicManager->playGlitchSound();
+		audioEvents.push_back(AudioEvent::StopPlaying);
+		world->clearObjects();
+		audioEvents.push_back(AudioEvent::GlitchSound);
 	}
 }
 
 void Player::destroy()
 {
 	overlay.destroy();
+	AssetCache::releaseTexture(world->objects.get<Appearance>(world->playerIndex).texture);
 }
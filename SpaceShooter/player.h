@@ -1,5 +1,6 @@
 #pragma once
 #include "engine.h"
+#include "game.h"
 #include "vector2.h"
 #include "musicManager.h"
 #include "sprite.h"
@@ -17,7 +18,7 @@
 using namespace Vector2D;
 /// <summary>
 /// This only handles player velocity, health and lasers
-/// The movement, rendering & collision is handled by engine.cpp
+/// The movement & collision is handled by World, rendering by engine.cpp
 /// </summary>
 struct Player
 {
@@ -28,10 +29,13 @@ struct Player
 	float timeSinceLastFail = 2.f;
 	float timeSinceLastSuccess = 2.f;
 	MusicManager* musicManager;
+	World* world;
 	Sprite overlay;
+	// the sounds of takeDamage(), it runs in the simulation step, so they're handed to the main thread with the frame
+	std::vector<AudioEvent> audioEvents;
 
-	Player(MusicManager* musicManager, SDL_Renderer* renderer);
-	void update(float deltaTime, float pulseMultiplier);
+	Player(World* world, MusicManager* musicManager, SDL_Renderer* renderer);
+	void update(float deltaTime, float pulseMultiplier, Position drawnPlayerPos);
 	void shootLaser(int mouseX, int mouseY, MusicData* musicData, bool& wasShotSuccessful);
 	void reset();
 	void takeDamage(int damage);
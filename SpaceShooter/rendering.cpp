@@ -1,17 +1,69 @@
 #include "rendering.h"
 #include <algorithm>
-#include <Windows.h>
+#include <iomanip>
+#include <iostream>
+#include "beatCircleBatch.h"
+#include "culling.h"
+#include "detailController.h"
 #include "easingFunctions.h"
 #include "SDL.h"
 #include "engine.h"
+#include "glowBatch.h"
+#include "laserBatch.h"
 #include "player.h"
+#include "softwareRasterizer.h"
+#include "starBatch.h"
 #include "vector2.h"
 
 using namespace Vector2D;
 
 namespace Rendering
 {
+	// objects that don't reach into it aren't drawn
+	constexpr SDL_FRect SCREEN{ 0, 0, WIDTH, HEIGHT };
+
 	SDL_Renderer* render;
+	// drawn into instead of render when it's set
+	SoftwareRasterizer* rasterizer = nullptr;
+	SDL_Color drawColor{ 255, 255, 255, 255 }; // the rasterizer's, the SDL renderer keeps its own
+
+	// the sizes and alphas of the stars for this frame, see updateStars()
+	StarBatch starBatch;
+	// the outlines the stars are drawn with, without it they're drawn as filled triangles
+	StarAtlas starAtlas;
+	// the beam texture and the strips of the lasers, without it they're drawn line by line
+	LaserBatch laserBatch;
+	// the glows of the objects that are fading out, without it they're drawn ring by ring
+	GlowBatch glowBatch;
+	// the hexagons around the objects that show the beat, sorted by note
+	BeatCircleBatch beatCircleBatch;
+	// how much of the beat circles, the glows and the lasers is drawn
+	DetailController detailController;
+
+	struct LayerTime
+	{
+		double totalMilliseconds = 0;
+		double maxMilliseconds = 0;
+		Uint64 frames = 0;
+		Culling::Counts objects; // of the layers that cull them
+	};
+	LayerTime layerTimes[static_cast<int>(Layer::Count)];
+
+	void countCulling(Layer layer, size_t visible, size_t culled)
+	{
+		Culling::Counts& counts = layerTimes[static_cast<int>(layer)].objects;
+		counts.visible += visible;
+		counts.culled += culled;
+	}
+
+	void updateDetail(float frameMilliseconds, size_t objectCount)
+	{
+		detailController.update(frameMilliseconds, objectCount);
+	}
+	Detail getDetail()
+	{
+		return detailController.getDetail();
+	}
 
 	void setRenderer(SDL_Renderer* renderer)
 	{
@@ -21,15 +73,80 @@ namespace Rendering
 	{
 		return render;
 	}
+	void setRasterizer(SoftwareRasterizer* softwareRasterizer)
+	{
+		rasterizer = softwareRasterizer;
+		if (rasterizer == nullptr) return;
+		// the batches are drawn from their pixels, there's nothing to upload them to
+		if (!starAtlas.isRasterized())
+			starAtlas.rasterize();
+		if (!laserBatch.isRasterized())
+			laserBatch.rasterize();
+		if (!glowBatch.isRasterized())
+			glowBatch.rasterize();
+	}
+
+	// The draw functions go through these, so they draw into the rasterizer when there is one
+	void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+	{
+		if (rasterizer != nullptr)
+			drawColor = { r, g, b, a };
+		else
+			SDL_SetRenderDrawColor(render, r, g, b, a);
+	}
+	void getDrawColor(Uint8* r, Uint8* g, Uint8* b, Uint8* a)
+	{
+		if (rasterizer == nullptr)
+		{
+			SDL_GetRenderDrawColor(render, r, g, b, a);
+			return;
+		}
+		*r = drawColor.r;
+		*g = drawColor.g;
+		*b = drawColor.b;
+		*a = drawColor.a;
+	}
+	void drawLine(float x1, float y1, float x2, float y2)
+	{
+		if (rasterizer != nullptr)
+			rasterizer->drawLine(x1, y1, x2, y2, drawColor);
+		else
+			SDL_RenderDrawLineF(render, x1, y1, x2, y2);
+	}
+	void drawLines(const SDL_FPoint* points, int count)
+	{
+		if (rasterizer == nullptr)
+		{
+			SDL_RenderDrawLinesF(render, points, count);
+			return;
+		}
+		for (int i = 0; i + 1 < count; i++)
+		{
+			rasterizer->drawLine(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, drawColor);
+		}
+	}
+	// Like SDL_RenderGeometry(), the rasterizer draws with <pixels> instead of <texture>
+	int drawGeometry(SDL_Texture* texture, const SoftwareRasterizer::Texture* pixels, const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount)
+	{
+		if (rasterizer == nullptr)
+			return SDL_RenderGeometry(render, texture, vertices, vertexCount, indices, indexCount);
+		rasterizer->drawGeometry(pixels, vertices, vertexCount, indices, indexCount);
+		return 0;
+	}
+	SDL_FRect toFRect(const SDL_Rect& rect)
+	{
+		return SDL_FRect{ static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h) };
+	}
+
 	// Draws multiple circles, mainly used for debugging colliders
 	void drawCircles(float x, float y, float radius)
 	{
 		const int resolution = 48;
 		const float step = (2 * PI) / resolution;
 		float radiusMultiplier = 1.f;
-		UINT8 r, g, b, a;
-		SDL_GetRenderDrawColor(render, &r, &g, &b, &a);
-		UINT8 currentRed = r, currentGreen = g, currentBlue = b;
+		Uint8 r, g, b, a;
+		getDrawColor(&r, &g, &b, &a);
+		Uint8 currentRed = r, currentGreen = g, currentBlue = b;
 
 		for (int j = 0; j < 3; j++, radiusMultiplier -= 0.33f)
 		{
@@ -44,26 +161,25 @@ namespace Rendering
 				const float x2 = cos(next_angle);
 				const float y2 = sin(next_angle);
 
-				SDL_RenderDrawLineF(
-					render,
+				drawLine(
 					x1 * currentRadius + x,
 					y1 * currentRadius + y,
 					x2 * currentRadius + x,
 					y2 * currentRadius + y
 				);
 			}
-			currentRed = static_cast<UINT8>(currentRed / 1.5);
-			currentGreen = static_cast<UINT8>(currentGreen / 1.5);
-			currentBlue = static_cast<UINT8>(currentBlue / 1.5);
-			SDL_SetRenderDrawColor(render, currentRed, currentGreen, currentBlue, a);
+			currentRed = static_cast<Uint8>(currentRed / 1.5);
+			currentGreen = static_cast<Uint8>(currentGreen / 1.5);
+			currentBlue = static_cast<Uint8>(currentBlue / 1.5);
+			setDrawColor(currentRed, currentGreen, currentBlue, a);
 		}
 
-		SDL_SetRenderDrawColor(render, r, g, b, a); // reset to start color
+		setDrawColor(r, g, b, a); // reset to start color
 	}
 	// Overloading with color
 	void drawCircles(Color color, float x, float y, float radius)
 	{
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+		setDrawColor(color.r, color.g, color.b, color.a);
 		drawCircles(x, y, radius);
 	}
 	// Draws a simple hexagon with a single render call
@@ -83,7 +199,7 @@ namespace Rendering
 		const Vector2 dir = unitDirection(points[5].x, points[5].y, points[6].x, points[6].y);
 		points[6].x -= dir.x * 1.2f;
 		points[6].y -= dir.y * 1.2f;
-		SDL_RenderDrawLinesF(render, points, 7);
+		drawLines(points, 7);
 	}
 
 	// Draws a hexagon with adjustable offset of an additional line
@@ -107,84 +223,166 @@ namespace Rendering
 		points[6].y -= dir.y * 1.2f;
 		points2[6].x -= dir.x * 1.2f;
 		points2[6].y -= dir.y * 1.2f;
-		SDL_RenderDrawLinesF(render, points, 7);
-		SDL_RenderDrawLinesF(render, points2, 7);
+		drawLines(points, 7);
+		drawLines(points2, 7);
 	}
 
 	// Draws objects in process of being deleted - fading out over time
-	void drawObjectsFadingOut(std::vector<ObjectPendingDeletion> objects)
+	void drawObjectsFadingOutLines(const ObjectsPendingDeletion& objects)
 	{
-		for (size_t i =0; i < objects.size(); i++)
+		size_t culled = 0;
+		for (size_t i = 0; i < objects.size(); i++)
 		{
-			const float progress = objects[i].elapsedLifeTime / objects[i].totalLifeTime;
+			const LifeTimeObject& lifeTime = objects.get<LifeTimeObject>(i);
+			const Appearance& appearance = objects.get<Appearance>(i);
+			const float progress = lifeTime.elapsedLifeTime / lifeTime.totalLifeTime;
 			const float sizeMultiplier = 1.f - powf(progress, 2);
 
-			const Position pos = objects[i].position;
+			const Position pos = objects.get<Position>(i);
+			// the corner of the turned sprite, or the outermost ring
+			const float extent = (std::max)((pos.radius * sizeMultiplier + appearance.scaleOffset / 2.f) * 1.4143f, (pos.radius + 19) * sizeMultiplier);
+			if (!Culling::isVisible(SCREEN, pos.x, pos.y, extent))
+			{
+				culled++;
+				continue;
+			}
+
+			SDL_Texture* texture = AssetCache::getTexture(appearance.texture);
 			SDL_Rect destination{
-				static_cast<int>(pos.x - (pos.radius * sizeMultiplier) - (objects[i].appearance.scaleOffset / 2)),
-				static_cast<int>(pos.y - (pos.radius * sizeMultiplier) - (objects[i].appearance.scaleOffset / 2)),
-				static_cast<int>(pos.radius * 2 * sizeMultiplier + objects[i].appearance.scaleOffset),
-				static_cast<int>(pos.radius * 2 * sizeMultiplier + objects[i].appearance.scaleOffset)
+				static_cast<int>(pos.x - (pos.radius * sizeMultiplier) - (appearance.scaleOffset / 2)),
+				static_cast<int>(pos.y - (pos.radius * sizeMultiplier) - (appearance.scaleOffset / 2)),
+				static_cast<int>(pos.radius * 2 * sizeMultiplier + appearance.scaleOffset),
+				static_cast<int>(pos.radius * 2 * sizeMultiplier + appearance.scaleOffset)
 			};
 
-			UINT8 prevAlpha;
-			SDL_GetTextureAlphaMod(objects[i].appearance.texture, &prevAlpha);
-
 			// red tint if destroyed by health line
 			Color color = pos.y + pos.radius > HEALTH_LINE_HEIGHT - 5 ? Color(255, 0, 0, 150) : Color(0, 225, 255, 150);
 
-			const auto alpha = static_cast<UINT8>(std::lerp(255, 0, progress));
-			SDL_SetTextureAlphaMod(objects[i].appearance.texture, alpha);
-			SDL_SetTextureColorMod(objects[i].appearance.texture, color.r, color.g, color.b);
-			SDL_RenderCopyEx(render, objects[i].appearance.texture, NULL, &destination, objects[i].angle, NULL, SDL_RendererFlip::SDL_FLIP_NONE);
-			SDL_SetTextureAlphaMod(objects[i].appearance.texture, prevAlpha);
+			const auto alpha = static_cast<Uint8>(std::lerp(255, 0, progress));
+			if (rasterizer != nullptr)
+			{
+				if (const SoftwareRasterizer::Texture* pixels = rasterizer->getTexture(appearance.texture))
+					rasterizer->drawSprite(*pixels, toFRect(destination), objects.get<Rotation>(i).angle, SDL_Color{ color.r, color.g, color.b, alpha });
+			}
+			else
+			{
+				Uint8 prevAlpha;
+				SDL_GetTextureAlphaMod(texture, &prevAlpha);
+				SDL_SetTextureAlphaMod(texture, alpha);
+				SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+				SDL_RenderCopyEx(render, texture, NULL, &destination, objects.get<Rotation>(i).angle, NULL, SDL_RendererFlip::SDL_FLIP_NONE);
+				SDL_SetTextureAlphaMod(texture, prevAlpha);
+			}
 
 			constexpr int fadeCount = 12;
-			
+			// reduced draws the inner half of the rings, minimal none of them
+			const Detail detail = detailController.getDetail();
+			const int ringCount = detail == Detail::Full ? fadeCount : detail == Detail::Reduced ? fadeCount / 2 : 0;
 
-			for (size_t j = 0; j < fadeCount; j++)
+			for (int j = 0; j < ringCount; j++)
 			{
 				float multiplier = 1 - (static_cast<float>(j) / static_cast<float>(fadeCount));
 				multiplier = powf(multiplier, 2);
-				const auto r = static_cast<UINT8>(color.r * multiplier);
-				const auto g = static_cast<UINT8>(color.g * multiplier);
-				const auto b = static_cast<UINT8>(color.b * multiplier);
-				const auto a = static_cast<UINT8>(color.a * multiplier * (1 - progress));
-				SDL_SetRenderDrawColor(render, r, g, b, a);
+				const auto r = static_cast<Uint8>(color.r * multiplier);
+				const auto g = static_cast<Uint8>(color.g * multiplier);
+				const auto b = static_cast<Uint8>(color.b * multiplier);
+				const auto a = static_cast<Uint8>(color.a * multiplier * (1 - progress));
+				setDrawColor(r, g, b, a);
 				drawHexagon(pos.x, pos.y, (pos.radius + j + 7.f) * sizeMultiplier, 0.5f);
 				drawHexagon(pos.x, pos.y, (pos.radius - j * 0.5f) * sizeMultiplier);
 			}
-			SDL_SetRenderDrawColor(render, 0, 225, 255, 255 * (1 - progress));
+			setDrawColor(0, 225, 255, 255 * (1 - progress));
 			drawHexagon(pos.x, pos.y, (pos.radius + 1) * sizeMultiplier, 1.f);
 			drawHexagon(pos.x, pos.y, (pos.radius + 7) * sizeMultiplier);
 		}
+		countCulling(Layer::FadingObjects, objects.size() - culled, culled);
+	}
 
+	void drawObjectsFadingOut(const ObjectsPendingDeletion& objects)
+	{
+		SDL_Texture* glowAtlas = glowBatch.getTexture();
+		if (glowAtlas == nullptr && rasterizer == nullptr)
+		{
+			drawObjectsFadingOutLines(objects);
+			return;
+		}
+
+		glowBatch.emit(objects, SCREEN, detailController.getDetail());
+		countCulling(Layer::FadingObjects, objects.size() - glowBatch.getCulledCount(), glowBatch.getCulledCount());
+		for (const GlowBatch::SpriteGroup& group : glowBatch.getSpriteGroups())
+		{
+			if (rasterizer != nullptr)
+			{
+				if (const SoftwareRasterizer::Texture* pixels = rasterizer->getTexture(group.texture))
+				{
+					rasterizer->drawGeometry(pixels, glowBatch.getSpriteVertices(), glowBatch.getSpriteVertexCount(),
+						glowBatch.getIndices() + group.firstIndex, group.indexCount);
+				}
+				continue;
+			}
+
+			SDL_Texture* texture = AssetCache::getTexture(group.texture);
+			if (texture == nullptr) continue;
+
+			// the tint and alpha are in the vertex colors, the texture is shared with the objects that are still alive
+			Uint8 r, g, b, a;
+			SDL_GetTextureColorMod(texture, &r, &g, &b);
+			SDL_GetTextureAlphaMod(texture, &a);
+			SDL_SetTextureColorMod(texture, 255, 255, 255);
+			SDL_SetTextureAlphaMod(texture, 255);
+			SDL_RenderGeometry(render, texture, glowBatch.getSpriteVertices(), glowBatch.getSpriteVertexCount(),
+				glowBatch.getIndices() + group.firstIndex, group.indexCount);
+			SDL_SetTextureColorMod(texture, r, g, b);
+			SDL_SetTextureAlphaMod(texture, a);
+		}
+
+		const SoftwareRasterizer::Texture glowPixels{ glowBatch.getPixels(), glowBatch.getWidth(), glowBatch.getHeight() };
+		if (drawGeometry(glowAtlas, &glowPixels, glowBatch.getGlowVertices(), glowBatch.getGlowVertexCount(), glowBatch.getIndices(), glowBatch.getGlowIndexCount()) != 0)
+			std::cout << "Failed to draw the glows! SDL Error: " << SDL_GetError() << std::endl;
 	}
 
 	// Draws all movable objects available in the game
-	void drawObjects(std::vector<Position> positions, std::vector<Appearance> appearances, std::vector<Rotation> rotations)
+	void drawObjects(const MovableObjects& objects)
 	{
-		for (int i = 0; i < positions.size(); i++)
+		size_t culled = 0;
+		objects.forEach<Position, Appearance, Rotation>([&culled](size_t, const Position& position, const Appearance& appearance, const Rotation& rotation)
 		{
+			// to the corner of the turned sprite
+			if (!Culling::isVisible(SCREEN, position.x, position.y, (position.radius + appearance.scaleOffset / 2.f) * 1.4143f))
+			{
+				culled++;
+				return;
+			}
+
 			SDL_Rect destination{
-				static_cast<int>(positions[i].x - positions[i].radius - (appearances[i].scaleOffset / 2)),
-				static_cast<int>(positions[i].y - positions[i].radius - (appearances[i].scaleOffset / 2)),
-				static_cast<int>(positions[i].radius * 2 + appearances[i].scaleOffset),
-				static_cast<int>(positions[i].radius * 2 + appearances[i].scaleOffset)
+				static_cast<int>(position.x - position.radius - (appearance.scaleOffset / 2)),
+				static_cast<int>(position.y - position.radius - (appearance.scaleOffset / 2)),
+				static_cast<int>(position.radius * 2 + appearance.scaleOffset),
+				static_cast<int>(position.radius * 2 + appearance.scaleOffset)
 			};
-			if (appearances[i].tint.a > 0)
-				SDL_SetTextureColorMod(appearances[i].texture, appearances[i].tint.r, appearances[i].tint.g, appearances[i].tint.b);
-			SDL_RenderCopyEx(render, appearances[i].texture, nullptr, &destination, rotations[i].angle, nullptr, SDL_FLIP_NONE);
-		}
+			if (rasterizer != nullptr)
+			{
+				const SoftwareRasterizer::Texture* pixels = rasterizer->getTexture(appearance.texture);
+				const SDL_Color tint = appearance.tint.a > 0 ? SDL_Color{ appearance.tint.r, appearance.tint.g, appearance.tint.b, 255 } : SDL_Color{ 255, 255, 255, 255 };
+				if (pixels != nullptr)
+					rasterizer->drawSprite(*pixels, toFRect(destination), rotation.angle, tint);
+				return;
+			}
+			SDL_Texture* texture = AssetCache::getTexture(appearance.texture);
+			if (appearance.tint.a > 0)
+				SDL_SetTextureColorMod(texture, appearance.tint.r, appearance.tint.g, appearance.tint.b);
+			SDL_RenderCopyEx(render, texture, nullptr, &destination, rotation.angle, nullptr, SDL_FLIP_NONE);
+		});
+		countCulling(Layer::Objects, objects.size() - culled, culled);
 	}
 
 	// Renders two lines from startPosition to endPosition with offset
 	void drawDoubleLines(Position startPosition, Position endPosition, Vector2 offsetDirection, float startOffset, float endOffset)
 	{
-		SDL_RenderDrawLineF(render, startPosition.x + offsetDirection.x * startOffset, startPosition.y + offsetDirection.y * startOffset,
+		drawLine(startPosition.x + offsetDirection.x * startOffset, startPosition.y + offsetDirection.y * startOffset,
 			endPosition.x + offsetDirection.x * endOffset, endPosition.y + offsetDirection.y * endOffset);
 
-		SDL_RenderDrawLineF(render, startPosition.x - offsetDirection.x * startOffset, startPosition.y - offsetDirection.y * startOffset,
+		drawLine(startPosition.x - offsetDirection.x * startOffset, startPosition.y - offsetDirection.y * startOffset,
 			endPosition.x - offsetDirection.x * endOffset, endPosition.y - offsetDirection.y * endOffset);
 	}
 
@@ -193,24 +391,24 @@ namespace Rendering
 	{
 		const float startOffset = progress > 0.f ? offset * (1 - progress) : 0.f;
 
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+		setDrawColor(color.r, color.g, color.b, color.a);
 		drawDoubleLines(startPosition, endPosition, offsetDirection, startOffset, offset);
 	}
 	// Overloaded: Renders two lines with equal offset in each direction - with new color
 	void drawDoubleLines(Color color, Position startPosition, Position endPosition, Vector2 offsetDirection, float offset)
 	{
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+		setDrawColor(color.r, color.g, color.b, color.a);
 		drawDoubleLines(startPosition, endPosition, offsetDirection, offset, offset);
 	}
 	// Draws a single line with with a specific color
 	void drawSingleLine(Color color, Position start, Position end)
 	{
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-		SDL_RenderDrawLineF(render, start.x, start.y, end.x, end.y);
+		setDrawColor(color.r, color.g, color.b, color.a);
+		drawLine(start.x, start.y, end.x, end.y);
 	}
 
 	// Draws the "protection laser" which symbolizes the player's health
-	void drawHealthLine(MusicData* music, int playerHealth)
+	void drawHealthLine(const MusicData* music, int playerHealth)
 	{
 		// this is just a dirty solution for this deadline 
 		// if I had more time I'd simply create a spritesheet of a beam
@@ -244,31 +442,34 @@ namespace Rendering
 		}
 	}
 
-	void drawLasers(std::vector<Laser> lasers, std::vector<Position> positions, Position playerPos)
+	void drawLaserLines(const Lasers& lasers, Position playerPos)
 	{
 		if (lasers.empty()) return;
-
+		// reduced leaves out the burst and the darker lines, minimal also the circle at the end and the moving trail
+		const Detail detail = detailController.getDetail();
 
 		for (size_t i = 0; i < lasers.size(); i++)
 		{
-			Color color = lasers[i].color;
+			const LifeTimeObject& lifeTime = lasers.get<LifeTimeObject>(i);
+			const Line& line = lasers.get<Line>(i);
+			Color color = lasers.get<Color>(i);
 
-			Vector2 playerToEndDirection = unitDirection(playerPos.x, playerPos.y, lasers[i].x2, lasers[i].y2);
+			Vector2 playerToEndDirection = unitDirection(playerPos.x, playerPos.y, line.x2, line.y2);
 			const Vector2 playerEdgePosition = Vector2(playerPos.x, playerPos.y) + playerToEndDirection * playerPos.radius;
 
 			// the line's lifetime eased with different easing functions
-			const float progress = lasers[i].elapsedLifeTime / lasers[i].totalLifeTime;
+			const float progress = lifeTime.elapsedLifeTime / lifeTime.totalLifeTime;
 			const float progress1 = Ease::InOutSine(progress);
 			const float progress2 = Ease::Out(progress1, 4);
 			const float progress3 = Ease::Out(progress, 5);
 
 			color.a *= 1 - progress2; // fadeout opacity over lifetime
 
-			const Position basePosition = Position(lasers[i].x1, lasers[i].y1); // start position without offset
-			const Position endPosition(lasers[i].x2, lasers[i].y2);
-			const Position startPosition(std::lerp(lasers[i].x1, endPosition.x, progress1), std::lerp(lasers[i].y1, endPosition.y, progress1));
+			const Position basePosition = Position(line.x1, line.y1); // start position without offset
+			const Position endPosition(line.x2, line.y2);
+			const Position startPosition(std::lerp(line.x1, endPosition.x, progress1), std::lerp(line.y1, endPosition.y, progress1));
 
-			Vector2 direction = unitDirection(Vector2(lasers[i].x1, lasers[i].y1), Vector2(lasers[i].x2, lasers[i].y2));
+			Vector2 direction = unitDirection(Vector2(line.x1, line.y1), Vector2(line.x2, line.y2));
 			const Vector2 offsetVector = direction.perpendicularVector();
 
 			// decrease the amount of layers toward the end of the laser's lifetime
@@ -284,11 +485,11 @@ namespace Rendering
 				drawDoubleLines(color.multiplied(1 - (j*0.15f)), startPosition, endPosition, offsetVector, progress3, j + 1);
 			}
 			
-			if(progress2 < 0.4f)
+			if(progress2 < 0.4f && detail != Detail::Minimal)
 			{
 				// draw circle at the end to make the edge more smooth
 				drawCircles(color.multiplied(1.f, 0.25f), endPosition.x, endPosition.y, 3);
-				if (progress2 < 0.2f)
+				if (progress2 < 0.2f && detail == Detail::Full)
 				{
 					// draw "burst" lines, offset to look like a cone
 					for (int j = 0; j < 6; j++)
@@ -296,11 +497,11 @@ namespace Rendering
 						for (int k = 0; k < 3; k++)
 						{
 							const float alphaMultiplier = 1 - j * 0.15f;
-							Color col = color.multiplied(1.f, (1 - lasers[i].elapsedLifeTime / 0.2f) * alphaMultiplier);
+							Color col = color.multiplied(1.f, (1 - lifeTime.elapsedLifeTime / 0.2f) * alphaMultiplier);
 
-							const float length = static_cast<float>(rand() % 30 + 10) * (0.5f + (lasers[i].elapsedLifeTime / 0.2f));
+							const float length = static_cast<float>(rand() % 30 + 10) * (0.5f + (lifeTime.elapsedLifeTime / 0.2f));
 							const Position startPos(playerEdgePosition.x - direction.x * 20, playerEdgePosition.y - direction.y * 20);
-							const Position endPosition(lasers[i].x1 + direction.x * length, lasers[i].y1 + direction.y * length);
+							const Position endPosition(line.x1 + direction.x * length, line.y1 + direction.y * length);
 							drawDoubleLines(col, startPos, endPosition, offsetVector, 0.f, (3.f + j * 4.f));
 						}
 
@@ -308,7 +509,7 @@ namespace Rendering
 					if (progress2 < 0.1f)
 					{
 						// draw darker lines outside the center line
-						SDL_SetRenderDrawColor(render, color.r * 0.7f, color.g * 0.7f, color.b * 0.7f, color.a * (1 - lasers[i].elapsedLifeTime / 0.1f));
+						setDrawColor(color.r * 0.7f, color.g * 0.7f, color.b * 0.7f, color.a * (1 - lifeTime.elapsedLifeTime / 0.1f));
 						for (int j = 1; j < 8; j += 2)
 						{
 							drawDoubleLines(basePosition, endPosition, offsetVector, j, 5);
@@ -323,15 +524,15 @@ namespace Rendering
 			drawDoubleLines(color.multiplied(0.8f, (1 - progress2) * 0.25f), basePosition, endPosition, offsetVector, 1);
 
 			// draw moving transparent trail
-			SDL_SetRenderDrawColor(render, color.r, color.g, color.b, 255 * (1 - progress2 / 0.8f));
-			if (progress2 < 0.8f && progress2 > 0.05f)
+			setDrawColor(color.r, color.g, color.b, 255 * (1 - progress2 / 0.8f));
+			if (progress2 < 0.8f && progress2 > 0.05f && detail != Detail::Minimal)
 			{
-				SDL_RenderDrawLineF(render, startPosition.x - direction.x * 50.f, startPosition.y - direction.y * 50.f, endPosition.x, endPosition.y);
+				drawLine(startPosition.x - direction.x * 50.f, startPosition.y - direction.y * 50.f, endPosition.x, endPosition.y);
 			}
 
 			//draw highlight
-			SDL_SetRenderDrawColor(render, 255, 255, 255, color.a);
-			SDL_RenderDrawLineF(render, startPosition.x, startPosition.y, endPosition.x, endPosition.y);
+			setDrawColor(255, 255, 255, color.a);
+			drawLine(startPosition.x, startPosition.y, endPosition.x, endPosition.y);
 		}
 	}
 
@@ -348,84 +549,71 @@ namespace Rendering
 			const float x2 = cos(nextAngle);
 			const float y2 = sin(nextAngle);
 
-			SDL_RenderDrawLine(
-				render, x1 * radius + x, y1 * radius + y, x2 * radius + x, y2 * radius + y
+			drawLine(
+				x1 * radius + x, y1 * radius + y, x2 * radius + x, y2 * radius + y
 			);
 		}
 	}
 
-	// Draws a star made out of two triangles that are based on the same square, 
-	// offset to make them look like a star
-	void drawStar(Star star, float size, float elapsedTime, int thickness = 3)
+	void updateStars(const MusicData* music, const Stars& stars, float elapsedTime)
 	{
-		// triangle pointing downward \/
-		SDL_FPoint downwardTriangle[4];
-		downwardTriangle[0] = SDL_FPoint(star.x - size / 2, star.y - size / 2);
-		downwardTriangle[1] = SDL_FPoint(downwardTriangle[0].x + size, downwardTriangle[0].y);
-		downwardTriangle[2] = SDL_FPoint(star.x, star.y + size / 2);
-		downwardTriangle[3] = downwardTriangle[0];
-
-		// triangle pointing upward /\ 
-		SDL_FPoint upwardTriangle[4];
-		upwardTriangle[0] = SDL_FPoint(star.x - size / 2, star.y + size / 2);
-		upwardTriangle[1] = SDL_FPoint(upwardTriangle[0].x + size, upwardTriangle[0].y);
-		upwardTriangle[2] = SDL_FPoint(star.x, star.y - size / 2);
-		upwardTriangle[3] = upwardTriangle[0];
-
-		for (int p = 0; p < 4; p++)
-		{
-			// offset y to centralize both triangles to make them look like a star together
-			downwardTriangle[p].y += size / 8;
-			upwardTriangle[p].y -= size / 8;
-			// rotate all points of the triangles, to make the star spin
-			rotatePoint(downwardTriangle[p].x, downwardTriangle[p].y, star.x, star.y, elapsedTime * 50);
-			rotatePoint(upwardTriangle[p].x, upwardTriangle[p].y, star.x, star.y, elapsedTime * 50);
-		}
+		StarBatch::FrameState frame;
+		frame.musicIsPlaying = music->musicIsPlaying;
+		frame.wholeNoteLength = music->wholeNoteLength;
+		frame.quarterNoteProgress = music->quarterNoteProgress;
+		frame.pulseMultiplier = music->pulseMultiplier;
+		frame.elapsedTime = elapsedTime;
+		starBatch.update(stars, frame);
+	}
 
-		SDL_RenderDrawLinesF(render, downwardTriangle, 4);
-		SDL_RenderDrawLinesF(render, upwardTriangle, 4);
+	bool loadGeneratedTextures()
+	{
+		const bool starAtlasCreated = starAtlas.createTexture(render);
+		const bool beamTextureCreated = laserBatch.createTexture(render);
+		return glowBatch.createTexture(render) && starAtlasCreated && beamTextureCreated;
 	}
 
+	void unloadGeneratedTextures()
+	{
+		starAtlas.destroy();
+		laserBatch.destroy();
+		glowBatch.destroy();
+	}
 
-	void drawStars(MusicData* music, std::vector<Star> starList, float elapsedTime)
+	void drawLasers(const Lasers& lasers, Position playerPos)
 	{
-		if (music->musicIsPlaying)
-			for (int i = starList.size() - 1; i > 0; i--)
-			{
-				const int lifeTime = static_cast<int>(std::round(starList[i].totalLifeTime));
-				const float fadeInTime = lifeTime <= 4 ? 0.04f : 2.f;
-				const float beatMultiplier =
-					lifeTime == 1 ? music->quarterNoteProgress * 0.5f + 0.5f :
-					lifeTime == 2 ? 1 - (music->quarterNoteProgress * 0.5f + 0.5f) :
-					lifeTime == 3 ? Ease::Out(music->pulseMultiplier, 3) :
-					lifeTime == 4 ? 1 - Ease::Out(music->pulseMultiplier, 3) : 1.f;
-				;
-
-				const float normalizedLife = starList[i].elapsedLifeTime / (music->wholeNoteLength * starList[i].totalLifeTime);
-				const float lifeMultiplier = 1 - Ease::Out(normalizedLife, 2);
-				const float fadeInMultiplier = Ease::Out( std::clamp(starList[i].elapsedLifeTime / fadeInTime, 0.f, 1.f), 2);
-				const Color color = starList[i].color;
-				SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a * lifeMultiplier * beatMultiplier * fadeInMultiplier);
-				drawStar(starList[i], std::clamp(starList[i].maxSize * lifeMultiplier, 1.f, starList[i].maxSize) * fadeInMultiplier, elapsedTime);
-			}
-		else
+		if (lasers.empty()) return;
+
+		SDL_Texture* beamTexture = laserBatch.getTexture();
+		if (beamTexture == nullptr && rasterizer == nullptr)
 		{
-			for (int i = starList.size() - 1; i > 0; i--)
-			{
-				const float normalizedLife = starList[i].elapsedLifeTime / (music->wholeNoteLength * starList[i].totalLifeTime);
-				const float lifeMultiplier = 1 - Ease::Out(normalizedLife, 2);
-				const Color color = starList[i].color;
-				SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a * lifeMultiplier);
-				drawStar(starList[i], starList[i].maxSize, elapsedTime);
-			}
+			drawLaserLines(lasers, playerPos);
+			return;
 		}
+
+		const int indexCount = laserBatch.emit(lasers, playerPos, detailController.getDetail());
+		const SoftwareRasterizer::Texture beamPixels{ laserBatch.getPixels(), LaserBatch::TEXTURE_WIDTH, LaserBatch::TEXTURE_HEIGHT };
+		if (drawGeometry(beamTexture, &beamPixels, laserBatch.getVertices(), laserBatch.getVertexCount(), laserBatch.getIndices(), indexCount) != 0)
+			std::cout << "Failed to draw the lasers! SDL Error: " << SDL_GetError() << std::endl;
 	}
 
+	void drawStars(const Stars& stars)
+	{
+		SDL_Texture* atlas = starAtlas.getTexture();
+		const bool hasAtlas = atlas != nullptr || rasterizer != nullptr;
+		const int vertexCount = starBatch.emit(stars, hasAtlas ? &starAtlas : nullptr);
+		if (vertexCount == 0) return;
+
+		const int* indices = hasAtlas ? starBatch.getIndices() : nullptr;
+		const SoftwareRasterizer::Texture glyphs{ starAtlas.getPixels(), StarAtlas::ATLAS_WIDTH, StarAtlas::ATLAS_HEIGHT };
+		if (drawGeometry(atlas, hasAtlas ? &glyphs : nullptr, starBatch.getVertices(), vertexCount, indices, starBatch.getIndexCount()) != 0)
+			std::cout << "Failed to draw the stars! SDL Error: " << SDL_GetError() << std::endl;
+	}
 
 	// Used for all note lengths, during active beat
 	void drawActiveBeatCircle(Position pos, Color color, float distanceMultiplier = 1.f)
 	{
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a * distanceMultiplier * distanceMultiplier);
+		setDrawColor(color.r, color.g, color.b, color.a * distanceMultiplier * distanceMultiplier);
 
 		if (pos.radius > MIN_SIZE_HALFNOTE)
 			drawHexagon(pos.x, pos.y, pos.radius + 6);
@@ -440,30 +628,16 @@ namespace Rendering
 		{
 			float radius2 = std::lerp(radius, pos.radius, secondBeatProgress);
 			radius2 = std::clamp(radius2, pos.radius, radius);
-			SDL_SetRenderDrawColor(render, color.r, 0, color.b, color.a * 0.66f * distanceMultiplier);
+			setDrawColor(color.r, 0, color.b, color.a * 0.66f * distanceMultiplier);
 			drawHexagon(pos.x, pos.y, radius2);
 		}
 		const float halfNoteMultiplier = 1 + (1 - secondBeatProgress);
-		SDL_SetRenderDrawColor(render, 100, 0, 200, 100 * distanceMultiplier * halfNoteMultiplier);
+		setDrawColor(100, 0, 200, 100 * distanceMultiplier * halfNoteMultiplier);
 		drawHexagon(pos.x, pos.y, pos.radius);
 		drawHexagon(pos.x, pos.y, pos.radius + 1);
-		SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a * distanceMultiplier);
-	}
-	Color getBeatCircleColor(bool isBeatActive, float beatProgress, float fadeInProgress, int add = 0)
-	{
-		fadeInProgress = std::clamp(fadeInProgress, 0.f, 1.f);
-		return Color{
-			isBeatActive ? 60.f : std::lerp(100.f, 80.f, Ease::In(beatProgress, 4)), 0.f,
-			isBeatActive ? 225.f : (200 + add) * beatProgress,
-			isBeatActive ? 255.f : (200 + add) * fadeInProgress
-		};
+		setDrawColor(color.r, color.g, color.b, color.a * distanceMultiplier);
 	}
-	float getBeatCircleRadius(float prevRadius, float timeElapsed, float beatLength, float synchDuration)
-	{
-		return std::lerp(prevRadius * 2.5f, prevRadius,
-						(timeElapsed - synchDuration) / (beatLength - synchDuration));
-	}
-	void drawBeatCircles(MusicData* music, std::vector<Position> positions, std::vector<Tag> tags, size_t playerIndex)
+	void drawBeatCircleLines(const MusicData* music, const MovableObjects& objects, size_t playerIndex)
 	{
 		int mouseX, mouseY;
 		SDL_GetMouseState(&mouseX, &mouseY);
@@ -478,90 +652,172 @@ namespace Rendering
 		const float wholeFadeInProgress   = (music->timeSinceLastWholeNote   - synchDuration) / 0.5f;
 		const float halfFadeInProgress    = (music->timeSinceLastHalfNote    - synchDuration) / 0.2f;
 
-		const Color quarterNoteColor = getBeatCircleColor(quarterNoteActive, music->quarterNoteProgress, quarterFadeInProgress);
-		const Color wholeNoteColor   = getBeatCircleColor(wholeNoteActive,   music->wholeNoteProgress, wholeFadeInProgress, 20);
-		const Color halfNoteColor    = getBeatCircleColor(halfNoteActive,    music->halfNoteProgress, halfFadeInProgress, 15);
+		const Color quarterNoteColor = BeatCircleBatch::getColor(quarterNoteActive, music->quarterNoteProgress, quarterFadeInProgress);
+		const Color wholeNoteColor   = BeatCircleBatch::getColor(wholeNoteActive,   music->wholeNoteProgress, wholeFadeInProgress, 20);
+		const Color halfNoteColor    = BeatCircleBatch::getColor(halfNoteActive,    music->halfNoteProgress, halfFadeInProgress, 15);
 
-		for (size_t i = 0; i < positions.size(); i++)
+		size_t culled = 0;
+		for (size_t i = 0; i < objects.size(); i++)
 		{
 			if (i == playerIndex) continue;
 
-			if (tags[i] == Tag::Unsplittable) // draw red pentagon if the object is disabled
+			const Position& position = objects.get<Position>(i);
+			// as far out as the rings off the beat start shrinking from
+			if (!Culling::isVisible(SCREEN, position.x, position.y, position.radius * 2.5f + BeatCircleBatch::MAX_RING_OFFSET))
 			{
-				SDL_SetRenderDrawColor(render, 150, 0, 0, 175);
-				drawHexagon(positions[i].x, positions[i].y, positions[i].radius + 1, 1.f);
-				drawHexagon(positions[i].x, positions[i].y, positions[i].radius + 7);
+				culled++;
 				continue;
 			}
-			float radius = positions[i].radius;
-			const float distanceToMouse = distance(mouseX, mouseY, positions[i].x, positions[i].y);
+
+			if (objects.get<Tag>(i) == Tag::Unsplittable) // draw red pentagon if the object is disabled
+			{
+				setDrawColor(150, 0, 0, 175);
+				drawHexagon(position.x, position.y, position.radius + 1, 1.f);
+				drawHexagon(position.x, position.y, position.radius + 7);
+				continue;
+			}
+			float radius = position.radius;
+			const float distanceToMouse = distance(mouseX, mouseY, position.x, position.y);
 			constexpr float maxDistance = 1300;
-			float distanceMultiplier = 1 - (distanceToMouse - (positions[i].radius * 1.5f) - 50) / maxDistance;
+			float distanceMultiplier = 1 - (distanceToMouse - (position.radius * 1.5f) - 50) / maxDistance;
 
 			distanceMultiplier = powf(std::clamp(distanceMultiplier,0.f,1.f), 3);
 
-			if (positions[i].radius > MIN_SIZE_WHOLENOTE)
+			if (position.radius > MIN_SIZE_WHOLENOTE)
 			{
 				if (wholeNoteActive)
-					drawActiveBeatCircle(positions[i], wholeNoteColor, distanceMultiplier);
+					drawActiveBeatCircle(position, wholeNoteColor, distanceMultiplier);
 				else
 				{
-					radius = getBeatCircleRadius(radius, music->timeSinceLastWholeNote, music->wholeNoteLength, synchDuration);
+					radius = BeatCircleBatch::getRadius(radius, music->timeSinceLastWholeNote, music->wholeNoteLength, synchDuration);
 
-					drawOffBeatCircle(positions[i], wholeNoteColor, music->wholeNoteProgress, 
+					drawOffBeatCircle(position, wholeNoteColor, music->wholeNoteProgress, 
 								      music->halfNoteProgress, radius, distanceMultiplier);
 				}
 			}
-			else if (positions[i].radius > MIN_SIZE_HALFNOTE)
+			else if (position.radius > MIN_SIZE_HALFNOTE)
 			{
 				if (halfNoteActive)
-					drawActiveBeatCircle(positions[i], halfNoteColor, distanceMultiplier);
+					drawActiveBeatCircle(position, halfNoteColor, distanceMultiplier);
 				else
 				{
-					radius = getBeatCircleRadius(radius, music->timeSinceLastHalfNote, music->halfNoteLength, synchDuration);
+					radius = BeatCircleBatch::getRadius(radius, music->timeSinceLastHalfNote, music->halfNoteLength, synchDuration);
 
-					drawOffBeatCircle(positions[i], halfNoteColor, music->halfNoteProgress, 
+					drawOffBeatCircle(position, halfNoteColor, music->halfNoteProgress, 
 					                  music->quarterNoteProgress, radius, distanceMultiplier);
 				}
 			}
 			else // quarter notes
 			{
 				if (quarterNoteActive)
-					drawActiveBeatCircle(positions[i], quarterNoteColor, distanceMultiplier);
+					drawActiveBeatCircle(position, quarterNoteColor, distanceMultiplier);
 				else
 				{
-					radius = getBeatCircleRadius(radius, music->timeSinceLastQuarterNote, music->quarterNoteLength, synchDuration);
+					radius = BeatCircleBatch::getRadius(radius, music->timeSinceLastQuarterNote, music->quarterNoteLength, synchDuration);
 
-					SDL_SetRenderDrawColor(render, 115, 0, 230, 100 * distanceMultiplier);
-					drawHexagon(positions[i].x, positions[i].y, positions[i].radius);
+					setDrawColor(115, 0, 230, 100 * distanceMultiplier);
+					drawHexagon(position.x, position.y, position.radius);
 
-					SDL_SetRenderDrawColor(render, quarterNoteColor.r, quarterNoteColor.g, quarterNoteColor.b,
+					setDrawColor(quarterNoteColor.r, quarterNoteColor.g, quarterNoteColor.b,
 					                       quarterNoteColor.a * distanceMultiplier);
 				}
 			}
 
-			drawHexagon(positions[i].x, positions[i].y, radius, 1.f);
-			UINT8 r, g, b, a;
-			SDL_GetRenderDrawColor(render, &r, &g, &b, &a);
-			SDL_SetRenderDrawColor(render, r, g, b, a * 0.9f);
-			drawHexagon(positions[i].x, positions[i].y, radius + 5, 0.5f);
+			drawHexagon(position.x, position.y, radius, 1.f);
+			Uint8 r, g, b, a;
+			getDrawColor(&r, &g, &b, &a);
+			setDrawColor(r, g, b, a * 0.9f);
+			drawHexagon(position.x, position.y, radius + 5, 0.5f);
 		}
+		countCulling(Layer::BeatCircles, objects.size() - (playerIndex < objects.size()) - culled, culled);
+	}
+
+	void drawBeatCircles(const MusicData* music, const MovableObjects& objects, size_t playerIndex)
+	{
+		int mouseX, mouseY;
+		SDL_GetMouseState(&mouseX, &mouseY);
+
+		beatCircleBatch.classify(objects, playerIndex, *music, static_cast<float>(mouseX), static_cast<float>(mouseY), SCREEN);
+		countCulling(Layer::BeatCircles, beatCircleBatch.getCircleCount(), beatCircleBatch.getCulledCount());
+		const int indexCount = beatCircleBatch.emit(detailController.getDetail());
+		if (indexCount == 0) return;
+
+		if (drawGeometry(nullptr, nullptr, beatCircleBatch.getVertices(), beatCircleBatch.getVertexCount(), beatCircleBatch.getIndices(), indexCount) != 0)
+			std::cout << "Failed to draw the beat circles! SDL Error: " << SDL_GetError() << std::endl;
 	}
 
 	void drawBackground()
 	{
+		if (rasterizer != nullptr)
+		{
+			// it covers the whole frame
+			rasterizer->clear(SDL_Color{ 0, 7, 14, 255 });
+			return;
+		}
 		const SDL_Rect rect(0, 0, WIDTH, HEIGHT);
-		SDL_SetRenderDrawColor(render, 0, 7, 14, 255);
+		setDrawColor(0, 7, 14, 255);
 		SDL_RenderFillRect(render, &rect);
 	}
 
+	Uint64 endLayer(Layer layer, Uint64 startTicks)
+	{
+		const Uint64 ticks = SDL_GetPerformanceCounter();
+		LayerTime& time = layerTimes[static_cast<int>(layer)];
+		const double milliseconds = 1000.0 * static_cast<double>(ticks - startTicks) / SDL_GetPerformanceFrequency();
+		time.totalMilliseconds += milliseconds;
+		time.maxMilliseconds = (std::max)(time.maxMilliseconds, milliseconds);
+		time.frames++;
+		return ticks;
+	}
+
+	void printLayerStats()
+	{
+		const char* names[] = { "background", "stars", "lasers", "fading objects", "objects", "health line", "beat circles" };
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "Layers (time to submit the draw calls):\n";
+		for (int i = 0; i < static_cast<int>(Layer::Count); i++)
+		{
+			const LayerTime& time = layerTimes[i];
+			if (time.frames == 0) continue;
+			std::cout << "  " << std::left << std::setw(15) << names[i] << std::right << std::setw(8) << time.totalMilliseconds / time.frames
+				<< " ms avg, " << std::setw(8) << time.maxMilliseconds << " ms max";
+			if (time.objects.visible + time.objects.culled > 0)
+			{
+				std::cout << std::setprecision(1) << ", " << static_cast<double>(time.objects.visible) / time.frames << " objects drawn, "
+					<< static_cast<double>(time.objects.culled) / time.frames << " culled" << std::setprecision(3);
+			}
+			std::cout << "\n";
+		}
+		const Uint64 detailFrames = detailController.getFrameCount(Detail::Full) + detailController.getFrameCount(Detail::Reduced)
+			+ detailController.getFrameCount(Detail::Minimal);
+		if (detailFrames > 0)
+		{
+			std::cout << std::setprecision(1) << "  detail:";
+			for (int i = 0; i < static_cast<int>(Detail::Count); i++)
+			{
+				const Detail detail = static_cast<Detail>(i);
+				std::cout << " " << DetailController::getName(detail) << " " << 100.0 * detailController.getFrameCount(detail) / detailFrames << "%"
+					<< (i + 1 < static_cast<int>(Detail::Count) ? "," : "");
+			}
+			std::cout << " of frames, changed " << detailController.getChangeCount() << " times, ended at "
+				<< DetailController::getName(detailController.getDetail()) << "\n";
+		}
+		std::cout.flush();
+	}
+
 	void renderPresent()
 	{
-		SDL_RenderPresent(render);
+		if (rasterizer != nullptr)
+			rasterizer->flush();
+		else
+			SDL_RenderPresent(render);
 	}
 
 	void renderClear()
 	{
-		SDL_RenderClear(render);
+		if (rasterizer != nullptr)
+			rasterizer->clear(drawColor);
+		else
+			SDL_RenderClear(render);
 	}
 }
\ No newline at end of file
@@ -1,23 +1,58 @@
 #pragma once
+#include "detailController.h"
 #include "gameObject.h"
 #include "musicManager.h"
 
 using namespace GameObject;
+struct SoftwareRasterizer;
 
 namespace Rendering
 {
+	// The layers drawn by Engine::drawEverything(), in order
+	enum class Layer { Background, Stars, Lasers, FadingObjects, Objects, HealthLine, BeatCircles, Count };
+
 	SDL_Renderer* getRenderer();
 	void setRenderer(SDL_Renderer* renderer);
-	void drawObjects(std::vector<Position> positions, std::vector<Appearance> appearances, std::vector<Rotation> rotations);
-	void drawObjectsFadingOut(std::vector<ObjectPendingDeletion> objects);
+	// Draws into <rasterizer> instead of the renderer until it's set back to nullptr, renderPresent() flushes it.
+	// The sprites of the objects are only drawn if the rasterizer has the pixels of their textures
+	void setRasterizer(SoftwareRasterizer* rasterizer);
+	// The draw functions of the objects and their effects skip the ones that are off screen, see printLayerStats()
+	void drawObjects(const MovableObjects& objects);
+	// Draws the sprites a texture at a time and all glows with one call, or ring by ring with drawObjectsFadingOutLines()
+	// if the glow atlas couldn't be created
+	void drawObjectsFadingOut(const ObjectsPendingDeletion& objects);
+	void drawObjectsFadingOutLines(const ObjectsPendingDeletion& objects);
 	void drawCircles(float x, float y, float radius);
-	void drawBeatCircles(MusicData* music, std::vector<Position> positions, std::vector<Tag> tags, size_t playerIndex);
-	void drawLasers(std::vector<Laser> lasers, std::vector<Position> positions, Position playerPos);
-	void drawHealthLine(MusicData* musicData, int playerHealth);
-	void drawStars(MusicData* music, std::vector<Star> starList, float elapsedTime);
+	// Draws the hexagons around every object but the player with one draw call, sorted by the note they show.
+	// drawBeatCircleLines() draws them object by object, the way they used to be
+	void drawBeatCircles(const MusicData* music, const MovableObjects& objects, size_t playerIndex);
+	void drawBeatCircleLines(const MusicData* music, const MovableObjects& objects, size_t playerIndex);
+	// Draws all lasers with one draw call, or line by line with drawLaserLines() if the beam texture couldn't be created
+	void drawLasers(const Lasers& lasers, Position playerPos);
+	void drawLaserLines(const Lasers& lasers, Position playerPos);
+	void drawHealthLine(const MusicData* musicData, int playerHealth);
+	// Pre-renders the star glyphs, the beam texture of the lasers and the glows of the objects fading out.
+	// Until then, or if it fails, stars are drawn as filled triangles and the rest line by line
+	bool loadGeneratedTextures();
+	void unloadGeneratedTextures();
+	// Works out how every star looks this frame, call it once before drawStars()
+	void updateStars(const MusicData* music, const Stars& stars, float elapsedTime);
+	// Draws all stars with one draw call
+	void drawStars(const Stars& stars);
 	void drawHexagon(float x, float y, float radius, float offset);
 	void drawHexagon(float x, float y, float radius);
 	void drawBackground();
 	void renderPresent();
 	void renderClear();
+
+	// Adds the time since <startTicks> to <layer>, and returns the current ticks for the next layer.
+	// It's the time it took to submit the draw calls, the GPU does the actual work later
+	Uint64 endLayer(Layer layer, Uint64 startTicks);
+	// With how many objects the layers that cull them drew and skipped per frame, and how long each detail level was used
+	void printLayerStats();
+
+	// Lowers or raises the detail of the beat circles, the glows and the lasers (see DetailController),
+	// call it once per frame with the time the frame took and the number of objects, fading objects and lasers
+	void updateDetail(float frameMilliseconds, size_t objectCount);
+	Detail getDetail();
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+#include "softwareRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include <iostream>
+#include <SDL_image.h>
+#include "easingFunctions.h"
+
+namespace
+{
+	// how far the coverage of a line reaches out of its middle, half its width and the half pixel it fades over
+	constexpr float LINE_REACH = 1.f;
+
+	Uint32 pack(SDL_Color color)
+	{
+		return color.r | color.g << 8 | color.b << 16 | static_cast<Uint32>(color.a) << 24;
+	}
+
+	__m128 clamp(__m128 values, __m128 low, __m128 high)
+	{
+		return _mm_min_ps(_mm_max_ps(values, low), high);
+	}
+
+	// Bilinear, clamped to the edges. <u> and <v> are in texels, from the center of the first one
+	void sample(const SoftwareRasterizer::Texture& texture, float u, float v, float texel[4])
+	{
+		u = std::clamp(u, 0.f, texture.width - 1.f);
+		v = std::clamp(v, 0.f, texture.height - 1.f);
+		const int x0 = static_cast<int>(u);
+		const int y0 = static_cast<int>(v);
+		const int x1 = (std::min)(x0 + 1, texture.width - 1);
+		const int y1 = (std::min)(y0 + 1, texture.height - 1);
+		const float fractionX = u - x0;
+		const float fractionY = v - y0;
+
+		const Uint8* topLeft = texture.pixels + (y0 * texture.width + x0) * 4;
+		const Uint8* topRight = texture.pixels + (y0 * texture.width + x1) * 4;
+		const Uint8* bottomLeft = texture.pixels + (y1 * texture.width + x0) * 4;
+		const Uint8* bottomRight = texture.pixels + (y1 * texture.width + x1) * 4;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			const float top = topLeft[channel] + (topRight[channel] - topLeft[channel]) * fractionX;
+			const float bottom = bottomLeft[channel] + (bottomRight[channel] - bottomLeft[channel]) * fractionX;
+			texel[channel] = top + (bottom - top) * fractionY;
+		}
+	}
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, int threadCount) : width(width), height(height), stride((width + 3) & ~3),
+	pixels(static_cast<size_t>(stride) * height), tilesAcross((width + TILE_SIZE - 1) / TILE_SIZE), tilesDown((height + TILE_SIZE - 1) / TILE_SIZE),
+	tileCommands(static_cast<size_t>(tilesAcross) * tilesDown)
+{
+	for (int i = 1; i < threadCount; i++)
+	{
+		workers.emplace_back(&SoftwareRasterizer::run, this);
+	}
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard lock(mutex);
+		isQuitting = true;
+	}
+	workReady.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void SoftwareRasterizer::clear(SDL_Color color)
+{
+	commands.clear();
+	for (std::vector<int>& tile : tileCommands)
+	{
+		tile.clear();
+	}
+	hasClear = true;
+	clearColor = color;
+}
+
+// Adds <command> to the tiles that the rectangle from <minX>, <minY> to <maxX>, <maxY> touches
+void SoftwareRasterizer::addCommand(Command& command, float minX, float minY, float maxX, float maxY)
+{
+	command.left = static_cast<int>(std::clamp(std::floor(minX), 0.f, static_cast<float>(width)));
+	command.top = static_cast<int>(std::clamp(std::floor(minY), 0.f, static_cast<float>(height)));
+	command.right = static_cast<int>(std::clamp(std::ceil(maxX) + 1, 0.f, static_cast<float>(width)));
+	command.bottom = static_cast<int>(std::clamp(std::ceil(maxY) + 1, 0.f, static_cast<float>(height)));
+	if (command.left >= command.right || command.top >= command.bottom) return;
+
+	const int index = static_cast<int>(commands.size());
+	commands.push_back(command);
+	for (int tileY = command.top / TILE_SIZE; tileY <= (command.bottom - 1) / TILE_SIZE; tileY++)
+	{
+		for (int tileX = command.left / TILE_SIZE; tileX <= (command.right - 1) / TILE_SIZE; tileX++)
+		{
+			tileCommands[tileY * tilesAcross + tileX].push_back(index);
+		}
+	}
+}
+
+void SoftwareRasterizer::addTriangle(const Texture* texture, const SDL_Vertex& v0, const SDL_Vertex& v1, const SDL_Vertex& v2)
+{
+	const SDL_Vertex* vertices[3] = { &v0, &v1, &v2 };
+	const SDL_FPoint& p0 = v0.position;
+	const SDL_FPoint& p1 = v1.position;
+	const SDL_FPoint& p2 = v2.position;
+	const float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+	// also leaves out the ones with a NaN in them
+	if (!(std::abs(area) > 1e-6f)) return;
+	const float sign = area > 0 ? 1.f : -1.f;
+
+	Command command{};
+	command.kind = Kind::Triangle;
+	command.edgeCount = 3;
+	// the edge across from each vertex, positive toward it. A triangle next to this one has the same edge
+	// negated exactly, so a pixel on it is filled by one of them and not both, see drawTile()
+	for (int i = 0; i < 3; i++)
+	{
+		const SDL_FPoint& a = vertices[(i + 1) % 3]->position;
+		const SDL_FPoint& b = vertices[(i + 2) % 3]->position;
+		command.edges[i] = { sign * (a.y - b.y), sign * (b.x - a.x), sign * (b.y * a.x - b.x * a.y) };
+	}
+
+	// every attribute is a plane, the vertices' values weighted by how close to each vertex a pixel is
+	const auto interpolate = [&](float value0, float value1, float value2)
+	{
+		const float values[3] = { value0, value1, value2 };
+		Plane plane;
+		for (int i = 0; i < 3; i++)
+		{
+			const float weight = values[i] / std::abs(area);
+			plane.a += command.edges[i].a * weight;
+			plane.b += command.edges[i].b * weight;
+			plane.c += command.edges[i].c * weight;
+		}
+		return plane;
+	};
+	command.color[0] = interpolate(v0.color.r, v1.color.r, v2.color.r);
+	command.color[1] = interpolate(v0.color.g, v1.color.g, v2.color.g);
+	command.color[2] = interpolate(v0.color.b, v1.color.b, v2.color.b);
+	command.color[3] = interpolate(v0.color.a, v1.color.a, v2.color.a);
+	if (texture != nullptr)
+	{
+		command.texture = *texture;
+		const auto texels = [](float coordinate, int size) { return coordinate * size - 0.5f; };
+		command.u = interpolate(texels(v0.tex_coord.x, texture->width), texels(v1.tex_coord.x, texture->width), texels(v2.tex_coord.x, texture->width));
+		command.v = interpolate(texels(v0.tex_coord.y, texture->height), texels(v1.tex_coord.y, texture->height), texels(v2.tex_coord.y, texture->height));
+	}
+
+	addCommand(command, (std::min)({ p0.x, p1.x, p2.x }), (std::min)({ p0.y, p1.y, p2.y }), (std::max)({ p0.x, p1.x, p2.x }), (std::max)({ p0.y, p1.y, p2.y }));
+}
+
+void SoftwareRasterizer::drawGeometry(const Texture* texture, const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount)
+{
+	if (texture != nullptr && (texture->pixels == nullptr || texture->width <= 0 || texture->height <= 0))
+		texture = nullptr;
+
+	const int count = indices != nullptr ? indexCount : vertexCount;
+	for (int i = 0; i + 2 < count; i += 3)
+	{
+		const int a = indices != nullptr ? indices[i] : i;
+		const int b = indices != nullptr ? indices[i + 1] : i + 1;
+		const int c = indices != nullptr ? indices[i + 2] : i + 2;
+		if ((std::min)({ a, b, c }) < 0 || (std::max)({ a, b, c }) >= vertexCount) continue;
+		addTriangle(texture, vertices[a], vertices[b], vertices[c]);
+	}
+}
+
+void SoftwareRasterizer::drawLine(float x1, float y1, float x2, float y2, SDL_Color color)
+{
+	if (!std::isfinite(x1 + y1 + x2 + y2)) return;
+	// SDL draws through the pixels the coordinates are in, so the line goes through their centers
+	x1 += 0.5f;
+	y1 += 0.5f;
+	x2 += 0.5f;
+	y2 += 0.5f;
+
+	float directionX = x2 - x1;
+	float directionY = y2 - y1;
+	float length = std::sqrt(directionX * directionX + directionY * directionY);
+	if (length > 1e-4f)
+	{
+		directionX /= length;
+		directionY /= length;
+	}
+	else
+	{
+		// a dot
+		directionX = 1;
+		directionY = 0;
+		length = 0;
+	}
+
+	Command command{};
+	command.kind = Kind::Line;
+	command.edgeCount = 4;
+	command.along = { directionX, directionY, -(directionX * x1 + directionY * y1) };
+	command.across = { -directionY, directionX, directionY * x1 - directionX * y1 };
+	command.length = length;
+	// the rectangle around the line that its coverage reaches into
+	command.edges[0] = { command.along.a, command.along.b, command.along.c + LINE_REACH };
+	command.edges[1] = { -command.along.a, -command.along.b, length + LINE_REACH - command.along.c };
+	command.edges[2] = { command.across.a, command.across.b, command.across.c + LINE_REACH };
+	command.edges[3] = { -command.across.a, -command.across.b, LINE_REACH - command.across.c };
+	command.color[0] = { 0, 0, static_cast<float>(color.r) };
+	command.color[1] = { 0, 0, static_cast<float>(color.g) };
+	command.color[2] = { 0, 0, static_cast<float>(color.b) };
+	command.color[3] = { 0, 0, static_cast<float>(color.a) };
+
+	addCommand(command, (std::min)(x1, x2) - LINE_REACH, (std::min)(y1, y2) - LINE_REACH, (std::max)(x1, x2) + LINE_REACH, (std::max)(y1, y2) + LINE_REACH);
+}
+
+void SoftwareRasterizer::drawSprite(const Texture& texture, const SDL_FRect& destination, float angle, SDL_Color color)
+{
+	const float radians = angle * PI / 180;
+	const float cosine = std::cos(radians);
+	const float sine = std::sin(radians);
+	const float centerX = destination.x + destination.w / 2;
+	const float centerY = destination.y + destination.h / 2;
+
+	SDL_Vertex vertices[4];
+	for (int i = 0; i < 4; i++)
+	{
+		const float u = static_cast<float>(i % 2);
+		const float v = static_cast<float>(i / 2);
+		const float x = (u - 0.5f) * destination.w;
+		const float y = (v - 0.5f) * destination.h;
+		vertices[i] = SDL_Vertex{ { centerX + x * cosine - y * sine, centerY + x * sine + y * cosine }, color, { u, v } };
+	}
+	const int indices[6] = { 0, 1, 2, 2, 1, 3 };
+	drawGeometry(&texture, vertices, 4, indices, 6);
+}
+
+// Blends <command> over the pixels from <x> to <end> of <row>
+void SoftwareRasterizer::fillSpan(const Command& command, Uint32* row, int x, int end, float centerY) const
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 maxChannel = _mm_set1_ps(255.f);
+	const __m128 toUnit = _mm_set1_ps(1.f / 255);
+	const __m128 laneCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i channelMask = _mm_set1_epi32(0xFF);
+	const __m128i first = _mm_set1_epi32(x - 1);
+	const __m128i last = _mm_set1_epi32(end);
+	const bool isTextured = command.kind == Kind::Triangle && command.texture.pixels != nullptr;
+	// the value of <plane> at the centers of the four pixels in <centerXs>
+	const auto evaluate = [centerY](const Plane& plane, __m128 centerXs)
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), centerXs), _mm_set1_ps(plane.b * centerY + plane.c));
+	};
+
+	// four pixels at a time, starting at a multiple of four so they never reach into another tile
+	for (x &= ~3; x < end; x += 4)
+	{
+		// the pixels outside the span are written back as they were
+		const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), laneOffsets);
+		const __m128i isInside = _mm_and_si128(_mm_cmpgt_epi32(lanes, first), _mm_cmplt_epi32(lanes, last));
+		const __m128 centerXs = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneCenters);
+
+		__m128 red = evaluate(command.color[0], centerXs);
+		__m128 green = evaluate(command.color[1], centerXs);
+		__m128 blue = evaluate(command.color[2], centerXs);
+		__m128 alpha = evaluate(command.color[3], centerXs);
+
+		if (isTextured)
+		{
+			alignas(16) float us[4];
+			alignas(16) float vs[4];
+			alignas(16) float texels[4][4]; // channel, lane
+			_mm_store_ps(us, evaluate(command.u, centerXs));
+			_mm_store_ps(vs, evaluate(command.v, centerXs));
+			for (int lane = 0; lane < 4; lane++)
+			{
+				float texel[4];
+				sample(command.texture, us[lane], vs[lane], texel);
+				for (int channel = 0; channel < 4; channel++)
+				{
+					texels[channel][lane] = texel[channel];
+				}
+			}
+			// the vertex color tints the texture, like SDL_RenderGeometry()
+			red = _mm_mul_ps(red, _mm_mul_ps(_mm_load_ps(texels[0]), toUnit));
+			green = _mm_mul_ps(green, _mm_mul_ps(_mm_load_ps(texels[1]), toUnit));
+			blue = _mm_mul_ps(blue, _mm_mul_ps(_mm_load_ps(texels[2]), toUnit));
+			alpha = _mm_mul_ps(alpha, _mm_mul_ps(_mm_load_ps(texels[3]), toUnit));
+		}
+		else if (command.kind == Kind::Line)
+		{
+			// fades out over the pixel around its edges, the pixels at its ends are drawn whole like SDL does
+			const __m128 across = evaluate(command.across, centerXs);
+			const __m128 along = evaluate(command.along, centerXs);
+			const __m128 distance = _mm_andnot_ps(_mm_set1_ps(-0.f), across);
+			__m128 coverage = clamp(_mm_sub_ps(one, distance), zero, one);
+			coverage = _mm_mul_ps(coverage, clamp(_mm_add_ps(along, one), zero, one));
+			coverage = _mm_mul_ps(coverage, clamp(_mm_sub_ps(_mm_set1_ps(command.length + 1), along), zero, one));
+			alpha = _mm_mul_ps(alpha, coverage);
+		}
+		alpha = clamp(alpha, zero, maxChannel);
+
+		Uint32* pixels = row + x;
+		const __m128i destination = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		const __m128 destinationRed = _mm_cvtepi32_ps(_mm_and_si128(destination, channelMask));
+		const __m128 destinationGreen = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(destination, 8), channelMask));
+		const __m128 destinationBlue = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(destination, 16), channelMask));
+		const __m128 destinationAlpha = _mm_cvtepi32_ps(_mm_srli_epi32(destination, 24));
+
+		// SDL_BLENDMODE_BLEND
+		const __m128 sourceAlpha = _mm_mul_ps(alpha, toUnit);
+		const __m128 remaining = _mm_sub_ps(one, sourceAlpha);
+		const auto blend = [&](__m128 source, __m128 target)
+		{
+			const __m128 blended = _mm_add_ps(_mm_mul_ps(source, sourceAlpha), _mm_mul_ps(target, remaining));
+			return _mm_cvtps_epi32(clamp(blended, zero, maxChannel));
+		};
+		const __m128i outRed = blend(red, destinationRed);
+		const __m128i outGreen = blend(green, destinationGreen);
+		const __m128i outBlue = blend(blue, destinationBlue);
+		const __m128i outAlpha = _mm_cvtps_epi32(clamp(_mm_add_ps(alpha, _mm_mul_ps(destinationAlpha, remaining)), zero, maxChannel));
+
+		__m128i result = _mm_or_si128(_mm_or_si128(outRed, _mm_slli_epi32(outGreen, 8)), _mm_or_si128(_mm_slli_epi32(outBlue, 16), _mm_slli_epi32(outAlpha, 24)));
+		result = _mm_or_si128(_mm_and_si128(isInside, result), _mm_andnot_si128(isInside, destination));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), result);
+	}
+}
+
+void SoftwareRasterizer::drawTile(int tile)
+{
+	const int tileLeft = tile % tilesAcross * TILE_SIZE;
+	const int tileTop = tile / tilesAcross * TILE_SIZE;
+	const int tileRight = (std::min)(tileLeft + TILE_SIZE, width);
+	const int tileBottom = (std::min)(tileTop + TILE_SIZE, height);
+
+	if (hasClear)
+	{
+		const Uint32 color = pack(clearColor);
+		for (int y = tileTop; y < tileBottom; y++)
+		{
+			std::fill(pixels.begin() + static_cast<size_t>(y) * stride + tileLeft, pixels.begin() + static_cast<size_t>(y) * stride + tileRight, color);
+		}
+	}
+
+	for (const int index : tileCommands[tile])
+	{
+		const Command& command = commands[index];
+		const int top = (std::max)(command.top, tileTop);
+		const int bottom = (std::min)(command.bottom, tileBottom);
+		const float left = static_cast<float>((std::max)(command.left, tileLeft));
+		const float right = static_cast<float>((std::min)(command.right, tileRight));
+
+		for (int y = top; y < bottom; y++)
+		{
+			// the span of pixel centers inside every edge. A pixel exactly on an edge is filled if the edge is to its left,
+			// or above it if the edge is level, so of two triangles that share an edge only one of them fills it
+			const float centerY = y + 0.5f;
+			float start = left;
+			float end = right;
+			for (int i = 0; i < command.edgeCount; i++)
+			{
+				const Plane& edge = command.edges[i];
+				const float rest = edge.b * centerY + edge.c;
+				if (edge.a > 0)
+					start = (std::max)(start, std::ceil(-rest / edge.a - 0.5f));
+				else if (edge.a < 0)
+					end = (std::min)(end, std::ceil(rest / -edge.a - 0.5f));
+				else if (rest < 0 || (rest == 0 && edge.b <= 0))
+					end = start;
+			}
+			if (!(start < end)) continue;
+
+			fillSpan(command, pixels.data() + static_cast<size_t>(y) * stride, static_cast<int>(start), static_cast<int>(end), centerY);
+		}
+	}
+}
+
+void SoftwareRasterizer::drawTiles()
+{
+	const int tileCount = tilesAcross * tilesDown;
+	for (int tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1))
+	{
+		drawTile(tile);
+	}
+}
+
+// Runs on the worker threads, draws tiles until there are none left for every flush()
+void SoftwareRasterizer::run()
+{
+	Uint64 seenGeneration = 0;
+	std::unique_lock lock(mutex);
+	while (true)
+	{
+		workReady.wait(lock, [&] { return isQuitting || generation != seenGeneration; });
+		if (isQuitting) return;
+		seenGeneration = generation;
+
+		lock.unlock();
+		drawTiles();
+		lock.lock();
+
+		if (--busyWorkers == 0)
+			workDone.notify_one();
+	}
+}
+
+void SoftwareRasterizer::flush()
+{
+	if (!hasClear && commands.empty()) return;
+
+	nextTile = 0;
+	if (!workers.empty())
+	{
+		{
+			std::lock_guard lock(mutex);
+			generation++;
+			busyWorkers = static_cast<int>(workers.size());
+		}
+		workReady.notify_all();
+	}
+	drawTiles();
+	if (!workers.empty())
+	{
+		std::unique_lock lock(mutex);
+		workDone.wait(lock, [this] { return busyWorkers == 0; });
+	}
+
+	commands.clear();
+	for (std::vector<int>& tile : tileCommands)
+	{
+		tile.clear();
+	}
+	hasClear = false;
+}
+
+void SoftwareRasterizer::setTexture(AssetCache::TextureHandle handle, const Texture& texture)
+{
+	textures[handle] = texture;
+}
+
+const SoftwareRasterizer::Texture* SoftwareRasterizer::getTexture(AssetCache::TextureHandle handle) const
+{
+	const auto texture = textures.find(handle);
+	return texture != textures.end() ? &texture->second : nullptr;
+}
+
+int SoftwareRasterizer::getWidth() const
+{
+	return width;
+}
+
+int SoftwareRasterizer::getHeight() const
+{
+	return height;
+}
+
+int SoftwareRasterizer::getThreadCount() const
+{
+	return static_cast<int>(workers.size()) + 1;
+}
+
+const Uint32* SoftwareRasterizer::getPixels() const
+{
+	return pixels.data();
+}
+
+int SoftwareRasterizer::getStride() const
+{
+	return stride;
+}
+
+bool SoftwareRasterizer::savePNG(const char* path) const
+{
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint32*>(pixels.data()), width, height, 32, stride * 4, SDL_PIXELFORMAT_RGBA32);
+	if (surface == nullptr || IMG_SavePNG(surface, path) != 0)
+	{
+		std::cout << "Failed to save the frame to " << path << "! SDL Error: " << SDL_GetError() << std::endl;
+		SDL_FreeSurface(surface);
+		return false;
+	}
+	SDL_FreeSurface(surface);
+	return true;
+}
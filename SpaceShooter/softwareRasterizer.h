@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+#include "assetCache.h"
+
+/// <summary>
+/// Draws the game's primitives (triangles with or without a texture, anti-aliased lines and turned,
+/// tinted sprites) into a framebuffer in memory, so frames can be drawn and timed without a GPU or a window.
+/// Rendering draws into it instead of the SDL renderer after Rendering::setRasterizer().
+///
+/// The draw calls are only recorded, flush() does the work. The screen is split into tiles of TILE_SIZE pixels,
+/// every primitive is added to the tiles its bounds touch, and the tiles are drawn by a pool of threads,
+/// each tile by one of them. Inside a tile a primitive is filled row by row: the span of the row it covers
+/// is worked out from its edges, and then filled four pixels at a time with SSE.
+///
+/// Every pixel goes through the same steps in the same order however many threads there are,
+/// so a frame comes out exactly the same every time.
+/// </summary>
+struct SoftwareRasterizer
+{
+	static constexpr int TILE_SIZE = 64; // in pixels, a multiple of 4 so no four pixels are in two tiles
+
+	// RGBA32 pixels, not premultiplied, sampled linearly like the SDL_ScaleModeLinear textures the batches upload
+	struct Texture
+	{
+		const Uint8* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+	};
+
+private:
+	// a * x + b * y + c, at the center of a pixel
+	struct Plane
+	{
+		float a = 0;
+		float b = 0;
+		float c = 0;
+	};
+
+	enum class Kind : Uint8 { Triangle, Line };
+
+	struct Command
+	{
+		Kind kind;
+		int edgeCount;
+		Plane edges[4]; // the pixels inside are where all of them are >= 0
+		Plane color[4]; // 0 - 255
+		// a triangle's texture coordinates, in texels
+		Plane u;
+		Plane v;
+		Texture texture;
+		// a line's distance from its middle and along it, in pixels
+		Plane across;
+		Plane along;
+		float length;
+		int left, top, right, bottom; // the pixels it can touch, right and bottom excluded
+	};
+
+	int width;
+	int height;
+	int stride; // in pixels, rounded up to four
+	std::vector<Uint32> pixels; // RGBA32
+	int tilesAcross;
+	int tilesDown;
+
+	std::vector<Command> commands;
+	std::vector<std::vector<int>> tileCommands; // indices into commands, in the order they were drawn
+	bool hasClear = false;
+	SDL_Color clearColor{};
+
+	std::unordered_map<AssetCache::TextureHandle, Texture> textures;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	Uint64 generation = 0; // guarded by mutex, counts the flushes the workers were woken for
+	int busyWorkers = 0; // guarded by mutex
+	bool isQuitting = false; // guarded by mutex
+	std::atomic<int> nextTile = 0;
+
+	void addCommand(Command& command, float minX, float minY, float maxX, float maxY);
+	void addTriangle(const Texture* texture, const SDL_Vertex& v0, const SDL_Vertex& v1, const SDL_Vertex& v2);
+	void drawTiles();
+	void drawTile(int tile);
+	void fillSpan(const Command& command, Uint32* row, int x, int end, float centerY) const;
+	void run();
+
+public:
+	// <threadCount> includes the thread calling flush(), with 1 it does all the work
+	SoftwareRasterizer(int width, int height, int threadCount);
+	~SoftwareRasterizer();
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+	// Fills the frame with <color>, the draw calls before it are dropped
+	void clear(SDL_Color color);
+	// Like SDL_RenderGeometry(), blended. Without <indices> every three vertices are a triangle.
+	// The texture pixels have to stay valid until flush()
+	void drawGeometry(const Texture* texture, const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount);
+	// A one pixel wide line, anti-aliased, ends included
+	void drawLine(float x1, float y1, float x2, float y2, SDL_Color color);
+	// <texture> stretched over <destination>, turned around its center by <angle> degrees clockwise like SDL_RenderCopyEx()
+	void drawSprite(const Texture& texture, const SDL_FRect& destination, float angle, SDL_Color color);
+	// Draws everything since the last flush() into the frame
+	void flush();
+
+	// The pixels of the sprites that are drawn with the texture <handle>, the AssetCache textures are on the GPU
+	void setTexture(AssetCache::TextureHandle handle, const Texture& texture);
+	// nullptr if no pixels were set for <handle>
+	const Texture* getTexture(AssetCache::TextureHandle handle) const;
+
+	int getWidth() const;
+	int getHeight() const;
+	int getThreadCount() const;
+	// The frame as of the last flush(), getStride() pixels apart per row
+	const Uint32* getPixels() const;
+	int getStride() const;
+	bool savePNG(const char* path) const;
+};
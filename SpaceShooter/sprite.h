@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL_image.h>
+#include "assetCache.h"
 
 /// <summary>
 /// This is mainly used for single immovable things like screen overlays
@@ -11,6 +12,7 @@ struct Sprite
 	int width, height;
 	int scaleOffset = 0;
 	SDL_Texture* texture;
+	AssetCache::TextureHandle handle = AssetCache::INVALID_TEXTURE;
 	const char* path;
 	SDL_Renderer* renderer;
 
@@ -0,0 +1,139 @@
+#include "starAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "easingFunctions.h"
+#include "starBatch.h"
+
+namespace
+{
+	constexpr float LINE_WIDTH = 1.f; // in pixels, the width SDL_RenderDrawLinesF() used to draw the stars with
+	constexpr int SUBSAMPLES = 4; // per axis, for the coverage of each pixel
+	constexpr float DEGREES_PER_ROTATION = 180.f / StarAtlas::ROTATIONS;
+
+	float distanceToSegment(float x, float y, SDL_FPoint start, SDL_FPoint end)
+	{
+		const float dx = end.x - start.x;
+		const float dy = end.y - start.y;
+		const float lengthSquared = dx * dx + dy * dy;
+		const float t = lengthSquared > 0 ? std::clamp(((x - start.x) * dx + (y - start.y) * dy) / lengthSquared, 0.f, 1.f) : 0.f;
+		const float closestX = start.x + t * dx - x;
+		const float closestY = start.y + t * dy - y;
+		return std::sqrt(closestX * closestX + closestY * closestY);
+	}
+
+	// Draws the outlines of both triangles of a star, centered in the cell at <cellX>, <cellY>
+	void rasterizeGlyph(std::vector<Uint8>& pixels, int cellX, int cellY, float size, float angleInDegrees)
+	{
+		const float angle = angleInDegrees * (PI / 180);
+		const float cosAngle = std::cos(angle);
+		const float sinAngle = std::sin(angle);
+		const float center = StarAtlas::CELL_SIZE * 0.5f;
+
+		SDL_FPoint corners[StarBatch::VERTICES_PER_STAR];
+		for (int i = 0; i < StarBatch::VERTICES_PER_STAR; i++)
+		{
+			const SDL_FPoint& corner = StarBatch::UNIT_CORNERS[i];
+			corners[i] = SDL_FPoint{ center + (cosAngle * corner.x - sinAngle * corner.y) * size, center + (sinAngle * corner.x + cosAngle * corner.y) * size };
+		}
+
+		// the corners are at most 0.8 * size from the center, the pixels further out stay transparent
+		const float reach = 0.8f * size + LINE_WIDTH + 1;
+		for (int y = 0; y < StarAtlas::CELL_SIZE; y++)
+		{
+			for (int x = 0; x < StarAtlas::CELL_SIZE; x++)
+			{
+				if (std::abs(x + 0.5f - center) > reach || std::abs(y + 0.5f - center) > reach) continue;
+
+				int covered = 0;
+				for (int sample = 0; sample < SUBSAMPLES * SUBSAMPLES; sample++)
+				{
+					const float sampleX = x + (sample % SUBSAMPLES + 0.5f) / SUBSAMPLES;
+					const float sampleY = y + (sample / SUBSAMPLES + 0.5f) / SUBSAMPLES;
+					for (int edge = 0; edge < StarBatch::VERTICES_PER_STAR; edge++)
+					{
+						// three edges per triangle
+						const int triangle = edge / 3 * 3;
+						if (distanceToSegment(sampleX, sampleY, corners[edge], corners[triangle + (edge + 1) % 3]) <= LINE_WIDTH * 0.5f)
+						{
+							covered++;
+							break;
+						}
+					}
+				}
+
+				Uint8* pixel = pixels.data() + (static_cast<size_t>(cellY + y) * StarAtlas::ATLAS_WIDTH + cellX + x) * 4;
+				pixel[0] = pixel[1] = pixel[2] = 255;
+				pixel[3] = static_cast<Uint8>(covered * 255 / (SUBSAMPLES * SUBSAMPLES));
+			}
+		}
+	}
+}
+
+void StarAtlas::rasterize()
+{
+	pixels.assign(static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT * 4, 0);
+	for (int size = 1; size <= SIZES; size++)
+	{
+		for (int rotation = 0; rotation < ROTATIONS; rotation++)
+		{
+			rasterizeGlyph(pixels, rotation * CELL_SIZE, (size - 1) * CELL_SIZE, static_cast<float>(size), rotation * DEGREES_PER_ROTATION);
+		}
+	}
+}
+
+bool StarAtlas::createTexture(SDL_Renderer* renderer)
+{
+	if (texture != nullptr) return true;
+	if (!isRasterized())
+		rasterize();
+
+	texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, ATLAS_HEIGHT);
+	if (texture == nullptr || SDL_UpdateTexture(texture, nullptr, pixels.data(), ATLAS_WIDTH * 4) != 0)
+	{
+		std::cout << "Failed to create the star atlas! SDL Error: " << SDL_GetError() << std::endl;
+		destroy();
+		return false;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	// the stars are scaled down from the glyph one size up
+	SDL_SetTextureScaleMode(texture, SDL_ScaleModeLinear);
+	return true;
+}
+
+void StarAtlas::destroy()
+{
+	if (texture != nullptr)
+		SDL_DestroyTexture(texture);
+	texture = nullptr;
+}
+
+bool StarAtlas::isRasterized() const
+{
+	return !pixels.empty();
+}
+
+SDL_Texture* StarAtlas::getTexture() const
+{
+	return texture;
+}
+
+const Uint8* StarAtlas::getPixels() const
+{
+	return pixels.data();
+}
+
+int StarAtlas::getRotation(float elapsedTime) const
+{
+	float degrees = std::fmod(elapsedTime * StarBatch::DEGREES_PER_SECOND, 180.f);
+	if (degrees < 0) degrees += 180.f;
+	return static_cast<int>(std::lround(degrees / DEGREES_PER_ROTATION)) % ROTATIONS;
+}
+
+SDL_FRect StarAtlas::getGlyph(int rotation, int size) const
+{
+	return SDL_FRect{
+		static_cast<float>(rotation * CELL_SIZE) / ATLAS_WIDTH, static_cast<float>((size - 1) * CELL_SIZE) / ATLAS_HEIGHT,
+		static_cast<float>(CELL_SIZE) / ATLAS_WIDTH, static_cast<float>(CELL_SIZE) / ATLAS_HEIGHT
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+
+/// <summary>
+/// The outline of a star, pre-rendered at startup for every size and every step of its spin,
+/// so StarBatch can draw each star as one tinted quad of the atlas.
+///
+/// The glyphs are white, with the coverage of the lines in alpha, the vertex color tints them.
+/// A star looks the same turned upside down, so the rotations only cover half a turn.
+/// </summary>
+struct StarAtlas
+{
+	static constexpr int ROTATIONS = 32;
+	static constexpr int SIZES = 6; // glyphs of 1 - 6 pixels, the largest star World creates is 4
+	static constexpr int CELL_SIZE = 16; // in pixels, fits the largest glyph at any rotation
+	static constexpr int ATLAS_WIDTH = ROTATIONS * CELL_SIZE;
+	static constexpr int ATLAS_HEIGHT = SIZES * CELL_SIZE;
+
+private:
+	std::vector<Uint8> pixels; // RGBA32
+	SDL_Texture* texture = nullptr;
+
+public:
+	// Draws the glyphs into pixels, doesn't need a renderer
+	void rasterize();
+	// Rasterizes the glyphs if they aren't yet, and uploads them
+	bool createTexture(SDL_Renderer* renderer);
+	void destroy();
+
+	bool isRasterized() const;
+	SDL_Texture* getTexture() const;
+	const Uint8* getPixels() const;
+
+	// The rotation step the stars are at after <elapsedTime> seconds
+	int getRotation(float elapsedTime) const;
+	// The cell of the glyph with <rotation> and <size> (1 - SIZES pixels), in texture coordinates
+	SDL_FRect getGlyph(int rotation, int size) const;
+};
@@ -0,0 +1,247 @@
+#include "starBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include "easingFunctions.h"
+
+namespace
+{
+	constexpr float SHORT_STAR_FADE_IN_TIME = 0.04f;
+	constexpr int LONG_STAR_MIN_LIFETIME = 5; // in whole notes, shorter stars blink with the beat
+
+	// The beat multiplier of each lifetime (1 - 4 whole notes), longer lived stars don't blink
+	struct BeatMultipliers { float values[LONG_STAR_MIN_LIFETIME]; };
+
+	BeatMultipliers getBeatMultipliers(const StarBatch::FrameState& frame)
+	{
+		const float quarterNote = frame.quarterNoteProgress * 0.5f + 0.5f;
+		const float pulse = Ease::Out(frame.pulseMultiplier, 3);
+		return BeatMultipliers{ { 1.f, quarterNote, 1 - quarterNote, pulse, 1 - pulse } };
+	}
+
+	// One star, the reference for the SSE version below
+	void updateStar(const LifeTimeObject& life, float maxSize, float alpha, const StarBatch::FrameState& frame,
+		const BeatMultipliers& beat, float& sizeOut, float& alphaOut)
+	{
+		const int lifeTime = static_cast<int>(std::round(life.totalLifeTime));
+		const float normalizedLife = life.elapsedLifeTime / (frame.wholeNoteLength * life.totalLifeTime);
+		const float lifeLeft = 1 - normalizedLife;
+		const float lifeMultiplier = lifeLeft * lifeLeft; // 1 - Ease::Out(normalizedLife, 2)
+		const bool isLong = lifeTime >= LONG_STAR_MIN_LIFETIME;
+
+		if (!frame.musicIsPlaying)
+		{
+			sizeOut = maxSize;
+			alphaOut = std::clamp(alpha * lifeMultiplier, 0.f, 255.f);
+			return;
+		}
+
+		const float fadeInTime = isLong ? StarBatch::LONG_STAR_FADE_IN_TIME : SHORT_STAR_FADE_IN_TIME;
+		const float fadeInLeft = 1 - std::clamp(life.elapsedLifeTime / fadeInTime, 0.f, 1.f);
+		const float fadeInMultiplier = 1 - fadeInLeft * fadeInLeft;
+		const float beatMultiplier = lifeTime >= 1 && lifeTime <= 4 ? beat.values[lifeTime] : 1.f;
+
+		sizeOut = std::clamp(maxSize * lifeMultiplier, 1.f, maxSize) * fadeInMultiplier;
+		alphaOut = std::clamp(alpha * lifeMultiplier * beatMultiplier * fadeInMultiplier, 0.f, 255.f);
+	}
+
+	__m128 select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+	}
+}
+
+void StarBatch::prepare(const Stars& stars, const FrameState& frame)
+{
+	sizes.resize(stars.size());
+	alphas.resize(stars.size());
+
+	elapsedTime = frame.elapsedTime;
+	const float angle = frame.elapsedTime * DEGREES_PER_SECOND * (PI / 180);
+	const float cosAngle = std::cos(angle);
+	const float sinAngle = std::sin(angle);
+	for (int i = 0; i < VERTICES_PER_STAR; i++)
+	{
+		corners[i].x = cosAngle * UNIT_CORNERS[i].x - sinAngle * UNIT_CORNERS[i].y;
+		corners[i].y = sinAngle * UNIT_CORNERS[i].x + cosAngle * UNIT_CORNERS[i].y;
+	}
+}
+
+void StarBatch::updateScalar(const Stars& stars, const FrameState& frame)
+{
+	prepare(stars, frame);
+	const BeatMultipliers beat = getBeatMultipliers(frame);
+
+	size_t first = 0;
+	stars.forEachChunk<LifeTimeObject, StarShape, Color>([&](size_t count, const LifeTimeObject* lives, const StarShape* shapes, const Color* colors)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			updateStar(lives[i], shapes[i].maxSize, colors[i].a, frame, beat, sizes[first + i], alphas[first + i]);
+		}
+		first += count;
+	});
+}
+
+void StarBatch::update(const Stars& stars, const FrameState& frame)
+{
+	prepare(stars, frame);
+	const BeatMultipliers beat = getBeatMultipliers(frame);
+
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxAlpha = _mm_set1_ps(255.f);
+	const __m128 wholeNoteLength = _mm_set1_ps(frame.wholeNoteLength);
+	const __m128 longFadeInTime = _mm_set1_ps(LONG_STAR_FADE_IN_TIME);
+	const __m128 shortFadeInTime = _mm_set1_ps(SHORT_STAR_FADE_IN_TIME);
+	const __m128i shortestLongLifeTime = _mm_set1_epi32(LONG_STAR_MIN_LIFETIME - 1);
+
+	size_t first = 0;
+	stars.forEachChunk<LifeTimeObject, StarShape, Color>([&](size_t count, const LifeTimeObject* lives, const StarShape* shapes, const Color* colors)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			// the lifetimes are pairs of floats, shuffled apart into four totals and four elapsed times
+			const float* lifeFloats = reinterpret_cast<const float*>(lives + i);
+			const __m128 firstPair = _mm_loadu_ps(lifeFloats);
+			const __m128 secondPair = _mm_loadu_ps(lifeFloats + 4);
+			const __m128 total = _mm_shuffle_ps(firstPair, secondPair, _MM_SHUFFLE(2, 0, 2, 0));
+			const __m128 elapsed = _mm_shuffle_ps(firstPair, secondPair, _MM_SHUFFLE(3, 1, 3, 1));
+			const __m128 maxSize = _mm_set_ps(shapes[i + 3].maxSize, shapes[i + 2].maxSize, shapes[i + 1].maxSize, shapes[i].maxSize);
+			const __m128 alpha = _mm_set_ps(colors[i + 3].a, colors[i + 2].a, colors[i + 1].a, colors[i].a);
+
+			// the lifetimes are whole numbers, so rounding to even is the same as std::round()
+			const __m128i lifeTime = _mm_cvtps_epi32(total);
+			const __m128 isLong = _mm_castsi128_ps(_mm_cmpgt_epi32(lifeTime, shortestLongLifeTime));
+			const __m128 lifeLeft = _mm_sub_ps(one, _mm_div_ps(elapsed, _mm_mul_ps(wholeNoteLength, total)));
+			const __m128 lifeMultiplier = _mm_mul_ps(lifeLeft, lifeLeft);
+
+			__m128 size, starAlpha;
+			if (!frame.musicIsPlaying)
+			{
+				size = maxSize;
+				starAlpha = _mm_mul_ps(alpha, lifeMultiplier);
+			}
+			else
+			{
+				const __m128 fadeInTime = select(isLong, longFadeInTime, shortFadeInTime);
+				const __m128 fadeInLeft = _mm_sub_ps(one, _mm_min_ps(_mm_max_ps(_mm_div_ps(elapsed, fadeInTime), zero), one));
+				const __m128 fadeInMultiplier = _mm_sub_ps(one, _mm_mul_ps(fadeInLeft, fadeInLeft));
+
+				__m128 beatMultiplier = one;
+				for (int j = 1; j < LONG_STAR_MIN_LIFETIME; j++)
+				{
+					const __m128 isLifeTime = _mm_castsi128_ps(_mm_cmpeq_epi32(lifeTime, _mm_set1_epi32(j)));
+					beatMultiplier = select(isLifeTime, _mm_set1_ps(beat.values[j]), beatMultiplier);
+				}
+
+				size = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(maxSize, lifeMultiplier), one), maxSize), fadeInMultiplier);
+				starAlpha = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(alpha, lifeMultiplier), beatMultiplier), fadeInMultiplier);
+			}
+
+			_mm_storeu_ps(sizes.data() + first + i, size);
+			_mm_storeu_ps(alphas.data() + first + i, _mm_min_ps(_mm_max_ps(starAlpha, zero), maxAlpha));
+		}
+		for (; i < count; i++)
+		{
+			updateStar(lives[i], shapes[i].maxSize, colors[i].a, frame, beat, sizes[first + i], alphas[first + i]);
+		}
+		first += count;
+	});
+}
+
+int StarBatch::emit(const Stars& stars, const StarAtlas* atlas)
+{
+	const int verticesPerStar = atlas != nullptr ? VERTICES_PER_GLYPH : VERTICES_PER_STAR;
+	const size_t maxVertices = stars.size() * verticesPerStar;
+	if (vertices.size() < maxVertices)
+		vertices.resize(maxVertices);
+
+	// every star spins by the same angle, so the glyph of each size only has to be looked up once
+	SDL_FRect glyphs[StarAtlas::SIZES];
+	if (atlas != nullptr)
+	{
+		const int rotation = atlas->getRotation(elapsedTime);
+		for (int size = 0; size < StarAtlas::SIZES; size++)
+		{
+			glyphs[size] = atlas->getGlyph(rotation, size + 1);
+		}
+	}
+
+	SDL_Vertex* vertex = vertices.data();
+	size_t first = 0;
+	stars.forEachChunk<StarShape, Color>([&](size_t count, const StarShape* shapes, const Color* colors)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const size_t index = first + i;
+			const Uint8 alpha = static_cast<Uint8>(alphas[index]);
+			if (alpha == 0) continue;
+
+			const float size = sizes[index];
+			const SDL_Color color{ colors[i].r, colors[i].g, colors[i].b, alpha };
+			if (atlas != nullptr)
+			{
+				// the glyph that's one size up, scaled down to the star's size
+				const int glyphSize = std::clamp(static_cast<int>(std::ceil(size)), 1, StarAtlas::SIZES);
+				const SDL_FRect& glyph = glyphs[glyphSize - 1];
+				const float halfWidth = StarAtlas::CELL_SIZE * 0.5f * size / glyphSize;
+				const float left = shapes[i].x - halfWidth, right = shapes[i].x + halfWidth;
+				const float top = shapes[i].y - halfWidth, bottom = shapes[i].y + halfWidth;
+				vertex[0] = SDL_Vertex{ { left, top }, color, { glyph.x, glyph.y } };
+				vertex[1] = SDL_Vertex{ { right, top }, color, { glyph.x + glyph.w, glyph.y } };
+				vertex[2] = SDL_Vertex{ { left, bottom }, color, { glyph.x, glyph.y + glyph.h } };
+				vertex[3] = SDL_Vertex{ { right, bottom }, color, { glyph.x + glyph.w, glyph.y + glyph.h } };
+				vertex += VERTICES_PER_GLYPH;
+				continue;
+			}
+			for (int corner = 0; corner < VERTICES_PER_STAR; corner++, vertex++)
+			{
+				vertex->position = SDL_FPoint{ shapes[i].x + corners[corner].x * size, shapes[i].y + corners[corner].y * size };
+				vertex->color = color;
+				vertex->tex_coord = SDL_FPoint{ 0, 0 };
+			}
+		}
+		first += count;
+	});
+
+	const int vertexCount = static_cast<int>(vertex - vertices.data());
+	indexCount = 0;
+	if (atlas != nullptr)
+	{
+		const int glyphCount = vertexCount / VERTICES_PER_GLYPH;
+		for (int glyph = static_cast<int>(glyphIndices.size()) / INDICES_PER_GLYPH; glyph < glyphCount; glyph++)
+		{
+			const int corner = glyph * VERTICES_PER_GLYPH;
+			glyphIndices.insert(glyphIndices.end(), { corner, corner + 1, corner + 2, corner + 2, corner + 1, corner + 3 });
+		}
+		indexCount = glyphCount * INDICES_PER_GLYPH;
+	}
+	return vertexCount;
+}
+
+const SDL_Vertex* StarBatch::getVertices() const
+{
+	return vertices.data();
+}
+
+const int* StarBatch::getIndices() const
+{
+	return glyphIndices.data();
+}
+
+int StarBatch::getIndexCount() const
+{
+	return indexCount;
+}
+
+float StarBatch::getSize(size_t index) const
+{
+	return sizes[index];
+}
+
+float StarBatch::getAlpha(size_t index) const
+{
+	return alphas[index];
+}
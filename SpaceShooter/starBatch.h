@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "gameObject.h"
+#include "starAtlas.h"
+
+using namespace GameObject;
+
+/// <summary>
+/// Draws all stars as one batch of triangles, with a single SDL_RenderGeometry() call.
+///
+/// update() works out the size and alpha of every star for the frame (the beat, fade in and
+/// fade out multipliers that Rendering used to apply per star) four stars at a time with SSE,
+/// a chunk of the Stars storage at a time, into arrays of its own. emit() then writes two
+/// triangles per star. Every star spins by the same angle, so the corners of the triangles
+/// are only rotated once per frame, instead of once per vertex.
+///
+/// The triangles are filled, the stars are only a few pixels wide, so it's hard to tell from
+/// the outlines they used to be drawn with. With a StarAtlas, the outlines are pre-rendered instead,
+/// and every star is a single tinted quad.
+/// </summary>
+struct StarBatch
+{
+	// Everything the look of a star depends on, other than the star itself
+	struct FrameState
+	{
+		bool musicIsPlaying = false;
+		float wholeNoteLength = 2.f;
+		float quarterNoteProgress = 0;
+		float pulseMultiplier = 0;
+		float elapsedTime = 0; // how far the stars have spun
+	};
+
+	static constexpr float LONG_STAR_FADE_IN_TIME = 2.f;
+	static constexpr float DEGREES_PER_SECOND = 50.f; // how fast the stars spin
+	static constexpr int VERTICES_PER_STAR = 6;
+	static constexpr int VERTICES_PER_GLYPH = 4;
+	static constexpr int INDICES_PER_GLYPH = 6;
+
+	// The two triangles of a star with size 1, offset so they look like a star together, before it's spun around the center
+	static constexpr SDL_FPoint UNIT_CORNERS[VERTICES_PER_STAR] = {
+		{ -0.5f, -0.5f + 0.125f }, { 0.5f, -0.5f + 0.125f }, { 0.f, 0.5f + 0.125f }, // pointing downward
+		{ -0.5f, 0.5f - 0.125f }, { 0.5f, 0.5f - 0.125f }, { 0.f, -0.5f - 0.125f } // pointing upward
+	};
+
+private:
+	std::vector<float> sizes;
+	std::vector<float> alphas;
+	std::vector<SDL_Vertex> vertices; // only grows, emit() returns how many are in use
+	std::vector<int> glyphIndices; // two triangles per glyph quad, the same every frame
+	int indexCount = 0;
+	float elapsedTime = 0;
+	SDL_FPoint corners[VERTICES_PER_STAR] = {}; // of a star with size 1, rotated
+
+	void prepare(const Stars& stars, const FrameState& frame);
+
+public:
+	// Call once per frame, before emit()
+	void update(const Stars& stars, const FrameState& frame);
+	// The same without SSE, to compare against
+	void updateScalar(const Stars& stars, const FrameState& frame);
+
+	// Writes the visible stars, returns how many vertices were written. With an <atlas>,
+	// every star is one quad of the glyph closest to its size and the current spin, drawn with getIndices()
+	int emit(const Stars& stars, const StarAtlas* atlas = nullptr);
+	// Of the last emit(), valid until the next one. The indices are only used with an atlas
+	const SDL_Vertex* getVertices() const;
+	const int* getIndices() const;
+	int getIndexCount() const;
+
+	// Of the last update()
+	float getSize(size_t index) const;
+	float getAlpha(size_t index) const;
+};
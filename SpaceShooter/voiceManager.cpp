@@ -0,0 +1,109 @@
+#include "voiceManager.h"
+#include <algorithm>
+#include <iostream>
+#include "audioMixer.h"
+
+VoiceManager::VoiceManager()
+{
+	voices.resize(AudioMixer::getVoiceCount());
+}
+
+VoiceManager::SoundId VoiceManager::addSound(Mix_Chunk* chunk, int maxVoices, int priority)
+{
+	sounds.push_back(Sound{ chunk, (std::max)(maxVoices, 1), priority });
+	return static_cast<SoundId>(sounds.size() - 1);
+}
+
+void VoiceManager::play(SoundId soundId, int volume)
+{
+	if (soundId < 0 || soundId >= static_cast<SoundId>(sounds.size()) || sounds[soundId].chunk == nullptr) return;
+
+	Sound& sound = sounds[soundId];
+	if (sound.lastFrame == frame)
+	{
+		stats.coalesced++;
+		return;
+	}
+	sound.lastFrame = frame;
+
+	// one pass over the voices finds everything that's needed to pick one
+	const Uint32 playingVoices = AudioMixer::getPlayingVoices();
+	int freeVoice = -1;
+	int ownVoiceCount = 0;
+	int ownOldestVoice = -1;
+	int stealableVoice = -1;
+	for (int i = 0; i < static_cast<int>(voices.size()); i++)
+	{
+		const Voice& voice = voices[i];
+		if ((playingVoices & (1u << i)) == 0)
+		{
+			if (freeVoice < 0) freeVoice = i;
+			continue;
+		}
+		if (voice.sound == soundId)
+		{
+			ownVoiceCount++;
+			if (ownOldestVoice < 0 || voice.order < voices[ownOldestVoice].order)
+				ownOldestVoice = i;
+		}
+		if (stealableVoice < 0 || voice.priority < voices[stealableVoice].priority
+			|| (voice.priority == voices[stealableVoice].priority && voice.order < voices[stealableVoice].order))
+			stealableVoice = i;
+	}
+
+	int voiceIndex;
+	if (ownVoiceCount >= sound.maxVoices)
+	{
+		voiceIndex = ownOldestVoice;
+		stats.restarted++;
+	}
+	else if (freeVoice >= 0)
+	{
+		voiceIndex = freeVoice;
+	}
+	else if (stealableVoice >= 0 && voices[stealableVoice].priority <= sound.priority)
+	{
+		voiceIndex = stealableVoice;
+		stats.stolen++;
+	}
+	else
+	{
+		stats.dropped++;
+		return;
+	}
+
+	if (AudioMixer::playSound(sound.chunk, volume, voiceIndex) < 0)
+	{
+		stats.dropped++;
+		return;
+	}
+	voices[voiceIndex] = Voice{ soundId, sound.priority, ++playCount };
+	stats.played++;
+}
+
+bool VoiceManager::isPlaying(SoundId soundId) const
+{
+	const Uint32 playingVoices = AudioMixer::getPlayingVoices();
+	for (size_t i = 0; i < voices.size(); i++)
+	{
+		if (voices[i].sound == soundId && (playingVoices & (1u << i)) != 0)
+			return true;
+	}
+	return false;
+}
+
+void VoiceManager::nextFrame()
+{
+	frame++;
+}
+
+VoiceManager::Stats VoiceManager::getStats() const
+{
+	return stats;
+}
+
+void VoiceManager::printStats() const
+{
+	std::cout << "Sound effects: " << stats.played << " played, " << stats.coalesced << " coalesced, "
+		<< stats.restarted << " restarted, " << stats.stolen << " stolen, " << stats.dropped << " dropped" << std::endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <climits>
+#include <vector>
+#include <SDL_mixer.h>
+
+/// <summary>
+/// Picks the AudioMixer voice every sound effect is played on, so spamming one sound can't take over the mixer.
+/// - A sound has a polyphony limit, when it's reached the sound's own oldest voice is restarted
+/// - When every voice is busy, the lowest priority voice (the oldest of those) is stolen,
+///   unless it has a higher priority than the new sound, then the new sound is dropped
+/// - A sound that's triggered more than once in the same frame is only played once
+///
+/// Create it after the audio device is opened (see AudioMixer::open()).
+/// </summary>
+struct VoiceManager
+{
+	typedef int SoundId;
+	static constexpr SoundId INVALID_SOUND = -1;
+
+	struct Stats { Uint32 played; Uint32 coalesced; Uint32 restarted; Uint32 stolen; Uint32 dropped; };
+
+private:
+	struct Sound
+	{
+		Mix_Chunk* chunk = nullptr;
+		int maxVoices = 1;
+		int priority = 0;
+		Uint32 lastFrame = UINT32_MAX; // the frame it was last triggered in
+	};
+	struct Voice
+	{
+		SoundId sound = INVALID_SOUND;
+		int priority = INT_MAX; // voices that weren't played from here are never stolen
+		Uint32 order = 0; // higher is newer
+	};
+
+	std::vector<Sound> sounds;
+	std::vector<Voice> voices;
+	Uint32 frame = 0;
+	Uint32 playCount = 0;
+	Stats stats{};
+
+public:
+	VoiceManager();
+
+	// The manager doesn't own the chunk. Higher priorities steal voices from lower ones
+	SoundId addSound(Mix_Chunk* chunk, int maxVoices, int priority);
+	void play(SoundId sound, int volume);
+	bool isPlaying(SoundId sound) const;
+	// Call once per frame, triggers are coalesced within a frame
+	void nextFrame();
+
+	Stats getStats() const;
+	void printStats() const;
+};
@@ -0,0 +1,147 @@
+#include "wavReader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+template<typename T>
+bool readValue(std::ifstream& file, T& value)
+{
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool WavReader::open(const std::string& path)
+{
+	close();
+	file.open(path, std::ios::binary);
+	char id[4];
+	Uint32 size;
+	if (!file.read(id, 4) || std::memcmp(id, "RIFF", 4) != 0 || !readValue(file, size) || !file.read(id, 4) || std::memcmp(id, "WAVE", 4) != 0)
+	{
+		std::cout << "Failed to open WAV file at: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	// finds the format, then stops at the start of the data chunk
+	Uint16 format = 0, channelCount = 0, bitsPerSample = 0;
+	Uint32 rate = 0, dataSize = 0;
+	while (file.read(id, 4) && readValue(file, size))
+	{
+		if (std::memcmp(id, "fmt ", 4) == 0)
+		{
+			std::vector<char> chunk(size);
+			if (size < 16 || !file.read(chunk.data(), size)) break;
+			std::memcpy(&format, chunk.data(), 2);
+			std::memcpy(&channelCount, chunk.data() + 2, 2);
+			std::memcpy(&rate, chunk.data() + 4, 4);
+			std::memcpy(&bitsPerSample, chunk.data() + 14, 2);
+			// WAVE_FORMAT_EXTENSIBLE keeps the real format at the start of its sub format GUID
+			if (format == 0xFFFE && size >= 26)
+				std::memcpy(&format, chunk.data() + 24, 2);
+			if (size & 1) file.ignore(1);
+		}
+		else if (std::memcmp(id, "data", 4) == 0)
+		{
+			dataSize = size;
+			break;
+		}
+		else
+		{
+			file.ignore(size + (size & 1));
+		}
+	}
+
+	const bool isPCM = format == 1 && (bitsPerSample == 16 || bitsPerSample == 24);
+	isFloat = format == 3 && bitsPerSample == 32;
+	if (dataSize == 0 || channelCount == 0 || rate == 0 || (!isPCM && !isFloat))
+	{
+		std::cout << "Unsupported WAV file (16/24-bit PCM or 32-bit float only) at: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	channels = channelCount;
+	sampleRate = static_cast<int>(rate);
+	bytesPerSample = bitsPerSample / 8;
+	frameCount = dataSize / (bytesPerSample * channels);
+	framesLeft = frameCount;
+	dataStart = file.tellg();
+	return true;
+}
+
+void WavReader::close()
+{
+	if (file.is_open())
+		file.close();
+	file.clear();
+	frameCount = 0;
+	framesLeft = 0;
+	channels = 0;
+}
+
+int WavReader::read(float* samples, int maxFrames)
+{
+	if (!isOpen() || maxFrames <= 0) return 0;
+
+	const int frameBytes = bytesPerSample * channels;
+	const int frames = static_cast<int>((std::min)(framesLeft, static_cast<Sint64>(maxFrames)));
+	raw.resize(static_cast<size_t>(frames) * frameBytes);
+	if (frames == 0 || !file.read(raw.data(), static_cast<std::streamsize>(raw.size())))
+	{
+		framesLeft = 0;
+		return 0;
+	}
+	framesLeft -= frames;
+
+	const char* bytes = raw.data();
+	const int sampleCount = frames * channels;
+	for (int i = 0; i < sampleCount; i++, bytes += bytesPerSample)
+	{
+		if (isFloat)
+		{
+			std::memcpy(&samples[i], bytes, 4);
+		}
+		else if (bytesPerSample == 2)
+		{
+			Sint16 value;
+			std::memcpy(&value, bytes, 2);
+			samples[i] = value / 32768.f;
+		}
+		else
+		{
+			const Sint32 value = static_cast<Sint32>(static_cast<Uint32>(static_cast<Uint8>(bytes[0])) << 8
+				| static_cast<Uint32>(static_cast<Uint8>(bytes[1])) << 16 | static_cast<Uint32>(static_cast<Uint8>(bytes[2])) << 24);
+			samples[i] = (value >> 8) / 8388608.f;
+		}
+	}
+	return frames;
+}
+
+bool WavReader::rewind()
+{
+	if (!file.is_open()) return false;
+	file.clear();
+	file.seekg(dataStart);
+	framesLeft = frameCount;
+	return static_cast<bool>(file);
+}
+
+bool WavReader::isOpen() const
+{
+	return file.is_open() && channels > 0;
+}
+
+int WavReader::getChannels() const
+{
+	return channels;
+}
+
+int WavReader::getSampleRate() const
+{
+	return sampleRate;
+}
+
+Sint64 WavReader::getFrameCount() const
+{
+	return frameCount;
+}
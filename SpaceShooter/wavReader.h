@@ -0,0 +1,38 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include <SDL.h>
+
+/// <summary>
+/// Reads the samples of a WAV file (16/24-bit PCM or 32-bit float) a block at a time,
+/// so only the block that's being read is ever in memory, however long the file is.
+/// Samples are converted to interleaved floats (-1 - 1).
+/// </summary>
+struct WavReader
+{
+private:
+	std::ifstream file;
+	std::vector<char> raw; // one block of the file
+	std::streamoff dataStart = 0;
+	Sint64 frameCount = 0;
+	Sint64 framesLeft = 0;
+	int channels = 0;
+	int sampleRate = 0;
+	int bytesPerSample = 0;
+	bool isFloat = false;
+
+public:
+	// Prints why it failed
+	bool open(const std::string& path);
+	void close();
+	// Reads up to <maxFrames> frames into <samples> (maxFrames * channels floats), returns how many were read
+	int read(float* samples, int maxFrames);
+	// Goes back to the first frame
+	bool rewind();
+
+	bool isOpen() const;
+	int getChannels() const;
+	int getSampleRate() const;
+	Sint64 getFrameCount() const;
+};
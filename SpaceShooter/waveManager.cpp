@@ -1,24 +1,78 @@
 #include "waveManager.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
 #include "engine.h"
 #include "player.h"
 
-using namespace Engine;
 
-void WaveManager::initialize(MusicManager* musicManager, int starCount)
+// Used if the wave file is missing or broken
+const Wave defaultWaves[] = {
+	Wave(4, 2, 8),
+	Wave(2, 4, 8),
+	Wave(2, 4, 16),
+	Wave(2, 8, 25),
+	Wave(2, 2, 2),
+	Wave(1, 4, 16)
+};
+
+WaveManager::WaveManager(World* world, MusicManager* musicManager, const char* wavesPath) : world(world), musicManager(musicManager)
+{
+	if (!loadWaves(wavesPath))
+	{
+		std::cout << "Failed to load waves at: " << wavesPath << ", using default waves" << std::endl;
+		waves.assign(std::begin(defaultWaves), std::end(defaultWaves));
+	}
+}
+
+// Reads a wave table, one wave per line. Empty lines and lines starting with # are ignored
+bool WaveManager::loadWaves(const char* path)
 {
-	WaveManager::musicManager = musicManager;
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	std::vector<Wave> loadedWaves;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+
+		std::istringstream stream(line);
+		Wave wave{};
+		if (!(stream >> wave.quarterNoteInterval >> wave.totalSpawns >> wave.delayUntilNextWave))
+		{
+			std::cout << "Invalid wave in " << path << ": " << line << std::endl;
+			return false;
+		}
+		if (!(stream >> wave.asteroidsPerSpawn))
+			wave.asteroidsPerSpawn = 1;
+
+		if (wave.quarterNoteInterval < 1 || wave.totalSpawns < 1 || wave.asteroidsPerSpawn < 1)
+		{
+			std::cout << "Invalid wave in " << path << ": " << line << std::endl;
+			return false;
+		}
+		loadedWaves.push_back(wave);
+	}
+	if (loadedWaves.empty()) return false;
+
+	waves = loadedWaves;
+	return true;
+}
 
+void WaveManager::initialize(int starCount)
+{
 	for (int i = 0; i < starCount; i++)
 	{
-		WaveManager::spawnStar();
+		spawnStar();
 	}
 }
 void WaveManager::pause()
 {
 	if (musicManager != nullptr)
 	{
-		musicManager->onQuarterNote -= &WaveManager::onQuarterNote;
-		musicManager->onQuarterNote -= &WaveManager::spawnStar;
+		musicManager->onQuarterNote.unsubscribe(this);
 	}
 
 	activated = false;
@@ -46,8 +100,8 @@ void WaveManager::start()
 {
 	if (musicManager != nullptr)
 	{
-		musicManager->onQuarterNote += &WaveManager::onQuarterNote;
-		musicManager->onQuarterNote += &WaveManager::spawnStar;
+		musicManager->onQuarterNote.subscribe(this, [this] { onQuarterNote(); });
+		musicManager->onQuarterNote.subscribe(this, [this] { spawnStar(); });
 	}
 	quarterNoteCount = 0;
 }
@@ -56,20 +110,29 @@ void WaveManager::onQuarterNote()
 {
 	if (!activated)
 	{
-		if (waitingForLevelChange && Engine::getObjectCount() <= 1)
+		if (musicManager == nullptr)
 		{
-			musicManager->changeBeat();
+			// nothing to synch with, so just continue with the next level
 			waitingForLevelChange = false;
-			return;
+			activated = true;
 		}
-		if (musicManager->data->currentQuarterNote == 2 && !waitingForLevelChange && !MusicManager::isTransitioning)
+		else
 		{
-			activated = true;
+			if (waitingForLevelChange && world->getObjectCount() <= 1)
+			{
+				musicManager->changeBeat();
+				waitingForLevelChange = false;
+				return;
+			}
+			if (musicManager->data->currentQuarterNote == 2 && !waitingForLevelChange && !MusicManager::isTransitioning)
+			{
+				activated = true;
+			}
+			else return;
 		}
-		else return;
 	}
 	quarterNoteCount++;
-	if (waves[waveIndex].spawnCount == 0 && quarterNoteCount == 1 && musicManager->data->currentQuarterNote == 2)
+	if (waves[waveIndex].spawnCount == 0 && quarterNoteCount == 1 && getCurrentQuarterNote() == 2)
 	{
 		spawnAsteroid();
 		waves[waveIndex].spawnCount++;
@@ -86,7 +149,7 @@ void WaveManager::onQuarterNote()
 		{
 			quarterNoteCount = -waves[waveIndex].delayUntilNextWave + 1;
 			waveIndex++;
-			if (waveIndex > std::size(waves)/*sizeof(waves) / sizeof(waves[0]) - 1*/)
+			if (waveIndex >= static_cast<int>(waves.size()))
 			{
 				level++;
 
@@ -100,7 +163,21 @@ void WaveManager::onQuarterNote()
 	}
 }
 
+int WaveManager::getCurrentQuarterNote() const
+{
+	// headless simulations act as if every quarter note is the second one, which is where waves start
+	return musicManager != nullptr ? musicManager->data->currentQuarterNote : 2;
+}
+
 void WaveManager::spawnAsteroid()
+{
+	for (int i = 0; i < waves[waveIndex].asteroidsPerSpawn; i++)
+	{
+		createAsteroid();
+	}
+}
+
+void WaveManager::createAsteroid()
 {
 	const bool forceBigSpawn = waves[waveIndex].spawnCount == waves[waveIndex].totalSpawns &&
 		!waves[waveIndex].bigRockHasBeenSpawned && waveIndex > 1;
@@ -125,7 +202,7 @@ void WaveManager::spawnAsteroid()
 	const Position pos(static_cast<float>(x), static_cast<float>(rand() % 150 + 50), size);
 	const Rotation rot(static_cast<float>(randomTorque), static_cast<float>(randomAngle));
 	const Velocity vel(static_cast<float>(xVelocity), static_cast<float>(yVelocity));
-	Engine::createObject(pos, rot, vel);
+	world->createObject(pos, rot, vel);
 }
 
 void WaveManager::spawnStar()
@@ -140,7 +217,7 @@ void WaveManager::spawnStar()
 			const float randomY = static_cast<float>(rand() % HEIGHT -heightLimit);
 			const float maxSize = 1 + static_cast<float>(rand() % 100) * 0.01f;
 			const float randAlpha = static_cast<float>(rand() % 200);
-			Engine::createStar(randomX, randomY, maxSize, Color(randAlpha, 225.f, 255.f, randAlpha), 10);
+			world->createStar(randomX, randomY, maxSize, Color(randAlpha, 225.f, 255.f, randAlpha), 10);
 			if (randomY > HEIGHT - 150) heightLimit = 150;
 		}
 		return;
@@ -160,7 +237,7 @@ void WaveManager::spawnStar()
 		const float randomY = static_cast<float>(rand() % (HEIGHT-150) + 50);
 		const float maxSize = 1 + static_cast<float>(rand() % 300) * 0.01f;
 		const int lifeTime = rand() % 4 + 1;
-		Engine::createStar(randomX, randomY, maxSize, color, lifeTime);
+		world->createStar(randomX, randomY, maxSize, color, lifeTime);
 	}
 }
 
@@ -1,50 +1,53 @@
 #pragma once
+#include <vector>
 #include "musicManager.h"
-#define WAVECOUNT 6
+#include "game.h"
 
 struct Wave
 {
 	int quarterNoteInterval; // how many quarter notes between spawns
 	int totalSpawns;
 	int delayUntilNextWave; // how many quarter notes until next wave begins
-	int spawnCount;
-	bool bigRockHasBeenSpawned;
+	int asteroidsPerSpawn = 1; // only above 1 in stress profiles
+	int spawnCount = 0;
+	bool bigRockHasBeenSpawned = false;
 };
 /// <summary>
 /// This handles the spawning of asteroids, in synch with music.
-/// 
-/// Everything being static is a workaround to make the function
-/// "onQuarterNote()" work with a custom delegate (see musicManager.h onQuarterNote).
 ///
-///	If I had more time, I'd try to make the delegate work with non-static methods
+/// Each instance is bound to a World and owns its own wave table and progress,
+/// so several simulations can run in the same process. The wave table is loaded
+/// from a wave file (see Content/Waves/), where each line is:
+///	quarterNoteInterval totalSpawns delayUntilNextWave [asteroidsPerSpawn]
+///
+/// Without a MusicManager (headless simulations) the waves advance
+/// every time onQuarterNote() is called, without waiting for the music.
 /// </summary>
 struct WaveManager
 {
 private:
-	inline static int waveIndex;
-	inline static int level;
-	inline static int quarterNoteCount;
-	inline static bool activated;
-	inline static bool waitingForLevelChange;
-	inline static Wave waves[WAVECOUNT] = {
-		Wave(4, 2, 8),
-		Wave(2, 4, 8),
-		Wave(2, 4, 16),
-		Wave(2, 8, 25),
-		Wave(2, 2, 2),
-		Wave(1, 4, 16)
-	};
-	inline static MusicManager* musicManager;
+	int waveIndex = 0;
+	int level = 0; // restart() sets it to 1, the first game starts out slower
+	int quarterNoteCount = 0;
+	bool activated = false;
+	bool waitingForLevelChange = false;
+	std::vector<Wave> waves;
+	World* world;
+	MusicManager* musicManager;
 
 public:
-	static void initialize(MusicManager* musicManager, int starCount);
-	static void start();
-	static void pause();
-	static void restart();
-	static void spawnStar();
+	WaveManager(World* world, MusicManager* musicManager, const char* wavesPath);
+	bool loadWaves(const char* path);
+	void initialize(int starCount);
+	void start();
+	void pause();
+	void restart();
+	void spawnStar();
+	void onQuarterNote();
 
 private:
-	static void spawnAsteroid();
-	static void onQuarterNote();
-	static void resetWaves();
-};
\ No newline at end of file
+	void spawnAsteroid();
+	void createAsteroid();
+	void resetWaves();
+	int getCurrentQuarterNote() const;
+};